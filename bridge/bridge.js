@@ -3,23 +3,34 @@ const WebSocket = require("ws");
 
 const ENGINE_HOST = "127.0.0.1";
 const ENGINE_PORT = 9001;
+// Optional AF_UNIX stream path (same framing as TCP) when the engine runs locally.
+const ENGINE_SOCKET = process.env.ENGINE_SOCKET || "";
 const WS_PORT = 8080;
 
 let engineSocket = null;
 let engineBuffer = Buffer.alloc(0);
 let wsClients = new Set();
+// Partial PNL_HISTORY / LOTS replies (split into several frames) by request key.
+let pendingHistory = new Map();
+let pendingLots = new Map();
 
 /**
- * Connect to the C++ engine over TCP and set up framed message handling.
+ * Connect to the C++ engine over TCP (or a unix socket if ENGINE_SOCKET is set)
+ * and set up framed message handling.
  * Reconnects automatically on close with a short delay.
  */
 function connectEngine() {
   if (engineSocket) return;
 
-  console.log(`[bridge] Connecting to engine ${ENGINE_HOST}:${ENGINE_PORT}...`);
+  const target = ENGINE_SOCKET
+    ? { path: ENGINE_SOCKET }
+    : { host: ENGINE_HOST, port: ENGINE_PORT };
+  const label = ENGINE_SOCKET ? `unix:${ENGINE_SOCKET}` : `${ENGINE_HOST}:${ENGINE_PORT}`;
+
+  console.log(`[bridge] Connecting to engine ${label}...`);
 
   engineSocket = net.createConnection(
-    { host: ENGINE_HOST, port: ENGINE_PORT },
+    target,
     () => console.log("[bridge] Connected to engine.")
   );
 
@@ -64,7 +75,8 @@ function processEngineBuffer() {
 /**
  * Decode a single engine payload and broadcast normalized JSON over WebSocket.
  * Supported frame types:
- * 3: trade, 4: ack, 5: top of book, 6: L2 update, 7: PnL update
+ * 3: trade, 4: ack, 5: top of book, 6: L2 update, 7: PnL update, 12: depth update,
+ * 15: closed OHLCV bar
  * @param {Buffer} payload - raw payload without length prefix
  */
 function handleEngineMessage(payload) {
@@ -83,9 +95,11 @@ function handleEngineMessage(payload) {
     const sell_user_id  = Number(payload.readBigUInt64BE(offset)); offset += 8;
     const price         = payload.readDoubleBE(offset); offset += 8;
     const quantity      = Number(payload.readBigUInt64BE(offset)); offset += 8;
+    const instrument_id = payload.length >= offset + 4 ? payload.readUInt32BE(offset) : 1;
 
     broadcastJSON({
       type: "trade",
+      instrument_id,
       trade_id,
       buy_order_id,
       sell_order_id,
@@ -121,10 +135,13 @@ function handleEngineMessage(payload) {
     const bidPrice = payload.readDoubleBE(offset); offset += 8;
     const bidQty   = Number(payload.readBigUInt64BE(offset)); offset += 8;
     const askPrice = payload.readDoubleBE(offset); offset += 8;
-    const askQty   = Number(payload.readBigUInt64BE(offset));
+    const askQty   = Number(payload.readBigUInt64BE(offset)); offset += 8;
+    // instrument id was appended later; older engines omit it
+    const instrument_id = payload.length >= offset + 4 ? payload.readUInt32BE(offset) : 1;
 
     broadcastJSON({
       type: "tob",
+      instrument_id,
       bidPrice,
       bidQty,
       askPrice,
@@ -150,6 +167,178 @@ function handleEngineMessage(payload) {
     });
   }
 
+  // -------------------------
+  // DEPTH_UPDATE (type = 12)
+  // -------------------------
+  else if (type === 12) {
+    let offset = 1;
+
+    const instrument_id = payload.readUInt32BE(offset); offset += 4;
+    const side          = payload.readUInt8(offset); offset += 1;
+    const snapshot      = (payload.readUInt8(offset) & 1) === 1; offset += 1;
+    const count         = payload.readUInt16BE(offset); offset += 2;
+
+    const levels = [];
+    for (let i = 0; i < count; i++) {
+      const price    = payload.readDoubleBE(offset); offset += 8;
+      const quantity = Number(payload.readBigUInt64BE(offset)); offset += 8;
+      levels.push({ price, quantity });
+    }
+
+    broadcastJSON({
+      type: "depth",
+      instrument_id,
+      side,
+      snapshot,
+      levels
+    });
+  }
+
+  // -------------------------
+  // BAR (type = 15)
+  // -------------------------
+  else if (type === 15) {
+    let offset = 1;
+
+    const instrument_id = payload.readUInt32BE(offset); offset += 4;
+    const interval_ms   = payload.readUInt32BE(offset); offset += 4;
+    const start_ms      = Number(payload.readBigUInt64BE(offset)); offset += 8;
+    const open          = payload.readDoubleBE(offset); offset += 8;
+    const high          = payload.readDoubleBE(offset); offset += 8;
+    const low           = payload.readDoubleBE(offset); offset += 8;
+    const close         = payload.readDoubleBE(offset); offset += 8;
+    const volume        = Number(payload.readBigUInt64BE(offset)); offset += 8;
+    const trade_count   = payload.readUInt32BE(offset); offset += 4;
+    const vwap          = payload.readDoubleBE(offset); offset += 8;
+    const rolling_vwap  = payload.readDoubleBE(offset); offset += 8;
+    const realized_vol  = payload.readDoubleBE(offset);
+
+    broadcastJSON({
+      type: "bar",
+      instrument_id,
+      interval_ms,
+      start_ms,
+      open,
+      high,
+      low,
+      close,
+      volume,
+      trade_count,
+      vwap,
+      rolling_vwap,
+      realized_vol
+    });
+  }
+
+  // -------------------------
+  // RISK_UPDATE (type = 16)
+  // -------------------------
+  else if (type === 16) {
+    let offset = 1;
+
+    const user_id        = payload.readUInt32BE(offset); offset += 4;
+    const underlying_id  = payload.readUInt32BE(offset); offset += 4;
+    const underlying_mid = payload.readDoubleBE(offset); offset += 8;
+    const delta          = payload.readDoubleBE(offset); offset += 8;
+    const gamma          = payload.readDoubleBE(offset); offset += 8;
+    const vega           = payload.readDoubleBE(offset); offset += 8;
+    const theta          = payload.readDoubleBE(offset);
+
+    broadcastJSON({
+      type: "risk",
+      user_id,
+      underlying_id,
+      underlying_mid,
+      delta,
+      gamma,
+      vega,
+      theta
+    });
+  }
+
+  // -------------------------
+  // PNL_HISTORY (type = 18)
+  // -------------------------
+  else if (type === 18) {
+    let offset = 1;
+
+    const user_id       = payload.readUInt32BE(offset); offset += 4;
+    const instrument_id = payload.readUInt32BE(offset); offset += 4;
+    const tier          = payload.readUInt8(offset); offset += 1;
+    const bucket_ms     = payload.readUInt32BE(offset); offset += 4;
+    const more          = payload.readUInt8(offset); offset += 1;
+    const count         = payload.readUInt32BE(offset); offset += 4;
+
+    // large replies arrive in several frames; collect until more == 0
+    const key = `${user_id}:${instrument_id}:${tier}`;
+    const samples = pendingHistory.get(key) || [];
+    for (let i = 0; i < count; i++) {
+      const ts_ms      = Number(payload.readBigUInt64BE(offset)); offset += 8;
+      const equity_min = payload.readDoubleBE(offset); offset += 8;
+      const equity_max = payload.readDoubleBE(offset); offset += 8;
+      const equity     = payload.readDoubleBE(offset); offset += 8;
+      const realized   = payload.readDoubleBE(offset); offset += 8;
+      const position   = payload.readDoubleBE(offset); offset += 8;
+      samples.push({ ts_ms, equity_min, equity_max, equity, realized, position });
+    }
+    if (more) {
+      pendingHistory.set(key, samples);
+      return;
+    }
+    pendingHistory.delete(key);
+
+    broadcastJSON({
+      type: "pnl_history",
+      user_id,
+      instrument_id,
+      tier,
+      bucket_ms,
+      samples
+    });
+  }
+
+  // -------------------------
+  // LOTS (type = 20)
+  // -------------------------
+  else if (type === 20) {
+    let offset = 1;
+
+    const user_id       = payload.readUInt32BE(offset); offset += 4;
+    const instrument_id = payload.readUInt32BE(offset); offset += 4;
+    const more          = payload.readUInt8(offset); offset += 1;
+
+    const key = `${user_id}:${instrument_id}`;
+    const pending = pendingLots.get(key) || { open: [], closed: [] };
+    const readLots = (closed, lots) => {
+      const count = payload.readUInt32BE(offset); offset += 4;
+      for (let i = 0; i < count; i++) {
+        const quantity  = payload.readDoubleBE(offset); offset += 8;
+        const price     = payload.readDoubleBE(offset); offset += 8;
+        const realized  = payload.readDoubleBE(offset); offset += 8;
+        const open_seq  = Number(payload.readBigUInt64BE(offset)); offset += 8;
+        const lot = { quantity, price, realized, open_seq };
+        if (closed) { lot.close_seq = Number(payload.readBigUInt64BE(offset)); offset += 8; }
+        lots.push(lot);
+      }
+    };
+    readLots(false, pending.open);
+    readLots(true, pending.closed);
+    if (more) {
+      pendingLots.set(key, pending);
+      return;
+    }
+    pendingLots.delete(key);
+    const { open, closed } = pending;
+
+    broadcastJSON({
+      type: "lots",
+      user_id,
+      instrument_id,
+      open,
+      closed
+    });
+  }
+
   // -------------------------
   // PNL_UPDATE (type = 7)
   // -------------------------
@@ -162,11 +351,13 @@ function handleEngineMessage(payload) {
     // const position   = Number(payload.readBigUInt64BE(offset)); offset += 8;
     const position = payload.readDoubleBE(offset); offset += 8;
     const avg_price  = payload.readDoubleBE(offset); offset += 8;
-    const equity     = payload.readDoubleBE(offset);
+    const equity     = payload.readDoubleBE(offset); offset += 8;
+    const instrument_id = payload.length >= offset + 4 ? payload.readUInt32BE(offset) : 1;
 
     broadcastJSON({
       type: "pnl",
       user_id,
+      instrument_id,
       realized,
       unrealized,
       position,
@@ -195,12 +386,12 @@ function broadcastJSON(obj) {
 // ------------------------------------------------------------
 /**
  * Send a NEW_ORDER frame to the engine.
- * @param {{user_id:number, side:0|1, price:number, quantity:number}} param0
+ * @param {{user_id:number, side:0|1, price:number, quantity:number, instrument_id:number}} param0
  */
-function sendNewOrderToEngine({ user_id, side, price, quantity }) {
+function sendNewOrderToEngine({ user_id, side, price, quantity, instrument_id }) {
   if (!engineSocket) return;
 
-  const payload = Buffer.alloc(1 + 8 + 1 + 8 + 8);
+  const payload = Buffer.alloc(1 + 8 + 1 + 8 + 8 + 4);
   let offset = 0;
 
   payload.writeUInt8(1, offset); offset += 1;               // NEW_ORDER
@@ -208,6 +399,7 @@ function sendNewOrderToEngine({ user_id, side, price, quantity }) {
   payload.writeUInt8(side, offset); offset += 1;
   payload.writeDoubleBE(price, offset); offset += 8;
   payload.writeBigUInt64BE(BigInt(quantity), offset); offset += 8;
+  payload.writeUInt32BE(instrument_id, offset); offset += 4;
 
   const frame = Buffer.alloc(4 + payload.length);
   frame.writeUInt32BE(payload.length, 0);
@@ -234,6 +426,51 @@ function sendCancelToEngine({ order_id }) {
   engineSocket.write(frame);
 }
 
+/**
+ * Ask the engine for one tier of a user's PnL history (reply: PNL_HISTORY).
+ * instrument_id 0xFFFFFFFF selects the user's totals across instruments.
+ * @param {{user_id:number, instrument_id:number, tier:number, since_ms:number}} param0
+ */
+function sendPnlHistoryRequestToEngine({ user_id, instrument_id, tier, since_ms }) {
+  if (!engineSocket) return;
+
+  const payload = Buffer.alloc(1 + 4 + 4 + 1 + 8);
+  let offset = 0;
+
+  payload.writeUInt8(17, offset); offset += 1;              // PNL_HISTORY_REQUEST
+  payload.writeUInt32BE(user_id, offset); offset += 4;
+  payload.writeUInt32BE(instrument_id, offset); offset += 4;
+  payload.writeUInt8(tier, offset); offset += 1;
+  payload.writeBigUInt64BE(BigInt(since_ms), offset); offset += 8;
+
+  const frame = Buffer.alloc(4 + payload.length);
+  frame.writeUInt32BE(payload.length, 0);
+  payload.copy(frame, 4);
+
+  engineSocket.write(frame);
+}
+
+/**
+ * Ask the engine for a user's FIFO lots in one instrument (reply: LOTS).
+ * @param {{user_id:number, instrument_id:number}} param0
+ */
+function sendLotsRequestToEngine({ user_id, instrument_id }) {
+  if (!engineSocket) return;
+
+  const payload = Buffer.alloc(1 + 4 + 4);
+  let offset = 0;
+
+  payload.writeUInt8(19, offset); offset += 1;              // LOTS_REQUEST
+  payload.writeUInt32BE(user_id, offset); offset += 4;
+  payload.writeUInt32BE(instrument_id, offset); offset += 4;
+
+  const frame = Buffer.alloc(4 + payload.length);
+  frame.writeUInt32BE(payload.length, 0);
+  payload.copy(frame, 4);
+
+  engineSocket.write(frame);
+}
+
 // ------------------------------------------------------------
 // Boot
 // ------------------------------------------------------------
@@ -258,13 +495,30 @@ wss.on("connection", (ws) => {
         user_id: data.user_id ?? 1,
         side: data.side === "buy" ? 0 : 1,
         price: Number(data.price),
-        quantity: Number(data.quantity)
+        quantity: Number(data.quantity),
+        instrument_id: Number(data.instrument_id ?? 1)
       });
     }
 
     if (data.type === "cancel") {
       sendCancelToEngine({ order_id: Number(data.order_id) });
     }
+
+    if (data.type === "pnl_history_request") {
+      sendPnlHistoryRequestToEngine({
+        user_id: Number(data.user_id ?? 1),
+        instrument_id: Number(data.instrument_id ?? 0xFFFFFFFF),
+        tier: Number(data.tier ?? 0),
+        since_ms: Number(data.since_ms ?? 0)
+      });
+    }
+
+    if (data.type === "lots_request") {
+      sendLotsRequestToEngine({
+        user_id: Number(data.user_id ?? 1),
+        instrument_id: Number(data.instrument_id ?? 1)
+      });
+    }
   });
 
   ws.on("close", () => wsClients.delete(ws));
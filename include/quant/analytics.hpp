@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "quant/messages.hpp"
+
+namespace quant {
+
+// TradeAnalytics
+//
+// Incremental trade analytics for one instrument, run on the engine thread:
+//  - OHLCV bars for several intervals (default 1s / 5s / 1m), aligned to wall-clock
+//    boundaries; closed bars are reported as BarUpdate records
+//  - rolling VWAP and realized volatility over a sliding window, kept in a ring of
+//    per-second buckets with running totals
+// on_trade() is O(#intervals) = O(1); roll() evicts at most one bucket per elapsed second.
+class TradeAnalytics {
+public:
+    explicit TradeAnalytics(uint32_t instrument_id = 0,
+                            std::vector<uint32_t> intervals_ms = {1000, 5000, 60000},
+                            uint32_t window_s = 60);
+
+    // Fold one trade into the open bars and the rolling window. now_ns is wall-clock time;
+    // call roll() with the same clock first so expired bars close before the trade lands.
+    void on_trade(double price, uint64_t qty, uint64_t now_ns);
+
+    // Close every bar whose interval has ended by now_ns, appending one BarUpdate per
+    // non-empty bar to `out`. Intervals with no trades produce no bar.
+    void roll(uint64_t now_ns, std::vector<BarUpdate>& out);
+
+    // Rolling VWAP over the window (0 if no volume).
+    double rolling_vwap() const;
+    // Annualized realized volatility from trade-to-trade log returns in the window.
+    double realized_vol() const;
+
+private:
+    struct Bar {
+        uint64_t start_ms = 0;
+        double   open = 0, high = 0, low = 0, close = 0;
+        double   notional = 0;
+        uint64_t volume = 0;
+        uint32_t trades = 0;
+    };
+
+    // Per-second slot of the rolling window.
+    struct Bucket {
+        uint64_t second = 0;
+        double   notional = 0;
+        double   volume = 0;
+        double   sum_r2 = 0;
+    };
+
+    // Evict buckets older than the window and make `second` the current slot.
+    void advance(uint64_t second);
+
+    uint32_t instrument_id_;
+    std::vector<uint32_t> intervals_ms_;
+    std::vector<Bar> bars_;             // one open bar per interval
+
+    uint32_t window_s_;
+    std::vector<Bucket> ring_;          // window_s_ slots indexed by second % window_s_
+    uint64_t cur_second_ = 0;
+    double tot_notional_ = 0;
+    double tot_volume_ = 0;
+    double tot_r2_ = 0;
+
+    double last_price_ = 0;
+};
+
+} // namespace quant
@@ -1,5 +1,7 @@
 #pragma once
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 
 /*
  Black–Scholes utilities:
@@ -13,6 +15,9 @@ namespace quant {
     double norm_cdf(double x);
     // Standard normal probability density function φ(x)
     double norm_pdf(double x);
+    // Inverse of Φ for p in (0, 1): Acklam's rational approximation refined by one
+    // Halley step (full double accuracy). Used to map QMC uniforms to normals.
+    double norm_inv_cdf(double p);
 
     // Inputs for Black–Scholes closed-form. Units: r, sigma annualized; T in years.
     struct BSInputs {
@@ -39,4 +44,19 @@ namespace quant {
     double put_delta(const BSInputs& in);
     double put_theta(const BSInputs& in);
     double put_rho(const BSInputs& in);
+
+    // Greeks of one option; vega per unit of sigma, theta per year.
+    struct BSGreeks {
+        double delta;
+        double gamma;
+        double vega;
+        double theta;
+    };
+
+    // Greeks for n options on one underlying at spot S, from structure-of-arrays inputs.
+    // d1/d2 and the normal terms are computed once per option in a single branch-light pass.
+    // Expired options (T <= 0) or sigma <= 0 get intrinsic delta and zero gamma/vega/theta.
+    void bs_greeks_batch(double S, const double* r, const double* K, const double* sigma,
+                         const double* T, const uint8_t* is_call, std::size_t n,
+                         BSGreeks* out);
 }
@@ -0,0 +1,41 @@
+#pragma once
+
+// Runtime CPU feature checks for kernels compiled with per-function target attributes.
+// Builds stay baseline x86-64 (or non-x86); wider paths are chosen at run time.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QUANT_X86_DISPATCH 1
+#else
+#define QUANT_X86_DISPATCH 0
+#endif
+
+namespace quant {
+    // AVX2 available (and usable by the OS).
+    inline bool cpu_has_avx2() {
+#if QUANT_X86_DISPATCH
+        static const bool has = __builtin_cpu_supports("avx2");
+        return has;
+#else
+        return false;
+#endif
+    }
+
+    // AVX2 + FMA3 available.
+    inline bool cpu_has_avx2_fma() {
+#if QUANT_X86_DISPATCH
+        static const bool has = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        return has;
+#else
+        return false;
+#endif
+    }
+
+    // AVX-512 Foundation available.
+    inline bool cpu_has_avx512f() {
+#if QUANT_X86_DISPATCH
+        static const bool has = __builtin_cpu_supports("avx512f");
+        return has;
+#else
+        return false;
+#endif
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
-#include <random>
+#include <vector>
 #include <cstdint>
+#include "quant/rng.hpp"
 using namespace std;
 
 namespace quant{
@@ -10,6 +11,8 @@ namespace quant{
     //   dS = mu * S * dt + sigma * S * dW
     // Discretized via log-Euler to preserve positivity. Exposes terminal
     // sampling, full path generation, and RNG reseeding for reproducibility.
+    // Draws come from a counter-based generator: each sample/path consumes the next
+    // draw index, and step i of a path uses dimension i of that index.
     class GBM{
         public:
             GBM(double S0, double mu, double sigma, uint64_t seed = 0);
@@ -26,7 +29,7 @@ namespace quant{
             double mu_;
             double sigma_;
             uint64_t seed_;
-            normal_distribution<double> nd_;
-            mt19937_64 rng_;
+            CounterRNG rng_;
+            uint64_t next_draw_ = 0;
     };
 }
\ No newline at end of file
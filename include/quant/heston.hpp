@@ -0,0 +1,67 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "quant/rng.hpp"
+
+namespace quant {
+    // Heston stochastic volatility:
+    //   dS = mu S dt + sqrt(v) S dW_S
+    //   dv = kappa (theta - v) dt + xi sqrt(v) dW_v,   d<W_S, W_v> = rho dt
+    struct HestonParams {
+        double v0 = 0.04;      // initial variance
+        double kappa = 1.5;    // mean-reversion speed
+        double theta = 0.04;   // long-run variance
+        double xi = 0.5;       // vol of variance
+        double rho = -0.7;     // spot/variance correlation
+    };
+
+    // Andersen's quadratic-exponential (QE) step for a fixed dt. The variance is matched
+    // by a squared Gaussian (psi <= 1.5) or a point mass at 0 plus an exponential tail;
+    // ln S uses the central (gamma1 = gamma2 = 1/2) integrated-variance discretisation.
+    // Both take standard normals: zv drives the variance, z the independent part of ln S
+    // (the exponential branch maps zv to a uniform through the normal CDF, so antithetic
+    // and QMC draws carry over). heston_qe_block (mc_kernel.hpp) is the SIMD version.
+    struct HestonQEStep {
+        HestonQEStep(const HestonParams& p, double mu, double dt);
+
+        // Advance x = ln(S / S0) and variance v by one step.
+        void step(double& x, double& v, double zv, double z) const;
+        // Variance of the quadratic branch (0 < psi <= 1.5) for conditional mean m.
+        static double quadratic_variance(double m, double psi, double zv);
+        // Variance of the exponential branch (psi > 1.5) for conditional mean m.
+        static double exponential_variance(double m, double psi, double zv);
+
+        double theta, xi;
+        double e_kdt;                 // exp(-kappa dt)
+        double c1, c2;                // s^2 = v c1 + c2
+        double k0, k1, k2, k3, k4;    // ln S coefficients (drift folded into k0)
+    };
+
+    // HestonProcess
+    //
+    // Single Heston path advanced step by step, e.g. as the price driver of
+    // MarketSimulator. Step i uses CounterRNG draws (i, 0) and (i, 1), so a seed fixes
+    // the path; dt may change between calls (the QE constants are cached per dt).
+    class HestonProcess {
+    public:
+        HestonProcess(double S0, double mu, const HestonParams& p, uint64_t seed = 0);
+
+        // Advance by dt (same time units as mu, kappa) and return the new spot.
+        double step(double dt);
+        double spot() const { return S0_ * std::exp(x_); }
+        double variance() const { return v_; }
+        // Restart from S0 / v0 with a new seed.
+        void reseed(uint64_t seed);
+
+    private:
+        double S0_;
+        double mu_;
+        HestonParams p_;
+        CounterRNG rng_;
+        double x_ = 0.0;
+        double v_;
+        uint64_t n_steps_ = 0;
+        double dt_ = 0.0;
+        HestonQEStep qe_;
+    };
+}
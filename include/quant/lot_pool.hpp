@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+namespace quant {
+
+// One open FIFO lot of a position; lots of a position form a singly linked queue.
+struct PoolLot {
+    double   quantity;   // remaining open quantity (unsigned; side comes from the position)
+    double   opened;     // quantity the lot was opened with
+    double   price;      // opening price
+    double   realized;   // PnL realized so far by partial closes of this lot
+    uint64_t trade_seq;  // engine-wide sequence of the opening fill
+
+    uint32_t next = UINT32_MAX;
+
+    bool active = false;
+};
+
+// Index-based lot arena in the style of OrderPool. Unlike the order pool it grows
+// (doubling) when exhausted, so the free list keeps allocation O(1) amortised and
+// steady-state fills reuse released nodes without touching the heap.
+class LotPool {
+public:
+    explicit LotPool(uint32_t capacity)
+    {
+        grow(capacity == 0 ? 1 : capacity);
+    }
+
+    uint32_t allocate() {
+        if (free_list_.empty()) grow(static_cast<uint32_t>(storage_.size()));
+        uint32_t idx = free_list_.back();
+        free_list_.pop_back();
+        storage_[idx].active = true;
+        storage_[idx].next = UINT32_MAX;
+        return idx;
+    }
+
+    void release(uint32_t idx) {
+        storage_[idx].active = false;
+        storage_[idx].next = UINT32_MAX;
+        free_list_.push_back(idx);
+    }
+
+    PoolLot& operator[](uint32_t idx)             { return storage_[idx]; }
+    const PoolLot& operator[](uint32_t idx) const { return storage_[idx]; }
+
+    bool is_active(uint32_t idx) const { return storage_[idx].active; }
+    uint32_t capacity() const { return static_cast<uint32_t>(storage_.size()); }
+
+private:
+    // Append `extra` nodes; the free list is refilled so low indices are handed out first.
+    void grow(uint32_t extra) {
+        uint32_t old = static_cast<uint32_t>(storage_.size());
+        storage_.resize(old + extra);
+        free_list_.reserve(storage_.size());
+        for (uint32_t i = old + extra; i > old; --i)
+            free_list_.push_back(i - 1);
+    }
+
+    std::vector<PoolLot>  storage_;
+    std::vector<uint32_t> free_list_;
+};
+
+} // namespace quant
@@ -1,7 +1,9 @@
 #pragma once
 #include <atomic>
+#include <memory>
 #include <thread>
 #include <random>
+#include "quant/heston.hpp"
 #include "quant/server.hpp"
 #include "quant/messages.hpp"
 
@@ -19,11 +21,16 @@ public:
                     double mu          = 0.2,    // drift (annualized-ish, not super important here)
                     double sigma       = 0.2,    // vol
                     double dt_seconds  = 0.2,    // simulation step
-                    double tick_size   = 0.01);
+                    double tick_size   = 0.01,
+                    uint32_t instrument_id = DEFAULT_INSTRUMENT_ID);
 
     // Stop thread on destruction if still running (RAII safety).
     ~MarketSimulator();
 
+    // Drive the price with a Heston process (drift mu) instead of the default
+    // mean-reverting log process; call before start(). seed 0 uses the clock.
+    void use_heston(const HestonParams& params, uint64_t seed = 0);
+
     // Spawn worker thread and begin event loop.
     void start();
     // Signal loop to stop and join worker thread.
@@ -36,6 +43,7 @@ private:
     void send_limit_order(uint8_t side, double price, uint64_t qty);
 
     MatchingServer* engine_;
+    uint32_t instrument_id_;    // book the synthetic flow is sent to
     std::atomic<bool> running_;
     std::thread thread_;
 
@@ -50,6 +58,9 @@ private:
     double drift_term_;
     double vol_term_;
 
+    // Optional stochastic-volatility price driver (see use_heston)
+    std::unique_ptr<HestonProcess> heston_;
+
     // RNG: mt19937_64 for reproducibility; normal for shocks; uniform for order sizes
     std::mt19937_64 rng_;
     std::normal_distribution<double> norm_;
@@ -1,18 +1,67 @@
 #pragma once
 #include <cstdint>
 #include <cstddef>
+#include <functional>
 #include <tuple>
+#include <vector>
+#include "quant/moments.hpp"
 
 namespace quant {
+    // Arithmetic of the terminal payoff kernel (see MCOptions::precision).
+    enum class MCPrecision { Double, Single };
+
     // MCOptions: configuration for Monte Carlo pricing.
-    // r is risk-free rate (annualized); seed controls RNG reproducibility; n_threads = 0 uses hardware_concurrency.
+    // r is risk-free rate (annualized); seed controls RNG reproducibility; paths run as chunks on
+    // ThreadPool::global(), at most n_threads at a time (0 => the whole pool, 1 => the calling
+    // thread only).
+    //
+    // Determinism: draws are split into fixed-size chunks, chunk c always covers the same
+    // counter-RNG draw indices, and chunk results merge in chunk order. For a non-zero
+    // seed, every engine returns bit-identical results whatever the thread count or pool
+    // size, on the same build and SIMD kernel (see terminal_kernel_isa). Only seed == 0
+    // (clock seed) and time_budget_ms runs can vary between calls.
     struct MCOptions {
         std::size_t n_paths = 1000000;   // total number of Monte-Carlo paths
-        std::size_t n_threads = 0;       // 0 => use hardware_concurrency
+        std::size_t n_threads = 0;       // max chunks in flight; 0 => whole pool, 1 => caller only
         bool use_antithetic = true;      // use antithetic variates
         bool use_control_variate = true; // use S_T as control variate
         uint64_t seed = 0;
         double r = 0.0;
+        // Randomised QMC (monte_carlo_terminal, monte_carlo_path): scrambled Sobol points
+        // split over qmc_scrambles independent scramblings; stderr/CI come from the spread
+        // of their estimates. Antithetic pairing is not applied. Works best when
+        // n_paths / qmc_scrambles is a power of two.
+        bool use_qmc = false;
+        std::size_t qmc_scrambles = 16;
+        // Also estimate Greeks in the same pass (monte_carlo_terminal): pathwise delta,
+        // vega and rho, and gamma by a likelihood-ratio weight on the pathwise delta.
+        bool compute_greeks = false;
+        // Adaptive precision (monte_carlo_terminal, monte_carlo_path; pseudo-random only):
+        // with any of these set, paths run in growing batches and stop once stderr_ <=
+        // target_stderr or ci_high - ci_low <= target_ci_width, or once time_budget_ms is
+        // spent. n_paths is then the cap and MCResult::n_samples the paths actually used.
+        double target_stderr = 0.0;      // 0 => no stderr target
+        double target_ci_width = 0.0;    // 0 => no CI-width target
+        double time_budget_ms = 0.0;     // 0 => no time limit
+        // Single (monte_carlo_terminal): S_T and the payoff in float, about twice the
+        // kernel throughput. Pseudo-random normals are stored as float (half the bytes
+        // the kernel streams), but Box-Muller still runs in double and Sobol draws are
+        // narrowed after generation, so generation cost is unchanged. Moment merges stay
+        // double; the price moves by ~1e-7 relative, far below the Monte Carlo error.
+        // Greeks are computed in double from the same rounded draws.
+        MCPrecision precision = MCPrecision::Double;
+    };
+
+    // Greeks per unit of spot / sigma / r, each with its Monte Carlo standard error.
+    struct MCGreeks {
+        double delta = 0.0;
+        double gamma = 0.0;
+        double vega = 0.0;
+        double rho = 0.0;
+        double delta_se = 0.0;
+        double gamma_se = 0.0;
+        double vega_se = 0.0;
+        double rho_se = 0.0;
     };
 
     // Result: estimated price, standard error, 95% CI [low,high], samples used (normal approximation)
@@ -22,6 +71,8 @@ namespace quant {
         double ci_low;       
         double ci_high;      
         std::size_t n_samples;
+        bool has_greeks = false; // greeks is filled when MCOptions.compute_greeks was set
+        MCGreeks greeks;
     };
 
     // Monte Carlo function for European call/put with terminal-only payoff (vanilla).
@@ -36,4 +87,47 @@ namespace quant {
         bool is_call,
         double (*bs_price_fn)(double S, double K, double r, double sigma, double T) = nullptr
     );
-}
\ No newline at end of file
+
+    // One instrument of a strip: European payoff max(+-(S_T - K), 0) at maturity T (years).
+    struct MCStripOption {
+        double K;
+        double T;
+        bool is_call;
+    };
+
+    // Price a whole strip (strikes x maturities x call/put) from one shared set of draws.
+    // Each distinct maturity's terminal prices are computed once per block and every
+    // payoff on that maturity is evaluated against them, so a chain costs about one
+    // simulation plus a cheap vector pass per instrument. Results are in input order;
+    // each uses S_T as control variate when opts.use_control_variate is set.
+    std::vector<MCResult> monte_carlo_strip(
+        double S0,
+        double sigma,
+        const std::vector<MCStripOption>& options,
+        const MCOptions& opts
+    );
+
+    // Helpers shared by the MC engines.
+    // Seed to use for a run: seed itself, or a clock-derived one when seed == 0.
+    uint64_t mc_resolve_seed(uint64_t seed);
+    // Price, stderr and CI from the (Y, X = S_T) moments of one instrument, with the
+    // optimal control-variate coefficient when use_cv. EX = E[S_T] under the
+    // risk-neutral measure; disc discounts the undiscounted payoff mean.
+    MCResult mc_result_from_moments(const PairMoments& total, double EX, double disc, bool use_cv);
+    // Randomised-QMC result from per-scrambling moments: a pooled control-variate
+    // coefficient, one estimate per scrambling, stderr from their spread and a Student-t CI.
+    MCResult mc_result_from_replicates(const std::vector<PairMoments>& reps, double EX, double disc,
+                                       bool use_cv);
+    // Call fn(c) for every chunk c in [0, n) with at most opts.n_threads calls in flight:
+    // n_threads == 0 uses the whole global pool, 1 runs inline on the caller, k > 1 runs
+    // k pool tasks that pull chunk indices from a shared counter.
+    void mc_for_each_chunk(std::size_t n, const MCOptions& opts, const std::function<void(std::size_t)>& fn);
+    // Run chunks [0, n_chunks) through price_chunk (see mc_for_each_chunk) and return how
+    // many ran. In adaptive mode chunks run as growing prefixes and
+    // stderr_of(k), the stderr from the first k chunks, decides when to stop; each batch
+    // is sized from the projected paths still needed and capped at doubling. A stopped
+    // run equals a fixed run over the same chunks.
+    std::size_t mc_run_chunks(std::size_t n_chunks, const MCOptions& opts,
+                              const std::function<void(std::size_t)>& price_chunk,
+                              const std::function<double(std::size_t)>& stderr_of);
+}
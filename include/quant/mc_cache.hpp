@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "quant/mc.hpp"
+
+namespace quant {
+    // Quantisation steps and sizes for MCPriceCache. Inputs are rounded to their step
+    // before pricing, so a bucket's price does not depend on which request filled it.
+    struct MCCacheConfig {
+        double spot_tick = 0.01;
+        double strike_tick = 0.01;
+        double vol_tick = 1e-4;
+        double time_tick = 1e-5;                  // years (~5 minutes)
+        double rate_tick = 1e-5;
+        std::size_t capacity = 4096;              // priced entries kept (LRU)
+        std::size_t path_capacity = 4;            // terminal distributions kept (LRU)
+        std::size_t max_cached_paths = 1 << 20;   // larger runs are priced but not kept
+    };
+
+    struct MCCacheStats {
+        uint64_t hits = 0;        // exact (quantised) price found
+        uint64_t path_hits = 0;   // priced from a cached terminal distribution
+        uint64_t misses = 0;      // full simulation
+        uint64_t evictions = 0;   // price and distribution entries dropped by LRU
+    };
+
+    // MCPriceCache
+    //
+    // Front of monte_carlo_terminal for quoting loops. A hit on the quantised
+    // (S, K, sigma, T, r, call/put, options) returns the stored result. Otherwise, if
+    // the (sigma, T, r, options) run is cached as terminal growth factors R = S_T / S0,
+    // any spot and strike is priced from them: under GBM S_T is linear in S0, so
+    // S0' * R are exactly the paths a run from S0' would draw (same seed), with no
+    // likelihood-ratio weights and no added variance. That costs one vector pass of the
+    // payoff kernel instead of normals and exps. QMC and Greeks runs are cached by
+    // price only; adaptive runs (targets or time budget) and clock-seeded runs
+    // (seed == 0) are not cached. Thread-safe; pricing runs outside the lock.
+    class MCPriceCache {
+    public:
+        explicit MCPriceCache(const MCCacheConfig& cfg = MCCacheConfig());
+
+        MCResult price(double S0, double K, double sigma, double T, const MCOptions& opts, bool is_call);
+
+        MCCacheStats stats() const;
+        void clear();
+
+    private:
+        // Quantised run settings shared by all spots and strikes.
+        struct RunKey {
+            int64_t sigma, T, r;
+            uint64_t n_paths, seed;
+            uint64_t flags;   // antithetic, control variate, QMC (+ scrambles), Greeks, precision
+            bool operator==(const RunKey& o) const {
+                return sigma == o.sigma && T == o.T && r == o.r && n_paths == o.n_paths &&
+                       seed == o.seed && flags == o.flags;
+            }
+        };
+        struct PriceKey {
+            RunKey run;
+            int64_t S, K;
+            bool is_call;
+            bool operator==(const PriceKey& o) const {
+                return run == o.run && S == o.S && K == o.K && is_call == o.is_call;
+            }
+        };
+        struct KeyHash {
+            std::size_t operator()(const RunKey& k) const;
+            std::size_t operator()(const PriceKey& k) const;
+        };
+
+        typedef std::shared_ptr<const std::vector<double>> Growth;
+
+        // Simulate the growth factors of a run (same draws as monte_carlo_terminal).
+        static Growth simulate_growth(double sigma, double T, const MCOptions& opts);
+        // Price one instrument from growth factors.
+        static MCResult price_from_growth(const std::vector<double>& R, double S0, double K, double T,
+                                          const MCOptions& opts, bool is_call);
+
+        MCCacheConfig cfg_;
+        mutable std::mutex mtx_;
+        MCCacheStats stats_;
+
+        // LRU lists (front = most recent) with map indices into them.
+        std::list<std::pair<PriceKey, MCResult>> prices_;
+        std::unordered_map<PriceKey, std::list<std::pair<PriceKey, MCResult>>::iterator, KeyHash> price_index_;
+        std::list<std::pair<RunKey, Growth>> runs_;
+        std::unordered_map<RunKey, std::list<std::pair<RunKey, Growth>>::iterator, KeyHash> run_index_;
+    };
+}
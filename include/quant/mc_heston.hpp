@@ -0,0 +1,22 @@
+#pragma once
+#include "quant/heston.hpp"
+#include "quant/mc.hpp"
+#include "quant/mc_path.hpp"
+
+namespace quant {
+    // Path-dependent Monte Carlo under Heston with the QE scheme (HestonQEStep), drift
+    // opts.r. Same block/chunk layout, payoffs and options as monte_carlo_path:
+    // running log-spot and variance per path in SoA blocks, n_steps QE steps, chunks on
+    // the thread pool, antithetics (both normals negated), adaptive stopping and
+    // thread-count-invariant results. Step k of draw d uses CounterRNG dims 2k (variance)
+    // and 2k + 1 (spot). Barrier bridging uses the step's mean variance. Vanillas go
+    // through european_option.
+    MCResult monte_carlo_heston(
+        double S0,
+        double T,
+        const HestonParams& params,
+        const PathPayoff& payoff,
+        const MCOptions& opts,
+        const PathMCOptions& path_opts = PathMCOptions()
+    );
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "quant/heston.hpp"
+#include "quant/moments.hpp"
+#include <cstddef>
+
+namespace quant {
+    // Inputs of the terminal-payoff kernel: S_T = S0 * exp(drift + vol * z).
+    struct TerminalParams {
+        double S0;
+        double K;
+        double drift;       // (r - sigma^2 / 2) * T
+        double vol;         // sigma * sqrt(T)
+        bool   is_call;
+        bool   antithetic;  // also evaluate -z for every z
+    };
+
+    // Fold the undiscounted payoff Y and the control variate X = S_T over the normals
+    // z[0..n) (2n samples when antithetic) into acc. Dispatches at run time to an
+    // AVX-512 (8 paths per instruction) or AVX2 (4 paths) kernel with a vectorised exp,
+    // branch-free payoff and per-lane Welford moments, or to a scalar fallback.
+    void terminal_kernel(const TerminalParams& p, const double* z, std::size_t n, PairMoments& acc);
+
+    // Single-precision variant for MCPrecision::Single over float normals: S_T and the
+    // payoff are computed in float (twice the lanes per instruction), and moment sums run
+    // in float over short blocks, centred on E[S_T] and the forward intrinsic, before
+    // merging into acc in double. Agrees with terminal_kernel to ~1e-7 relative; CPUs
+    // without AVX2 run the scalar double loop on the float draws.
+    void terminal_kernel_f32(const TerminalParams& p, const float* z, std::size_t n, PairMoments& acc);
+
+    // Strip building blocks: one set of terminal prices shared by many payoffs.
+    // out[i] = S0 * exp(drift + vol * z[i]) for i < n; when antithetic, also
+    // out[out_stride + i] = S0 * exp(drift - vol * z[i]).
+    void terminal_prices(double S0, double drift, double vol, const double* z, std::size_t n,
+                         bool antithetic, double* out, std::size_t out_stride);
+    // Fold Y = max(+-(ST[i] - K), 0) and X = ST[i] for i < n into acc.
+    void payoff_moments(const double* ST, std::size_t n, double K, bool is_call, PairMoments& acc);
+
+    // out[i] = exp(x[i]) for i < n with the dispatched vector exp.
+    void exp_array(const double* x, std::size_t n, double* out);
+
+    // One Heston QE step (HestonQEStep::step) for paths [0, n) in SoA form, with both
+    // normals multiplied by sign (-1 for antithetic twins). The quadratic branch runs
+    // on vectors for every path; only paths in the exponential branch or with psi
+    // near 0 (xi ~ 0) take a scalar fix-up. scratch must hold n doubles.
+    void heston_qe_block(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                         const double* z, std::size_t n, double sign, double* scratch);
+
+    // Name of the kernel set the functions above dispatch to ("avx512", "avx2" or "scalar").
+    const char* terminal_kernel_isa();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include "quant/mc.hpp"
+
+namespace quant {
+    // Longstaff-Schwartz settings: n_steps equally spaced exercise dates in (0, T];
+    // continuation values are regressed on 1, x, ..., x^basis_degree with x = S / K.
+    struct LSMOptions {
+        std::size_t n_steps = 50;
+        std::size_t basis_degree = 3;   // clamped to [1, 5]
+    };
+
+    // American call/put by Longstaff-Schwartz under GBM. Paths are simulated in parallel
+    // chunks into a time-major matrix (one row of all paths per exercise date, so each
+    // backward step streams one contiguous row); each backward step accumulates the
+    // normal equations of the in-the-money paths per chunk in one fused pass, merges
+    // them in chunk order and solves the small system directly. The estimate reuses
+    // the regression paths (slight high bias, standard for LSM); with
+    // use_control_variate the discounted European payoff is the control (its
+    // Black-Scholes price is known). Memory is n_paths x n_steps doubles; use_qmc and
+    // the adaptive targets are not used here.
+    MCResult monte_carlo_american(
+        double S0,
+        double K,
+        double sigma,
+        double T,
+        const MCOptions& opts,
+        bool is_call,
+        const LSMOptions& lsm = LSMOptions()
+    );
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "quant/mc.hpp"
+
+namespace quant {
+    // Correlated GBM assets: dS_i = (r - q_i) S_i dt + sigma_i S_i dW_i with
+    // d<W_i, W_j> = correlation[i * n + j] dt. q may be empty (no yields).
+    struct MultiAssetModel {
+        std::vector<double> S0;
+        std::vector<double> sigma;
+        std::vector<double> q;             // continuous dividend / carry yield per asset
+        std::vector<double> correlation;   // n x n, row-major, unit diagonal
+    };
+
+    // Terminal state of one simulated path, handed to the payoff.
+    struct BasketState {
+        const double* S0;
+        const double* S_T;
+        std::size_t n_assets;
+    };
+
+    // Undiscounted payoff over the terminal prices of all assets.
+    struct MultiAssetPayoff {
+        std::function<double(const BasketState&)> fn;
+    };
+
+    // max(+-(sum_i weights[i] * S_T[i] - K), 0).
+    MultiAssetPayoff basket_option(std::vector<double> weights, double K, bool is_call);
+    // max(+-(S_T[0] - S_T[1] - K), 0).
+    MultiAssetPayoff spread_option(double K, bool is_call);
+    // Worst performer: max(+-(min_i S_T[i] / S0[i] - K), 0), K as a fraction of spot.
+    MultiAssetPayoff worst_of(double K, bool is_call);
+
+    // Lower-triangular Cholesky factor (row-major) of an n x n correlation matrix.
+    // Returns false when the matrix is not symmetric positive semi-definite.
+    bool cholesky_factor(const std::vector<double>& corr, std::size_t n, std::vector<double>& L);
+
+    // European multi-asset Monte Carlo. The correlation is factored once; each block
+    // draws one normal per asset and path (CounterRNG dim = asset, or a Sobol dimension
+    // per asset under QMC), correlates them with L and builds S_T per asset in
+    // structure-of-arrays form with the SIMD terminal kernel. Chunking, threading,
+    // antithetics, adaptive stopping and determinism follow monte_carlo_terminal; the
+    // control variate is the mean of S_T[i] / S0[i]. A model with mismatched sizes or
+    // an invalid correlation matrix prices to an empty result (n_samples == 0).
+    MCResult monte_carlo_multi(
+        const MultiAssetModel& model,
+        double T,
+        const MultiAssetPayoff& payoff,
+        const MCOptions& opts
+    );
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include "quant/mc.hpp"
+
+namespace quant {
+    // Summary of one simulated path, accumulated step by step (the path itself is
+    // never stored). Fixings are the n_steps simulated points after t = 0.
+    struct PathState {
+        double S0;
+        double S_T;            // terminal price
+        double average;        // arithmetic mean of the fixings
+        double min;            // min over S0 and the fixings
+        double max;            // max over S0 and the fixings
+        double survival_up;    // P(no touch of the up barrier), 1 when none is monitored
+        double survival_down;  // P(no touch of the down barrier), 1 when none is monitored
+    };
+
+    // Payoff functor over a finished path plus the barriers the engine must monitor
+    // (0 = none). With Brownian-bridge monitoring the survival fields are continuous-
+    // barrier probabilities given the simulated points; otherwise they are 0 or 1.
+    struct PathPayoff {
+        std::function<double(const PathState&)> fn;   // undiscounted payoff
+        double barrier_up = 0.0;
+        double barrier_down = 0.0;
+    };
+
+    enum class BarrierKind { UpAndOut, UpAndIn, DownAndOut, DownAndIn };
+
+    // Plain European max(+-(S_T - K), 0), for engines that only take path payoffs.
+    PathPayoff european_option(double K, bool is_call);
+    // Arithmetic-average (Asian) option on the fixings.
+    PathPayoff asian_arithmetic(double K, bool is_call);
+    // Single-barrier knock-in/knock-out vanilla with strike K.
+    PathPayoff barrier_option(double K, double barrier, BarrierKind kind, bool is_call);
+    // Floating-strike lookback: S_T - min (call) or max - S_T (put).
+    PathPayoff lookback_floating(bool is_call);
+    // Fixed-strike lookback: max(max - K, 0) (call) or max(K - min, 0) (put).
+    PathPayoff lookback_fixed(double K, bool is_call);
+
+    // Path settings: n_steps equal steps over [0, T]; brownian_bridge corrects discrete
+    // barrier monitoring towards the continuously monitored price.
+    struct PathMCOptions {
+        std::size_t n_steps = 252;
+        bool brownian_bridge = true;
+    };
+
+    // Path-dependent Monte Carlo under GBM. Paths advance in blocks, one time step at a
+    // time, keeping only running state (log-spot, sum, min, max, survival) per path, so
+    // memory is O(block) per worker regardless of n_paths x n_steps. Step i of draw d
+    // uses CounterRNG normal(d, i); blocks run on the thread pool like
+    // monte_carlo_terminal. Antithetic pairs negate every step; S_T is the control variate.
+    MCResult monte_carlo_path(
+        double S0,
+        double sigma,
+        double T,
+        const PathPayoff& payoff,
+        const MCOptions& opts,
+        const PathMCOptions& path_opts = PathMCOptions()
+    );
+}
@@ -5,6 +5,11 @@ namespace quant {
 
 enum class Side : uint8_t {Buy = 0, Sell = 1};
 
+// Instrument used for orders that do not name one (legacy NEW_ORDER frames, UI).
+constexpr uint32_t DEFAULT_INSTRUMENT_ID = 1;
+// PnLUpdate.instrument_id value for a user's totals across all instruments.
+constexpr uint32_t ALL_INSTRUMENTS = UINT32_MAX;
+
 enum MsgType : uint8_t {
     NEW_ORDER  = 1,
     CANCEL     = 2,
@@ -12,7 +17,30 @@ enum MsgType : uint8_t {
     ACK        = 4,
     TOB        = 5,
     L2_UPDATE  = 6,
-    PNL_UPDATE = 7
+    PNL_UPDATE = 7,
+    // Market-data recovery (multicast feed) and per-client subscriptions
+    RETRANSMIT_REQUEST = 8,  // client -> server: resend feed messages [from_seq, to_seq]
+    MD_PACKET          = 9,  // server -> client: one multicast datagram replayed over TCP
+    SNAPSHOT_END       = 10, // server -> client: preceding TOB/L2 frames are the state as of seq
+    SUBSCRIBE          = 11, // client -> server: bitmask of MsgTypes to receive on this connection
+    DEPTH_UPDATE       = 12, // server -> client: all changed levels for one instrument/side
+    L3_EVENT           = 13, // server -> client: order-by-order book event (opt-in subscription)
+    AMEND              = 14, // client -> server: change the quantity of a resting order
+    BAR                = 15, // server -> client: closed OHLCV bar with rolling trade analytics
+    RISK_UPDATE        = 16, // server -> client: a user's aggregated Greeks for one underlying
+    PNL_HISTORY_REQUEST = 17, // client -> server: fetch one tier of a user's PnL history
+    PNL_HISTORY        = 18, // server -> client: reply to PNL_HISTORY_REQUEST (requester only)
+    LOTS_REQUEST       = 19, // client -> server: fetch a user's FIFO lots in one instrument
+    LOTS               = 20  // server -> client: open and recently closed lots (requester only)
+};
+
+// Order-by-order book mutations published on the L3 feed.
+enum class L3EventType : uint8_t {
+    Add     = 0, // order rests on the book (quantity = resting qty)
+    Execute = 1, // resting order filled (quantity = executed qty, price = level price)
+    Cancel  = 2, // resting order removed (quantity = qty removed)
+    Amend   = 3, // resting quantity changed (quantity = new remaining qty)
+    Reset   = 4  // consumers must clear their book; Add events for all resting orders follow
 };
 
 // ------------ Client → Engine ------------
@@ -41,10 +69,17 @@ struct MsgCancel {
     uint64_t order_id;
 };
 
+// Reducing quantity keeps queue priority; increasing it moves the order to the back.
+struct MsgAmend {
+    uint64_t order_id;
+    uint64_t quantity;   // new remaining quantity (0 => cancel)
+};
+
 struct ClientMessage {
     MsgType      type;
     MsgNewOrder  new_order;
     MsgCancel    cancel;
+    MsgAmend     amend;
 };
 
 // ------------ Engine → Client ------------
@@ -69,6 +104,7 @@ struct Ack {
 };
 
 struct TopOfBook {
+    uint32_t instrument_id = 0;
     bool     has_bid = false;
     bool     has_ask = false;
     double   bid_price = 0;
@@ -83,8 +119,54 @@ struct L2Update {
     uint64_t quantity;
 };
 
+// Maximum levels carried by one DEPTH_UPDATE; larger changes span several messages.
+constexpr uint8_t MAX_DEPTH_LEVELS = 16;
+
+struct DepthLevel {
+    double   price;
+    uint64_t quantity; // 0 => level removed
+};
+
+// Batched L2 change for one instrument and side. Incremental updates list only the
+// levels that changed; a snapshot (is_snapshot = 1) replaces the side with the top-N.
+struct DepthUpdate {
+    uint32_t   instrument_id = 0;
+    uint8_t    side = 0;        // 0=bid, 1=ask
+    uint8_t    is_snapshot = 0;
+    uint8_t    count = 0;
+    DepthLevel levels[MAX_DEPTH_LEVELS];
+};
+
+// One L3 event; seq is contiguous per book so the stream doubles as an event journal.
+struct L3Event {
+    uint64_t    seq = 0;
+    uint64_t    order_id = 0;
+    double      price = 0;
+    uint64_t    quantity = 0;
+    uint32_t    instrument_id = 0;
+    L3EventType type = L3EventType::Add;
+    uint8_t     side = 0;   // 0=bid, 1=ask
+};
+
+// Closed OHLCV bar for one instrument/interval plus rolling-window analytics at close.
+struct BarUpdate {
+    uint32_t instrument_id = 0;
+    uint32_t interval_ms = 0;
+    uint64_t start_ms = 0;      // wall-clock bar start (ms since epoch)
+    double   open = 0;
+    double   high = 0;
+    double   low = 0;
+    double   close = 0;
+    uint64_t volume = 0;
+    uint32_t trade_count = 0;
+    double   vwap = 0;          // VWAP of this bar
+    double   rolling_vwap = 0;  // VWAP over the rolling window
+    double   realized_vol = 0;  // annualized, from trade-to-trade log returns in the window
+};
+
 struct PnLUpdate {
     uint32_t user_id = 0;
+    uint32_t instrument_id = 0;
     double realized;
     double unrealized;
     double position;
@@ -92,18 +174,44 @@ struct PnLUpdate {
     double equity;
 };
 
+// Portfolio Greeks of one user on one underlying: option positions plus the underlying
+// itself (delta 1 per unit). Vega is per unit of vol, theta per year.
+struct RiskUpdate {
+    uint32_t user_id = 0;
+    uint32_t underlying_id = 0;
+    double   underlying_mid = 0;
+    double   delta = 0;
+    double   gamma = 0;
+    double   vega = 0;
+    double   theta = 0;
+};
+
 // SERVER MESSAGE
+// Tagged union: `type` selects the payload, so a queued message costs the largest
+// payload (DepthUpdate) rather than the sum of all of them. Assign a whole payload
+// (sm.tob = ...) before touching its fields.
 struct ServerMessage {
-    MsgType     type;
+    ServerMessage() : type(), trade() {}
 
-    Trade       trade;
-    Ack         ack;
-    TopOfBook   tob;
-    L2Update    l2;
-    PnLUpdate   pnl;
+    MsgType     type;
 
     // NEW field to identify BS bot trades
     uint8_t     is_bot_trade = 0;
+    // 0 => broadcast; otherwise only the client connection with this id receives the
+    // message (e.g. the depth snapshot for a newly connected client).
+    uint32_t    target_client = 0;
+
+    union {
+        Trade       trade;
+        Ack         ack;
+        TopOfBook   tob;
+        L2Update    l2;
+        PnLUpdate   pnl;
+        DepthUpdate depth;
+        L3Event     l3;
+        BarUpdate   bar;
+        RiskUpdate  risk;
+    };
 };
 
 } // namespace quant
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+
+namespace quant {
+    // Moments
+    //
+    // Welford/Chan streaming mean and centred sum of squares of one quantity.
+    struct Moments {
+        std::size_t n = 0;
+        double mean = 0.0;
+        double m2 = 0.0;    // sum (v - mean)^2
+
+        void add(double v) {
+            ++n;
+            const double d = v - mean;
+            mean += d / static_cast<double>(n);
+            m2 += d * (v - mean);
+        }
+
+        void merge(const Moments& o) {
+            if (o.n == 0) return;
+            if (n == 0) { *this = o; return; }
+            const double na = static_cast<double>(n);
+            const double nb = static_cast<double>(o.n);
+            const double nt = na + nb;
+            const double d = o.mean - mean;
+            mean += d * (nb / nt);
+            m2 += o.m2 + d * d * (na * nb / nt);
+            n += o.n;
+        }
+
+        // Unbiased (n - 1) variance; zero below two samples.
+        double var() const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+    };
+
+    // PairMoments
+    //
+    // Streaming first and second moments of a sample pair (Y, X): means, centred sums of
+    // squares and the centred cross product. Updated with Welford's recurrence and
+    // combined with Chan et al.'s pairwise formula, so variances and the covariance stay
+    // accurate in double without ever forming sum(Y^2) - n * mean^2.
+    struct PairMoments {
+        std::size_t n = 0;
+        double meanY = 0.0;
+        double meanX = 0.0;
+        double m2Y = 0.0;   // sum (Y - meanY)^2
+        double m2X = 0.0;   // sum (X - meanX)^2
+        double cYX = 0.0;   // sum (Y - meanY)(X - meanX)
+
+        void add(double y, double x) {
+            ++n;
+            const double inv = 1.0 / static_cast<double>(n);
+            const double dY = y - meanY;
+            const double dX = x - meanX;
+            meanY += dY * inv;
+            meanX += dX * inv;
+            m2Y += dY * (y - meanY);
+            m2X += dX * (x - meanX);
+            cYX += dY * (x - meanX);
+        }
+
+        void merge(const PairMoments& o) {
+            if (o.n == 0) return;
+            if (n == 0) { *this = o; return; }
+            const double na = static_cast<double>(n);
+            const double nb = static_cast<double>(o.n);
+            const double nt = na + nb;
+            const double dY = o.meanY - meanY;
+            const double dX = o.meanX - meanX;
+            const double w = na * nb / nt;
+            meanY += dY * (nb / nt);
+            meanX += dX * (nb / nt);
+            m2Y += o.m2Y + dY * dY * w;
+            m2X += o.m2X + dX * dX * w;
+            cYX += o.cYX + dY * dX * w;
+            n += o.n;
+        }
+
+        // Unbiased (n - 1) estimators; zero below two samples.
+        double var_y() const { return n > 1 ? m2Y / static_cast<double>(n - 1) : 0.0; }
+        double var_x() const { return n > 1 ? m2X / static_cast<double>(n - 1) : 0.0; }
+        double cov_yx() const { return n > 1 ? cYX / static_cast<double>(n - 1) : 0.0; }
+    };
+
+    // Merge parts[0..count) as a balanced binary tree (pairwise), which keeps rounding
+    // error growth logarithmic in the number of parts. Works in place; returns parts[0].
+    // M is any accumulator with merge(const M&) (Moments, PairMoments, ...).
+    template <class M>
+    inline M merge_pairwise(M* parts, std::size_t count) {
+        if (count == 0) return M{};
+        for (std::size_t stride = 1; stride < count; stride *= 2) {
+            for (std::size_t i = 0; i + stride < count; i += 2 * stride) {
+                parts[i].merge(parts[i + stride]);
+            }
+        }
+        return parts[0];
+    }
+}
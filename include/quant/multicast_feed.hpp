@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "quant/net_platform.hpp"
+#include "quant/messages.hpp"
+
+namespace quant {
+
+/**
+ * MulticastPublisher:
+ *  - Publishes public market data (TRADE, TOB, L2_UPDATE, DEPTH_UPDATE, BAR) on a UDP multicast group
+ *  - Packs several framed messages per datagram:
+ *      [8-byte BE seq of first message][2-byte BE message count][framed msg]...
+ *    where each framed msg is the usual [4-byte BE len][payload], so receivers
+ *    reuse the TCP deframer on the datagram body
+ *  - Keeps the last `ring_packets` datagrams for TCP retransmission and a
+ *    per-instrument last-value cache (TOB + depth levels) to serve snapshots for older gaps
+ *
+ * Fan-out cost is one sendto() per datagram regardless of subscriber count.
+ * Not thread-safe: owned and driven by the NetworkServer worker thread.
+ */
+class MulticastPublisher {
+public:
+    // group/port: multicast destination; iface: local IPv4 of the sending interface
+    // (127.0.0.1 keeps the feed on loopback); ttl 0 never leaves the host.
+    MulticastPublisher(const std::string& group, int port,
+                       const std::string& iface = "127.0.0.1",
+                       int ttl = 1, std::size_t ring_packets = 4096);
+    ~MulticastPublisher();
+
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+
+    // Create the UDP socket and configure TTL/interface/loopback; false on failure.
+    bool open();
+    void close();
+
+    // True for message types carried on the public feed.
+    static bool is_feed_message(MsgType type);
+
+    // Append one framed message to the pending datagram, flushing first if it would
+    // exceed the datagram budget. Assigns the next sequence number.
+    void publish(const ServerMessage& msg, const std::vector<uint8_t>& framed);
+    // Send the pending datagram (no-op if empty).
+    void flush();
+
+    // Recovery: append TCP frames that let a client fill the gap [from_seq, to_seq].
+    // Emits MD_PACKET frames for datagrams still in the ring; if the gap is older than
+    // the ring, emits a TOB/DEPTH_UPDATE snapshot of every instrument followed by
+    // SNAPSHOT_END instead.
+    void recover(uint64_t from_seq, uint64_t to_seq, std::vector<std::vector<uint8_t>>& out_frames) const;
+
+    // Sequence number of the last published message (0 before the first).
+    uint64_t last_seq() const { return next_seq_ - 1; }
+
+private:
+    struct Packet {
+        uint64_t first_seq = 0;
+        uint16_t count = 0;
+        std::vector<uint8_t> bytes;
+    };
+
+    // Header: 8-byte first seq + 2-byte count.
+    static constexpr std::size_t HEADER_SIZE = 10;
+    // Stay below a 1500-byte Ethernet MTU after IP/UDP headers.
+    static constexpr std::size_t MAX_DATAGRAM = 1400;
+
+    // Update the last-value cache used for snapshots.
+    void apply_to_cache(const ServerMessage& msg);
+    // Start a fresh pending datagram in the next ring slot.
+    void begin_packet();
+    // Emit every cached book as framed TOB/DEPTH_UPDATE messages, then one SNAPSHOT_END.
+    void append_snapshot(std::vector<std::vector<uint8_t>>& out_frames) const;
+
+    std::string group_;
+    int port_;
+    std::string iface_;
+    int ttl_;
+
+    qsocket_t fd_;
+    sockaddr_in dest_;
+
+    uint64_t next_seq_ = 1;
+    // Ring of sent datagrams; slot `head_` holds the pending (unsent) one.
+    std::vector<Packet> ring_;
+    std::size_t head_ = 0;
+    std::size_t sent_packets_ = 0;
+
+    // Last-value cache of one instrument: most recent TOB and aggregate quantity per
+    // price, [0]=bids [1]=asks.
+    struct BookCache {
+        bool have_tob = false;
+        ServerMessage last_tob;
+        std::map<double, uint64_t> levels[2];
+    };
+    std::map<uint32_t, BookCache> books_;
+};
+
+} // namespace quant
@@ -6,8 +6,11 @@
 #include <string>
 #include <cstdint>
 #include <atomic>
+#include <memory>
 #include <unordered_map>
 
+#include "quant/messages.hpp"
+
 #if defined(_WIN32) || defined(_WIN64)
   #include <winsock2.h>
   #include <ws2tcpip.h>
@@ -21,6 +24,7 @@ namespace quant {
 
 struct ServerMessage;
 class MatchingServer;
+class MulticastPublisher;
 
 /**
  * ClientState MUST be fully defined in the header,
@@ -28,18 +32,28 @@ class MatchingServer;
  */
 struct ClientState {
     qsocket_t fd;
+    // Connection id (never reused) for messages addressed to this client only.
+    uint32_t id = 0;
     std::vector<uint8_t> recv_buffer;
     std::deque<std::vector<uint8_t>> send_queue;
     size_t send_offset = 0;
     std::string peer;
+    // SOCK_SEQPACKET client: each packet is one payload, so no length prefix
+    // is sent and the receive side skips the deframer.
+    bool message_mode = false;
+    // Bit (1u << MsgType) set => broadcast messages of that type are sent to this client.
+    // The L3 feed is opt-in.
+    uint32_t sub_mask = ~(1u << L3_EVENT);
 };
 
 /**
  * NetworkServer:
- *  - Accepts multiple TCP clients
+ *  - Accepts multiple TCP clients, plus optional AF_UNIX clients for co-located consumers
  *  - Receives framed messages
  *  - Passes orders to MatchingServer
- *  - Broadcasts engine messages
+ *  - Broadcasts engine messages (filtered by each client's SUBSCRIBE mask)
+ *  - Optionally publishes public market data on UDP multicast and serves
+ *    RETRANSMIT_REQUEST gap recovery for it over the client connections
  *  - Handles partial reads/writes
  */
 class NetworkServer {
@@ -47,6 +61,19 @@ public:
     explicit NetworkServer(MatchingServer* engine, int port);
     ~NetworkServer();
 
+    // Also listen on an AF_UNIX socket at `path` (call before start()). Stream sockets use the
+    // same [len][payload] framing as TCP; seqpacket sockets carry one unframed payload per packet
+    // (at most 4096 bytes; a client sending a larger packet is disconnected). Server packets
+    // stay well under the socket send buffer: large replies are split (REPLY_CHUNK_ITEMS), and
+    // a message that still does not fit is dropped with a log line, not the client.
+    // Returns false on platforms without AF_UNIX support.
+    bool listen_unix(const std::string& path, bool seqpacket = false);
+
+    // Also publish TRADE/TOB/L2 on a UDP multicast group (call before start()).
+    // Returns false if the publisher socket cannot be opened.
+    bool enable_multicast(const std::string& group, int port,
+                          const std::string& iface = "127.0.0.1", int ttl = 1);
+
     // Bind/listen and spawn worker thread; returns false if already running or on bind/listen failure.
     bool start();
     // Stop accepting, close all client sockets, and join worker thread.
@@ -55,11 +82,14 @@ public:
 private:
     // Event loop: accept new clients, read frames, dispatch to engine, and broadcast engine messages.
     void run_loop();
+    // Accept all pending connections on a listening socket and register them as clients.
+    void accept_clients(qsocket_t lfd, bool is_unix);
+    // Create, bind and listen on the AF_UNIX socket configured via listen_unix().
+    bool open_unix_listener();
     // Process a complete payload (after deframing) from a client; may enqueue orders/cancels.
     void handle_client_payload(ClientState &cs, const std::vector<uint8_t>& payload);
-
-    // Frame a server message as [4-byte big-endian length][payload bytes].
-    std::vector<uint8_t> pack_server_message(const ServerMessage& msg);
+    // Enable the engine's L3 feed iff at least one client subscribes to it.
+    void update_l3_subscription();
 
 private:
     // Engine to bridge messages to/from.
@@ -71,11 +101,21 @@ private:
     std::atomic<bool> running_;
     // Listening socket descriptor.
     qsocket_t listen_fd_;
+    // Optional AF_UNIX listener (empty path => disabled).
+    std::string unix_path_;
+    bool unix_seqpacket_ = false;
+    qsocket_t unix_fd_;
+    // Optional multicast market-data publisher (null => disabled).
+    std::unique_ptr<MulticastPublisher> mcast_;
     // Dedicated worker thread.
     std::thread worker_thread_;
 
+    // Reused encode buffer for outgoing engine messages (avoids a temp frame per message).
+    std::vector<uint8_t> encode_buf_;
+
     // Active clients keyed by fd; stores partial I/O state.
     std::unordered_map<int, ClientState> clients_;
+    uint32_t next_client_id_ = 1;
 };
 
 } // namespace quant
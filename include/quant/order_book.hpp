@@ -19,23 +19,37 @@ namespace quant {
 class OrderBook {
 public:
     // Construct an order book for a given symbol. Symbol is used only for identification
-    // and does not affect matching rules.
-    explicit OrderBook(const std::string& symbol);
+    // and does not affect matching rules. pool_capacity bounds the resting orders.
+    explicit OrderBook(const std::string& symbol, uint32_t pool_capacity = 1u << 20);
 
     // Return the instrument symbol handled by this book.
     const std::string& symbol() const { return symbol_; }
 
     // Submit a limit order. Returns assigned order_id. Any immediate matches
     // generate Trade entries appended to out_trades; remaining quantity rests.
+    // A full book (see full()) rejects the order untouched and returns 0.
     uint64_t submit_limit_order(const Order& order, std::vector<Trade>& out_trades);
     // Cancel a resting order by id. Returns true if the order was found and removed.
     bool     cancel_order(uint64_t order_id);
+    // Change a resting order's quantity. A decrease keeps queue priority, an increase
+    // moves it to the back of its level, 0 cancels. Returns false if the order is unknown.
+    bool     amend_order(uint64_t order_id, uint64_t new_quantity);
+
+    // Route order-by-order events (L3) for every book mutation into `sink`; nullptr disables.
+    // The sink is only appended to; the caller drains it.
+    void set_event_sink(std::vector<L3Event>* sink) { events_ = sink; }
+    // Append a Reset event followed by an Add for every resting order in priority order.
+    void snapshot_orders(std::vector<L3Event>& out);
 
     // Compute current top of book (best bid/ask consolidated quantities).
     TopOfBook top_of_book() const;
 
     // Number of resting orders currently indexed.
     std::size_t size() const { return order_index_.size(); }
+    // True when pool_capacity orders are resting; new orders are rejected until one leaves.
+    bool full() const { return pool_.full(); }
+    // True if the order id is resting on this book.
+    bool contains(uint64_t order_id) const { return order_index_.count(order_id) != 0; }
 
     // Snapshot bid price levels as (price, aggregate_qty) sorted by price desc.
     std::vector<std::pair<double, uint64_t>> snapshot_bids() const;
@@ -67,6 +81,10 @@ private:
     uint64_t next_order_id_  = 1;
     uint64_t next_trade_id_  = 1;
     uint64_t next_timestamp_ = 1;
+    uint64_t next_event_seq_ = 1;
+
+    // Optional L3 event sink (not owned).
+    std::vector<L3Event>* events_ = nullptr;
 
     OrderPool pool_;
 
@@ -87,6 +105,8 @@ private:
     void unlink_from_level(PriceLevel& level, uint32_t idx);
     // Check if a price level has no orders.
     bool level_empty(const PriceLevel& level) const;
+    // Append an L3 event to the sink if one is installed.
+    void record_event(L3EventType type, uint64_t order_id, uint8_t side, double price, uint64_t qty);
 };
 
 } // namespace quant
@@ -1,7 +1,6 @@
 #pragma once
 #include <vector>
 #include <cstdint>
-#include <cassert>
 
 namespace quant {
 
@@ -28,8 +27,9 @@ public:
             free_list_[i] = capacity - 1 - i;
     }
 
+    // Returns UINT32_MAX when the pool is exhausted.
     uint32_t allocate() {
-        assert(!free_list_.empty() && "OrderPool exhausted");
+        if (free_list_.empty()) return UINT32_MAX;
         uint32_t idx = free_list_.back();
         free_list_.pop_back();
         storage_[idx].active = true;
@@ -47,6 +47,7 @@ public:
     const PoolOrder& operator[](uint32_t idx) const { return storage_[idx]; }
 
     bool is_active(uint32_t idx) const { return storage_[idx].active; }
+    bool full() const { return free_list_.empty(); }
 
 private:
     std::vector<PoolOrder> storage_;
@@ -1,43 +1,184 @@
 #pragma once
 #include "quant/messages.hpp" // use the protocol PnLUpdate defined there
+#include "quant/lot_pool.hpp"
 #include <cstdint>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 namespace quant {
 
+// How realized PnL is attributed when a position is reduced.
+enum class CostBasis : uint8_t {
+    AverageCost = 0, // single running VWAP per position (default, cheapest)
+    FIFO        = 1  // oldest open lot closes first; per-lot realized PnL is kept
+};
+
+// Lot of a FIFO position. Open lots report the remaining quantity; closed lots the
+// quantity they were opened with, their total realized PnL and the closing fill.
+struct LotInfo {
+    double   quantity;       // open: remaining quantity; closed: opened quantity (unsigned)
+    double   price;          // opening price
+    double   realized;       // realized so far by (partial) closes of this lot
+    uint64_t trade_seq;      // sequence of the opening fill within the engine
+    uint64_t close_seq = 0;  // sequence of the fill that closed the lot (closed lots only)
+};
+
 /**
  * PnLEngine
  *
- * Keeps per-user PnL state and exposes snapshots using the protocol type
- * quant::PnLUpdate (defined in messages.hpp).
+ * Average-cost position table keyed by (user, instrument), with a per-instrument
+ * mark cache and an instrument -> holders index. A new mark only re-values the
+ * open positions in that instrument, so mark-to-market costs O(affected positions)
+ * however many instruments are live. Per-user totals are maintained incrementally.
  *
+ * In CostBasis::FIFO mode each position also keeps a queue of open lots drawn from
+ * a LotPool, so fills cost O(lots closed) with no per-fill heap allocation; avg_price
+ * is then the quantity-weighted price of the remaining lots. Fully closed lots go to a
+ * fixed-size ring (the last closed_lot_capacity across all positions) with their
+ * realized PnL.
+ *
+ * Snapshots use the protocol type quant::PnLUpdate (defined in messages.hpp).
  * Note: messages.hpp already defines the PnLUpdate struct used on the wire,
  * so we must NOT redefine it here (avoid duplicate-definition errors).
  */
 class PnLEngine {
 public:
-    explicit PnLEngine(uint64_t user_id);
+    explicit PnLEngine(CostBasis basis = CostBasis::AverageCost, uint32_t lot_capacity = 4096,
+                       uint32_t closed_lot_capacity = 4096);
+
+    CostBasis cost_basis() const { return basis_; }
 
-    // Called when a trade happens (trade fill for this user).
+    // Called for each fill of `user_id` in `instrument_id`.
     // user_is_buy == true => this user bought qty at price
     // user_is_buy == false => this user sold qty at price
-    void on_trade(bool user_is_buy, double price, uint64_t qty);
+    void on_trade(uint64_t user_id, uint32_t instrument_id, bool user_is_buy, double price, uint64_t qty);
+
+    // Called when an instrument's mid changes. Re-marks only that instrument's open
+    // positions; if `touched_users` is given, appends the users whose PnL changed.
+    void on_mark(uint32_t instrument_id, double mid, std::vector<uint64_t>* touched_users = nullptr);
 
-    // Called when mid/TOB updates (update unrealized PnL)
-    void on_midprice(double mid);
+    // Snapshot of one (user, instrument) position (thread-safe copy).
+    quant::PnLUpdate get(uint64_t user_id, uint32_t instrument_id) const;
+    // Realized/unrealized/equity summed over all of the user's instruments;
+    // position/avg_price are left 0 because they do not aggregate across instruments.
+    quant::PnLUpdate get_total(uint64_t user_id) const;
 
-    // Get latest snapshot (thread-safe copy)
-    quant::PnLUpdate get() const;
+    // Last mark seen for an instrument (0 if none yet).
+    double mark(uint32_t instrument_id) const;
+
+    // Open lots of (user, instrument), oldest first (FIFO mode only; empty otherwise).
+    void open_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& out) const;
+    // Lots of (user, instrument) still in the closed-lot ring, oldest close first
+    // (FIFO mode only; empty otherwise).
+    void closed_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& out) const;
 
 private:
-    uint64_t user_id_;
+    struct Key {
+        uint64_t user_id;
+        uint32_t instrument_id;
+        bool operator==(const Key& o) const {
+            return user_id == o.user_id && instrument_id == o.instrument_id;
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const {
+            return std::hash<uint64_t>()(k.user_id * 0x9e3779b97f4a7c15ULL ^ k.instrument_id);
+        }
+    };
+
+    struct Position {
+        uint64_t user_id = 0;
+        uint32_t instrument_id = 0;
+        double   position = 0.0;     // +long, -short (signed)
+        double   avg_price = 0.0;    // VWAP of open position
+        double   realized = 0.0;
+        double   unrealized = 0.0;
+        uint32_t holder_slot = UINT32_MAX; // index in the instrument's holders list while open
+        // FIFO mode: open lot queue in lots_ and the sum of quantity * price over it
+        uint32_t lot_head = UINT32_MAX;
+        uint32_t lot_tail = UINT32_MAX;
+        double   open_cost = 0.0;
+    };
+
+    struct InstrumentMarks {
+        double mark = 0.0;
+        std::vector<uint32_t> holders; // indices into positions_ with position != 0
+    };
+
+    struct ClosedLot {
+        uint64_t user_id;
+        uint32_t instrument_id;
+        LotInfo  lot;
+    };
+
+    struct UserTotals {
+        double realized = 0.0;
+        double unrealized = 0.0;
+    };
+
+    // Find or create the position row for (user, instrument).
+    uint32_t position_index(uint64_t user_id, uint32_t instrument_id);
+    // Apply a signed fill to the position under each cost basis.
+    void apply_average_cost(Position& pos, double signed_qty, double price);
+    void apply_fifo(Position& pos, double signed_qty, double price);
+    // Recompute unrealized at `mark` and push the delta into the user's totals.
+    void remark(Position& p, double mark);
+    // Keep the holders index in sync with whether the position is open.
+    void update_holder(uint32_t idx, InstrumentMarks& im);
+    quant::PnLUpdate snapshot(const Position& p) const;
+
+    CostBasis basis_;
     mutable std::mutex mtx_;
+    LotPool lots_;
+    uint64_t fill_seq_ = 0;
+    // Ring of the most recently closed lots; closed_head_ is the next slot written.
+    std::vector<ClosedLot> closed_;
+    std::size_t closed_head_ = 0;
+    std::size_t closed_count_ = 0;
+    std::vector<Position> positions_;
+    std::unordered_map<Key, uint32_t, KeyHash> index_;
+    std::unordered_map<uint32_t, InstrumentMarks> instruments_;
+    std::unordered_map<uint64_t, UserTotals> users_;
+};
+
+/**
+ * PnLPublisher
+ *
+ * Decouples PnL publication from PnL computation. The engine marks (user, instrument)
+ * pairs dirty as fills and marks land; collect() emits at most one batch of snapshots
+ * per user per 1/max_rate_hz, and skips snapshots whose fields all moved by less than
+ * epsilon since the last one sent. Engine-thread only (no locking).
+ */
+class PnLPublisher {
+public:
+    explicit PnLPublisher(double max_rate_hz = 60.0, double epsilon = 1e-6);
+
+    // Change the per-user publication rate (<= 0 disables throttling) and change threshold.
+    void configure(double max_rate_hz, double epsilon);
+
+    // Record that the (user, instrument) PnL may have changed.
+    void mark_dirty(uint64_t user_id, uint32_t instrument_id);
+
+    // Append the snapshots that are due at now_ns; users still inside their
+    // interval stay pending and are picked up by a later call.
+    void collect(const PnLEngine& pnl, uint64_t now_ns, std::vector<quant::PnLUpdate>& out);
+
+private:
+    struct UserState {
+        uint64_t last_publish_ns = 0;
+        bool     pending = false;
+        std::vector<uint32_t> dirty;                          // instruments to re-check
+        std::unordered_map<uint32_t, quant::PnLUpdate> sent;  // last snapshot published
+    };
+
+    // True if any field moved by more than epsilon_.
+    bool changed(const quant::PnLUpdate& a, const quant::PnLUpdate& b) const;
 
-    double position_;     // +long, -short (signed)
-    double avg_price_;    // VWAP of open position (price average sign-aware)
-    double realized_pnl_;
-    double unrealized_pnl_;
-    double last_mid_;
+    uint64_t min_interval_ns_;
+    double   epsilon_;
+    std::unordered_map<uint64_t, UserState> users_;
+    std::vector<uint64_t> pending_users_;
 };
 
 } // namespace quant
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "quant/messages.hpp"
+
+namespace quant {
+
+// One point of a PnL curve. Raw samples have equity_min == equity_max == equity;
+// downsampled buckets carry the min/max/last equity seen within the bucket.
+struct PnLSample {
+    uint64_t ts_ms = 0;       // sample time, or bucket start for downsampled tiers
+    double   equity_min = 0;
+    double   equity_max = 0;
+    double   equity = 0;      // last equity
+    double   realized = 0;    // last realized
+    double   position = 0;    // last position
+};
+
+// PnLHistory
+//
+// Ring-buffer history of PnL snapshots per (user, instrument); instrument
+// ALL_INSTRUMENTS holds the user's totals. Tier 0 keeps every recorded snapshot
+// for the last raw_window_ms (a raw tier with capacity 0 is sized to hold the
+// window at raw_rate_hz snapshots per second); each further tier downsamples into
+// fixed-width buckets (min/max/last) in a ring sized to its horizon. Memory per
+// series is fixed and record() is O(#tiers). record() runs on the engine thread; query()
+// may be called from any thread.
+class PnLHistory {
+public:
+    struct Tier {
+        uint32_t bucket_ms;  // 0 => raw samples
+        uint32_t capacity;   // samples / buckets retained
+    };
+
+    // Default: raw for 5 minutes at the 60 Hz publish rate (18001 samples), 1s buckets
+    // for 1 hour, 1m buckets for 1 day.
+    explicit PnLHistory(std::vector<Tier> tiers = {{0, 0}, {1000, 3600}, {60000, 1440}},
+                        uint64_t raw_window_ms = 5 * 60 * 1000, double raw_rate_hz = 60.0);
+
+    // Rate used to size auto-sized raw tiers of series created from now on (<= 0 keeps
+    // the previous rate). Call before recording, e.g. when the publish rate is set.
+    void set_raw_rate(double raw_rate_hz);
+
+    void record(const PnLUpdate& u, uint64_t now_ms);
+
+    // Append the tier's samples with ts_ms >= since_ms, oldest first. Returns false
+    // if the tier does not exist; an unknown series yields no samples.
+    bool query(uint64_t user_id, uint32_t instrument_id, uint8_t tier, uint64_t since_ms,
+               std::vector<PnLSample>& out) const;
+
+    std::size_t tier_count() const { return tiers_.size(); }
+    uint32_t bucket_ms(uint8_t tier) const { return tier < tiers_.size() ? tiers_[tier].bucket_ms : 0; }
+
+private:
+    struct Ring {
+        std::vector<PnLSample> slots;
+        uint64_t written = 0; // raw tier: samples ever written
+        uint64_t last_bucket = 0; // bucketed tier: newest bucket number
+    };
+
+    struct Key {
+        uint64_t user_id;
+        uint32_t instrument_id;
+        bool operator==(const Key& o) const {
+            return user_id == o.user_id && instrument_id == o.instrument_id;
+        }
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& k) const {
+            return std::hash<uint64_t>()(k.user_id * 0x9e3779b97f4a7c15ULL ^ k.instrument_id);
+        }
+    };
+
+    // Slots for tier t of a new series.
+    uint32_t tier_capacity(std::size_t t) const;
+
+    std::vector<Tier> tiers_;
+    uint64_t raw_window_ms_;
+    double raw_rate_hz_;
+    mutable std::mutex mtx_;
+    std::unordered_map<Key, std::vector<Ring>, KeyHash> series_;
+};
+
+} // namespace quant
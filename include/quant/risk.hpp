@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "quant/bs.hpp"
+#include "quant/messages.hpp"
+
+namespace quant {
+
+// Static definition of a listed European option.
+struct OptionSpec {
+    uint32_t instrument_id = 0;
+    uint32_t underlying_id = 0;
+    double   strike = 0;
+    uint64_t expiry_ms = 0;  // wall-clock expiry (ms since epoch)
+    bool     is_call = true;
+    double   iv = 0.2;       // annualized implied vol used for Greeks
+    double   r = 0.0;        // annualized risk-free rate
+};
+
+/**
+ * RiskEngine
+ *
+ * Aggregates Black–Scholes Greeks per (user, underlying). Options are grouped by
+ * underlying in structure-of-arrays form so one bs_greeks_batch() call re-prices
+ * every option on an underlying. A mid, vol or position change only marks its
+ * underlying dirty; recompute() re-prices dirty underlyings at most once per
+ * min_interval and reports the holders whose aggregates changed.
+ */
+class RiskEngine {
+public:
+    explicit RiskEngine(uint64_t min_interval_ns = 100'000'000);
+
+    // Register an option (replaces an existing definition with the same instrument id).
+    void define_option(const OptionSpec& spec);
+    // Update the implied vol of an option; its underlying is re-priced on the next recompute.
+    void set_vol(uint32_t option_instrument_id, double iv);
+
+    // Signed fill (+buy / -sell) of `user_id` in `instrument_id`. Ignored unless the
+    // instrument is a defined option or the underlying of one.
+    void on_fill(uint64_t user_id, uint32_t instrument_id, double signed_qty);
+    // New mid for an instrument; marks it dirty if options are written on it.
+    void on_mark(uint32_t instrument_id, double mid);
+
+    // Re-price dirty underlyings whose throttle interval has elapsed and append one
+    // RiskUpdate per holder whose aggregate Greeks changed.
+    void recompute(uint64_t now_ns, std::vector<RiskUpdate>& out);
+
+    // Current aggregate for (user, underlying), as of the last recompute.
+    RiskUpdate get(uint64_t user_id, uint32_t underlying_id) const;
+
+private:
+    struct Holding {
+        double underlying_qty = 0.0;
+        std::vector<double> option_qty;  // indexed by option slot of the underlying
+        RiskUpdate last;                 // last published aggregate
+        bool published = false;
+    };
+
+    struct Underlying {
+        double   mid = 0.0;
+        bool     dirty = false;
+        uint64_t last_calc_ns = 0;
+        // options on this underlying, structure-of-arrays by slot
+        std::vector<uint32_t> option_ids;
+        std::vector<double>   strike;
+        std::vector<double>   iv;
+        std::vector<double>   r;
+        std::vector<uint64_t> expiry_ms;
+        std::vector<uint8_t>  is_call;
+        std::vector<double>   tau;       // scratch: years to expiry at recompute time
+        std::vector<BSGreeks> greeks;    // scratch: per-slot Greeks
+        std::unordered_map<uint64_t, Holding> holders;
+    };
+
+    struct OptionRef {
+        uint32_t underlying_id;
+        uint32_t slot;
+    };
+
+    void price_underlying(uint32_t underlying_id, Underlying& u, uint64_t now_ns,
+                          std::vector<RiskUpdate>& out);
+
+    mutable std::mutex mtx_;
+    uint64_t min_interval_ns_;
+    std::unordered_map<uint32_t, Underlying> underlyings_;
+    std::unordered_map<uint32_t, OptionRef> options_;
+};
+
+} // namespace quant
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace quant {
+    // Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers:
+    // as easy as 1, 2, 3", SC'11). Output is a pure function of (key, counter), so any
+    // draw can be produced directly from its index with no sequential state.
+    struct Philox4x32 {
+        uint32_t c[4];
+    };
+
+    inline Philox4x32 philox4x32_10(Philox4x32 ctr, uint32_t k0, uint32_t k1) {
+        const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+        const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t(M0) * ctr.c[0];
+            uint64_t p1 = uint64_t(M1) * ctr.c[2];
+            Philox4x32 next;
+            next.c[0] = uint32_t(p1 >> 32) ^ ctr.c[1] ^ k0;
+            next.c[1] = uint32_t(p1);
+            next.c[2] = uint32_t(p0 >> 32) ^ ctr.c[3] ^ k1;
+            next.c[3] = uint32_t(p0);
+            ctr = next;
+            k0 += W0;
+            k1 += W1;
+        }
+        return ctr;
+    }
+
+    // CounterRNG
+    //
+    // Reproducible normal/uniform draws indexed by (path, dim). One Philox block for
+    // counter (path / 2, dim) yields two 53-bit uniforms; Box-Muller turns them into the
+    // normals of paths 2j and 2j+1 at that dim. Streams therefore do not depend on how
+    // paths are split across threads, and a batch over consecutive paths costs one
+    // Philox call and one log/sqrt/sincos per two normals.
+    class CounterRNG {
+    public:
+        explicit CounterRNG(uint64_t seed = 0)
+            : k0_(static_cast<uint32_t>(seed)), k1_(static_cast<uint32_t>(seed >> 32)) {}
+
+        // Uniform in (0, 1) for draw (path, dim); never returns 0 or 1.
+        double uniform(uint64_t path, uint32_t dim) const;
+        // Standard normal for draw (path, dim).
+        double normal(uint64_t path, uint32_t dim) const;
+
+        // out[i] = normal(path0 + i, dim) for i < n. Generates uniforms in blocks and
+        // applies a branch-free Box-Muller (polynomial log/sincos), 4 pairs per AVX2
+        // instruction when the CPU has it; values are identical to normal().
+        void normals(uint64_t path0, std::size_t n, uint32_t dim, double* out) const;
+        // Same draws rounded to float: out[i] = float(normal(path0 + i, dim)).
+        void normals(uint64_t path0, std::size_t n, uint32_t dim, float* out) const;
+        // out[i] = uniform(path0 + i, dim) for i < n.
+        void uniforms(uint64_t path0, std::size_t n, uint32_t dim, double* out) const;
+
+    private:
+        // Two uniforms of the Box-Muller pair for paths (2 * pair, 2 * pair + 1).
+        void uniform_pair(uint64_t pair, uint32_t dim, double& u1, double& u2) const;
+
+        uint32_t k0_;
+        uint32_t k1_;
+    };
+}
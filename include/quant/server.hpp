@@ -1,23 +1,32 @@
 #pragma once
 #include <atomic>
 #include <thread>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 #include "quant/messages.hpp"
 #include "quant/order_book.hpp"
 #include "quant/spsc_queue.hpp"
 #include "quant/pnl.hpp"
+#include "quant/analytics.hpp"
+#include "quant/risk.hpp"
+#include "quant/pnl_history.hpp"
 
 namespace quant {
 
 // MatchingServer
 //
-// Orchestrates intake of client messages, matching via OrderBook,
-// PnL attribution, and emission of server telemetry. Runs an engine
+// Orchestrates intake of client messages, matching via one OrderBook per
+// registered instrument, PnL attribution, and emission of
+// server telemetry. Runs an engine
 // loop thread that drains the input queue and fills the output queue.
 class MatchingServer {
 public:
-    // Construct with bounded SPSC queues for client->server and server->client messages.
-    MatchingServer(std::size_t in_capacity = 4096, std::size_t out_capacity = 4096);
+    // Construct with bounded SPSC queues for client->server and server->client messages;
+    // cost_basis selects average-cost (default) or FIFO lot accounting for PnL.
+    MatchingServer(std::size_t in_capacity = 4096, std::size_t out_capacity = 4096,
+                   CostBasis cost_basis = CostBasis::AverageCost);
     // Join engine thread and release resources.
     ~MatchingServer();
 
@@ -30,10 +39,59 @@ public:
     bool submit_new_order(const MsgNewOrder& m);
     // Non-blocking enqueue of a cancel request; returns false if input queue is full.
     bool submit_cancel(const MsgCancel& m);
+    // Non-blocking enqueue of a quantity amend; returns false if input queue is full.
+    bool submit_amend(const MsgAmend& m);
 
     // Non-blocking dequeue of next server message for network/UI; returns false if none.
+    // This queue has a single consumer (the network thread); in-process strategies read
+    // the strategy feed below instead.
     bool get_next_server_message(ServerMessage& out_msg);
 
+    // Copy TRADE and TOB messages to a separate queue for one in-process strategy (the BS
+    // bot). Off by default, so nothing accumulates without a reader.
+    void enable_strategy_feed(bool on);
+    // Non-blocking dequeue from the strategy feed; returns false if none.
+    bool get_next_strategy_message(ServerMessage& out_msg);
+
+    // Ask the engine thread for a full-depth DEPTH_UPDATE snapshot of both sides of every
+    // book, addressed to one client connection only (ServerMessage::target_client), e.g.
+    // when that consumer connects. Safe to call from any thread.
+    void request_depth_snapshot(uint32_t client_id);
+
+    // Turn the order-by-order (L3_EVENT) feed on/off. Off by default so the engine does not
+    // pay for events nobody consumes.
+    void enable_l3_feed(bool on);
+    // Publish a Reset followed by Add events for every resting order (e.g. for a new L3 subscriber).
+    void request_l3_snapshot();
+
+    // Accept orders for an instrument. Each book pre-allocates its order pool, so books
+    // exist only for registered instruments: DEFAULT_INSTRUMENT_ID from construction,
+    // options and their underlyings from define_option(). A NEW_ORDER naming any other
+    // instrument is rejected. Safe to call from any thread.
+    void register_instrument(uint32_t instrument_id);
+
+    // Register an option instrument so fills in it (and in its underlying) feed the
+    // portfolio Greeks published as RISK_UPDATE; both instruments become tradable.
+    // Safe to call from any thread.
+    void define_option(const OptionSpec& spec);
+    // Update the implied vol used for an option's Greeks. Safe to call from any thread.
+    void set_option_vol(uint32_t option_instrument_id, double iv);
+
+    // Cap PNL_UPDATE publication per user (default 60/s) and suppress snapshots that
+    // moved by less than epsilon. Call before start().
+    void set_pnl_publish_rate(double max_rate_hz, double epsilon = 1e-6);
+
+    // Recorded PnL history of a tracked user (instrument ALL_INSTRUMENTS = totals), one
+    // tier at a time: 0 = raw, higher tiers = coarser buckets. Safe to call from any thread.
+    bool query_pnl_history(uint64_t user_id, uint32_t instrument_id, uint8_t tier, uint64_t since_ms,
+                           std::vector<PnLSample>& out, uint32_t& bucket_ms) const;
+
+    // FIFO lots of (user, instrument): open lots oldest first and the user's lots still in
+    // the closed-lot ring. False (nothing appended) under average-cost accounting.
+    // Safe to call from any thread.
+    bool query_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& open,
+                    std::vector<LotInfo>& closed) const;
+
 private:
     // Single-threaded engine: drain input, apply to OrderBook, update PnL, emit outputs.
     void engine_loop();
@@ -41,37 +99,71 @@ private:
 private:
     // Engine lifecycle state shared with worker thread.
     std::atomic<bool> running_;
+    // Set by request_depth_snapshot(); the engine loop then takes the pending client ids.
+    std::atomic<bool> depth_snapshot_requested_{false};
+    std::mutex depth_snapshot_mtx_;
+    std::vector<uint32_t> depth_snapshot_clients_;
+    // Set by register_instrument(); the engine loop then creates the pending books.
+    std::atomic<bool> instruments_pending_{false};
+    std::mutex instruments_mtx_;
+    std::vector<uint32_t> pending_instruments_;
+    // L3 feed switch and snapshot request; consumed by the engine loop.
+    std::atomic<bool> l3_enabled_{false};
+    std::atomic<bool> l3_snapshot_requested_{false};
+    // Engine-thread buffer the book appends L3 events into while the feed is on.
+    std::vector<L3Event> l3_events_;
     // Client -> Engine bounded queue (single producer: API/network, single consumer: engine thread).
     SPSCQueue<ClientMessage> in_queue_;
     // Engine -> Network/UI bounded queue.
     SPSCQueue<ServerMessage> out_queue_;
-    // Price-time priority order book for matching.
-    OrderBook book_;
+    // Engine -> strategy copy of TRADE/TOB, filled while strategy_feed_ is set.
+    std::atomic<bool> strategy_feed_{false};
+    SPSCQueue<ServerMessage> strategy_queue_;
     // Dedicated engine loop thread.
     std::thread engine_thread_;
 
-    // --- PnL tracking for a specific user (e.g. user_id = 1 from React UI) ---
-    // Primary user id observed by UI for PnL streaming.
-    uint64_t tracked_user_id_;
-    // PnL engine for tracked user.
-    PnLEngine pnl_;
+    // Per-instrument matching state: its own price-time book, analytics and last TOB.
+    struct InstrumentState {
+        explicit InstrumentState(uint32_t id);
+        uint32_t id;
+        OrderBook book;
+        // Bars / rolling VWAP / realized vol computed once here instead of in every consumer.
+        TradeAnalytics analytics;
+        TopOfBook last_tob{};
+        bool have_last_tob = false;
+    };
+    // State of a registered instrument, or nullptr (engine thread only).
+    InstrumentState* find_instrument(uint32_t instrument_id);
+    // Create the books of instruments registered since the last call (engine thread only).
+    void add_pending_instruments();
 
-    // --- NEW: PnL tracking for BS bot (user_id = 9999) ---
-    // PnL engine for BS bot (user_id = 9999) to attribute strategy PnL separately.
-    PnLEngine bs_pnl_;
+    // Queue the (user, instrument) PnL snapshot for publication if the user is tracked.
+    void mark_pnl_dirty(uint64_t user_id, uint32_t instrument_id);
 
-    struct UserPnL {
-        double cash = 0.0;
-        uint64_t position = 0;
-        double realized = 0.0;
-    };
+    std::unordered_map<uint32_t, std::unique_ptr<InstrumentState>> instruments_;
+    std::vector<BarUpdate> closed_bars_;
+
+    // Engine-wide ids so orders/trades stay unique across per-instrument books.
+    uint64_t next_order_id_ = 1;
+    uint64_t next_trade_id_ = 1;
+    // Map resting order_id -> instrument, to route cancels/amends to the right book.
+    std::unordered_map<uint64_t, uint32_t> order_instrument_;
+
+    // Positions for every user, keyed by (user, instrument) and marked per instrument.
+    PnLEngine pnl_;
+    // Users whose PnL is streamed to the UI (UI user 1 and the BS bot).
+    std::vector<uint64_t> tracked_users_;
+    // Scratch list of users re-marked by the last mid change.
+    std::vector<uint64_t> touched_users_;
+    // Coalesces dirty PnL snapshots into rate-limited PNL_UPDATE messages.
+    PnLPublisher pnl_publisher_;
+    std::vector<PnLUpdate> pnl_updates_;
+    // Every published snapshot (and the user's totals) is also appended here.
+    PnLHistory pnl_history_;
 
-    // Lightweight per-user attribution for cash/position/realized, complements PnLEngines.
-    std::unordered_map<uint64_t, UserPnL> user_pnl_;
-    
-    // Map order_id -> user_id (for resting orders & attribution)
-    // Map resting order_id -> user_id for attribution on fills and cancels.
-    std::unordered_map<uint64_t, uint64_t> order_user_;
+    // Per-user, per-underlying option Greeks; re-priced (throttled) when an underlying moves.
+    RiskEngine risk_;
+    std::vector<RiskUpdate> risk_updates_;
 };
 
 } // namespace quant
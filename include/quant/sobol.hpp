@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "quant/rng.hpp"
+
+namespace quant {
+    // SobolSequence
+    //
+    // Sobol low-discrepancy points (Joe & Kuo 2008 direction numbers, new-joe-kuo-6.21201)
+    // for the first SOBOL_MAX_DIM dimensions, 32-bit resolution, in Gray-code order.
+    // With a non-zero scramble_seed each dimension gets a random linear matrix scramble
+    // and digital shift (Matousek), which keeps the net structure while making every
+    // point uniform, so independent scramblings give an unbiased error estimate.
+    // Dimensions >= SOBOL_MAX_DIM are padded with CounterRNG draws keyed by the seed;
+    // with a Brownian bridge those carry little of the variance.
+    class SobolSequence {
+    public:
+        static constexpr uint32_t SOBOL_MAX_DIM = 32;
+
+        SobolSequence(uint32_t dims, uint64_t scramble_seed = 0);
+
+        uint32_t dims() const { return dims_; }
+
+        // Seed of scrambling number `replicate` in a run seeded with seed (never 0).
+        static uint64_t replicate_seed(uint64_t seed, uint64_t replicate);
+
+        // out[i] = coordinate dim of point first + i, mapped to (0, 1) at cell centres.
+        void uniforms(uint64_t first, std::size_t n, uint32_t dim, double* out) const;
+        // Same points through the inverse normal CDF.
+        void normals(uint64_t first, std::size_t n, uint32_t dim, double* out) const;
+
+    private:
+        // Integer coordinate of point index in a Sobol dimension (< SOBOL_MAX_DIM).
+        uint32_t coordinate(uint64_t index, uint32_t dim) const;
+
+        uint32_t dims_;
+        std::vector<uint32_t> v_;       // 32 direction numbers per Sobol dimension
+        std::vector<uint32_t> shift_;   // digital shift per Sobol dimension
+        CounterRNG pad_;
+    };
+}
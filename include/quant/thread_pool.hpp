@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace quant {
+
+class TaskGroup;
+
+// Persistent work-stealing thread pool.
+// - One deque per worker: the owner pushes/pops at the back (LIFO, cache-warm), idle
+//   workers steal from the front of a victim's deque (FIFO, oldest and largest work).
+// - Tasks submitted from outside the pool are spread round-robin over the deques.
+// - Threads that wait on a TaskGroup run queued tasks instead of blocking, so nested
+//   fork/join never deadlocks and the caller's core is not wasted.
+// Deques are guarded by a per-deque mutex; contention is limited to steals.
+class ThreadPool {
+public:
+    // n_workers = 0 => hardware_concurrency() - 1 (the submitting thread also works).
+    // pin_cores pins worker i to CPU (i + 1) % ncpu where supported (Linux).
+    explicit ThreadPool(std::size_t n_workers = 0, bool pin_cores = false);
+    // Drains nothing: pending tasks are dropped; callers join their groups first.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process-wide pool, created on first use with the settings from configure_global().
+    static ThreadPool& global();
+    // Set global() worker count and pinning; only effective before the first global() call.
+    static void configure_global(std::size_t n_workers, bool pin_cores);
+
+    // Number of worker threads (excluding callers that help while waiting).
+    std::size_t size() const { return workers_.size(); }
+
+    // Enqueue fn as part of group (group may be null for fire-and-forget).
+    void submit(std::function<void()> fn, TaskGroup* group = nullptr);
+
+    // Run one queued task on the calling thread if any is available.
+    bool try_run_one();
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        TaskGroup* group;
+    };
+    struct WorkQueue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(std::size_t index);
+    bool pop_local(std::size_t index, Task& out);
+    bool steal(std::size_t thief, Task& out);
+    void run(Task& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<bool> stop_{false};
+
+    // idle workers sleep here until queued_ > 0
+    std::mutex sleep_m_;
+    std::condition_variable sleep_cv_;
+};
+
+// Fork/join scope over a pool: run() forks tasks, wait() joins them. The first
+// exception thrown by a task is rethrown from wait(). The destructor waits.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::global());
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> fn);
+    void wait();
+
+private:
+    friend class ThreadPool;
+    void finish(std::exception_ptr err);
+
+    ThreadPool& pool_;
+    std::atomic<std::size_t> pending_{0};
+    std::mutex m_;
+    std::condition_variable done_cv_;
+    std::exception_ptr error_;
+};
+
+// Call fn(i) for i in [0, n) on the pool and return when all calls have finished.
+// n == 1 (or an empty pool) runs inline on the caller.
+void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn,
+                  ThreadPool& pool = ThreadPool::global());
+
+} // namespace quant
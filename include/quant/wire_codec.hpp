@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "quant/messages.hpp"
+#include "quant/pnl.hpp"
+#include "quant/pnl_history.hpp"
+
+namespace quant {
+
+// Wire encoding shared by every transport (TCP/unix clients, multicast feed).
+// All integers and doubles are big-endian.
+
+// Encode a server message as [4-byte big-endian length][payload bytes] into `out`,
+// replacing its contents. Reusing `out` across calls avoids per-message allocation.
+void encode_server_message(const ServerMessage& msg, std::vector<uint8_t>& out);
+
+// Convenience wrapper returning a freshly allocated frame.
+std::vector<uint8_t> pack_server_message(const ServerMessage& msg);
+
+// Replies that can grow large are split into frames of at most REPLY_CHUNK_ITEMS
+// entries (~48 KB), each with a `more` byte (1 = further frames of this reply follow),
+// so every frame fits one SOCK_SEQPACKET message.
+constexpr std::size_t REPLY_CHUNK_ITEMS = 1024;
+
+// Encode a PNL_HISTORY reply as framed chunks appended to `frames`, samples in order:
+// [user u32][instrument u32][tier u8][bucket_ms u32][more u8][count u32]
+// [count x (ts_ms u64, equity_min f64, equity_max f64, equity f64, realized f64, position f64)]
+void encode_pnl_history(uint32_t user_id, uint32_t instrument_id, uint8_t tier, uint32_t bucket_ms,
+                        const std::vector<PnLSample>& samples,
+                        std::vector<std::vector<uint8_t>>& frames);
+
+// Encode a LOTS reply as framed chunks appended to `frames` (open lots first, then closed):
+// [user u32][instrument u32][more u8][open count u32][open x (qty f64, price f64, realized f64, open_seq u64)]
+// [closed count u32][closed x (qty f64, price f64, realized f64, open_seq u64, close_seq u64)]
+void encode_lots(uint32_t user_id, uint32_t instrument_id, const std::vector<LotInfo>& open,
+                 const std::vector<LotInfo>& closed, std::vector<std::vector<uint8_t>>& frames);
+
+} // namespace quant
@@ -1,2 +1,2 @@
-g++ -std=c++17 -O3 -Iinclude src/order_book.cpp src/bs_bot.cpp src/server.cpp src/network_server.cpp src/market_sim.cpp src/pnl.cpp src/main.cpp -lws2_32 -o matching_server.exe
+g++ -std=c++17 -O3 -Iinclude src/order_book.cpp src/bs_bot.cpp src/server.cpp src/network_server.cpp src/wire_codec.cpp src/multicast_feed.cpp src/analytics.cpp src/market_sim.cpp src/pnl.cpp src/pnl_history.cpp src/risk.cpp src/bs.cpp src/thread_pool.cpp src/rng.cpp src/heston.cpp src/main.cpp -lws2_32 -o matching_server.exe
 ./matching_server
\ No newline at end of file
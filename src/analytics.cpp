@@ -0,0 +1,110 @@
+#include "quant/analytics.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace quant {
+
+static constexpr double SECONDS_PER_YEAR = 365.0 * 24.0 * 3600.0;
+
+TradeAnalytics::TradeAnalytics(uint32_t instrument_id,
+                               std::vector<uint32_t> intervals_ms,
+                               uint32_t window_s)
+    : instrument_id_(instrument_id),
+      intervals_ms_(std::move(intervals_ms)),
+      bars_(intervals_ms_.size()),
+      window_s_(std::max<uint32_t>(1, window_s)),
+      ring_(window_s_)
+{}
+
+void TradeAnalytics::advance(uint64_t second) {
+    if (second <= cur_second_) return;
+    // Only slots that fall out of the window need clearing; a long gap clears all of them.
+    uint64_t steps = std::min<uint64_t>(second - cur_second_, window_s_);
+    for (uint64_t s = second - steps + 1; s <= second; ++s) {
+        Bucket& b = ring_[s % window_s_];
+        tot_notional_ -= b.notional;
+        tot_volume_   -= b.volume;
+        tot_r2_       -= b.sum_r2;
+        b = Bucket{};
+        b.second = s;
+    }
+    cur_second_ = second;
+    // Reset running totals when the window is empty so subtraction error cannot accumulate.
+    if (tot_volume_ <= 0.0) {
+        tot_notional_ = tot_volume_ = tot_r2_ = 0.0;
+    }
+}
+
+void TradeAnalytics::on_trade(double price, uint64_t qty, uint64_t now_ns) {
+    if (price <= 0.0 || qty == 0) return;
+    const uint64_t now_ms = now_ns / 1'000'000;
+
+    // Bars: open on the first trade of an interval, otherwise update in place.
+    for (std::size_t i = 0; i < bars_.size(); ++i) {
+        Bar& b = bars_[i];
+        if (b.trades == 0) {
+            b.start_ms = now_ms - now_ms % intervals_ms_[i];
+            b.open = b.high = b.low = price;
+        } else {
+            b.high = std::max(b.high, price);
+            b.low  = std::min(b.low, price);
+        }
+        b.close = price;
+        b.notional += price * double(qty);
+        b.volume += qty;
+        ++b.trades;
+    }
+
+    // Rolling window.
+    advance(now_ns / 1'000'000'000);
+    Bucket& slot = ring_[cur_second_ % window_s_];
+    const double notional = price * double(qty);
+    slot.notional += notional;
+    slot.volume   += double(qty);
+    tot_notional_ += notional;
+    tot_volume_   += double(qty);
+    if (last_price_ > 0.0) {
+        const double r = std::log(price / last_price_);
+        slot.sum_r2 += r * r;
+        tot_r2_     += r * r;
+    }
+    last_price_ = price;
+}
+
+void TradeAnalytics::roll(uint64_t now_ns, std::vector<BarUpdate>& out) {
+    const uint64_t now_ms = now_ns / 1'000'000;
+    advance(now_ns / 1'000'000'000);
+
+    for (std::size_t i = 0; i < bars_.size(); ++i) {
+        Bar& b = bars_[i];
+        if (b.trades == 0 || now_ms < b.start_ms + intervals_ms_[i]) continue;
+
+        BarUpdate bu;
+        bu.instrument_id = instrument_id_;
+        bu.interval_ms   = intervals_ms_[i];
+        bu.start_ms      = b.start_ms;
+        bu.open          = b.open;
+        bu.high          = b.high;
+        bu.low           = b.low;
+        bu.close         = b.close;
+        bu.volume        = b.volume;
+        bu.trade_count   = b.trades;
+        bu.vwap          = b.notional / double(b.volume);
+        bu.rolling_vwap  = rolling_vwap();
+        bu.realized_vol  = realized_vol();
+        out.push_back(bu);
+
+        b = Bar{};
+    }
+}
+
+double TradeAnalytics::rolling_vwap() const {
+    return tot_volume_ > 0.0 ? tot_notional_ / tot_volume_ : 0.0;
+}
+
+double TradeAnalytics::realized_vol() const {
+    const double r2 = std::max(0.0, tot_r2_);
+    return std::sqrt(r2 * SECONDS_PER_YEAR / double(window_s_));
+}
+
+} // namespace quant
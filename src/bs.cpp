@@ -1,4 +1,6 @@
 #include "quant/bs.hpp"
+#include "quant/thread_pool.hpp"
+#include <algorithm>
 
 namespace quant {
     // -----------------------------------------
@@ -14,6 +16,42 @@ namespace quant {
         return 0.5 * (1.0 + std::erf(x / std::sqrt(2.0)));
     }
 
+    double norm_inv_cdf(double p) {
+        static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                                    -2.759285104469687e+02, 1.383577518672690e+02,
+                                    -3.066479806614716e+01, 2.506628277459239e+00};
+        static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                                    -1.556989798598866e+02, 6.680131188771972e+01,
+                                    -1.328068155288572e+01};
+        static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                                    -2.400758277161838e+00, -2.549732539343734e+00,
+                                    4.374664141464968e+00, 2.938163982698783e+00};
+        static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+                                    2.445134137142996e+00, 3.754408661907416e+00};
+        static const double P_LOW = 0.02425;
+
+        // Φ^-1(p) = -Φ^-1(1 - p); 1 - p is exact for p >= 0.5, and the lower half
+        // avoids the cancellation of Φ(x) - p near 1 in the refinement step.
+        if (p > 0.5) return -norm_inv_cdf(1.0 - p);
+
+        double x;
+        if (p < P_LOW) {
+            double q = std::sqrt(-2.0 * std::log(p));
+            x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+        } else {
+            double q = p - 0.5;
+            double r = q * q;
+            x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+                (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+        }
+
+        // Halley step on Φ(x) - p (erfc keeps the lower tail accurate)
+        double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+        double u = e * 2.5066282746310002 * std::exp(0.5 * x * x);   // e / φ(x)
+        return x - u / (1.0 + 0.5 * x * u);
+    }
+
     // -----------------------------------------
     // Black-Scholes d1, d2
     // -----------------------------------------
@@ -93,4 +131,55 @@ namespace quant {
         return -in.K * in.T * std::exp(-in.r * in.T) * norm_cdf(-d2(in));
     }
 
-}
\ No newline at end of file
+    // -----------------------------------------
+    // Batched Greeks
+    // -----------------------------------------
+
+    // Options per pool task in bs_greeks_batch; smaller batches run on the caller.
+    static constexpr std::size_t BS_BATCH_CHUNK = 4096;
+
+    static void bs_greeks_range(double S, const double* r, const double* K, const double* sigma,
+                                const double* T, const uint8_t* is_call, std::size_t begin,
+                                std::size_t end, BSGreeks* out) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (T[i] <= 0.0 || sigma[i] <= 0.0 || S <= 0.0) {
+                double itm = is_call[i] ? (S > K[i] ? 1.0 : 0.0) : (S < K[i] ? -1.0 : 0.0);
+                out[i] = BSGreeks{itm, 0.0, 0.0, 0.0};
+                continue;
+            }
+            double sqrt_t = std::sqrt(T[i]);
+            double sig_sqrt_t = sigma[i] * sqrt_t;
+            double D1 = (std::log(S / K[i]) + (r[i] + 0.5 * sigma[i] * sigma[i]) * T[i]) / sig_sqrt_t;
+            double D2 = D1 - sig_sqrt_t;
+            double pdf = norm_pdf(D1);
+            double disc_k = r[i] * K[i] * std::exp(-r[i] * T[i]);
+            double decay = -(S * pdf * sigma[i]) / (2.0 * sqrt_t);
+
+            BSGreeks g;
+            g.gamma = pdf / (S * sig_sqrt_t);
+            g.vega  = S * pdf * sqrt_t;
+            if (is_call[i]) {
+                g.delta = norm_cdf(D1);
+                g.theta = decay - disc_k * norm_cdf(D2);
+            } else {
+                g.delta = norm_cdf(D1) - 1.0;
+                g.theta = decay + disc_k * norm_cdf(-D2);
+            }
+            out[i] = g;
+        }
+    }
+
+    void bs_greeks_batch(double S, const double* r, const double* K, const double* sigma,
+                         const double* T, const uint8_t* is_call, std::size_t n,
+                         BSGreeks* out) {
+        if (n <= BS_BATCH_CHUNK) {
+            bs_greeks_range(S, r, K, sigma, T, is_call, 0, n, out);
+            return;
+        }
+        parallel_for((n + BS_BATCH_CHUNK - 1) / BS_BATCH_CHUNK, [&](std::size_t c) {
+            const std::size_t begin = c * BS_BATCH_CHUNK;
+            bs_greeks_range(S, r, K, sigma, T, is_call, begin, std::min(n, begin + BS_BATCH_CHUNK), out);
+        });
+    }
+
+}
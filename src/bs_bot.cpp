@@ -58,6 +58,7 @@ BSBot::~BSBot() {
 void BSBot::start() {
     if (running_) return;
     running_ = true;
+    engine_->enable_strategy_feed(true);
     thread_ = std::thread(&BSBot::thread_loop, this);
 }
 
@@ -65,11 +66,13 @@ void BSBot::stop() {
     if (!running_) return;
     running_ = false;
     if (thread_.joinable()) thread_.join();
+    engine_->enable_strategy_feed(false);
 }
 
 void BSBot::set_iv(double iv) {
     std::lock_guard<std::mutex> g(mtx_);
     cfg_.iv = iv;
+    engine_->set_option_vol(cfg_.option_instrument, iv);
 }
 
 uint64_t BSBot::post_limit_order(uint32_t instrument, uint8_t side, double price, uint64_t qty) {
@@ -108,8 +111,8 @@ void BSBot::thread_loop() {
 
         // --------- Consume TOB and TRADE messages ---------
         ServerMessage sm;
-        while (engine_->get_next_server_message(sm)) {
-            if (sm.type == TOB) {
+        while (engine_->get_next_strategy_message(sm)) {
+            if (sm.type == TOB && sm.tob.instrument_id == cfg_.underlying_instrument) {
                 double mid = 0.0;
                 if (sm.tob.bid_price > 0.0 && sm.tob.ask_price > 0.0)
                     mid = 0.5 * (sm.tob.bid_price + sm.tob.ask_price);
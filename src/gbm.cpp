@@ -11,18 +11,19 @@ namespace quant{
     }
 
     GBM::GBM(double S0, double mu, double sigma, uint64_t seed) 
-        : S0_(S0), mu_(mu), sigma_(sigma), nd_(0.0, 1.0), seed_(seed){
+        : S0_(S0), mu_(mu), sigma_(sigma), seed_(seed){
             if(seed_ == 0) seed_ = default_time_seed();
-            rng_.seed(seed_);
+            rng_ = CounterRNG(seed_);
         }
     
     void GBM::reseed(uint64_t seed){
         seed_ = (seed == 0) ? default_time_seed() : seed;
-        rng_.seed(seed_);
+        rng_ = CounterRNG(seed_);
+        next_draw_ = 0;
     }
 
     double GBM::sample_terminal(double T){
-        double z = nd_(rng_);
+        double z = rng_.normal(next_draw_++, 0);
         double drift = (mu_ - 0.5*sigma_*sigma_) * T;
         double vol = sigma_ * sqrt(T);
         return S0_ * exp(drift + vol * z);
@@ -32,7 +33,8 @@ namespace quant{
         vector<double> path;
         path.reserve(n_steps + 1);
         path.push_back(S0_);
-        if (n_steps = 0) return path;
+        if (n_steps == 0) return path;
+        const uint64_t draw = next_draw_++;
 
         double dt = T / static_cast<double>(n_steps);
         double drift_dt = (mu_ - 0.5*sigma_*sigma_) * dt;
@@ -40,7 +42,7 @@ namespace quant{
 
         double S = S0_;
         for(size_t i = 0; i < n_steps; i++){
-            double z = nd_(rng_);
+            double z = rng_.normal(draw, static_cast<uint32_t>(i));
             S = S * exp(drift_dt + vol_sqrt_dt * z);
             path.push_back(S);
         }
@@ -48,13 +50,14 @@ namespace quant{
     }
 
     vector<double> GBM::sample_terminal_batch(size_t n_paths, double T){
-        vector<double> out;
-        out.reserve(n_paths);
+        vector<double> out(n_paths);
         double drifts = (mu_ - 0.5*sigma_*sigma_) * T;
         double vol = sigma_ * sqrt(T);
+        // draw the normals in one vectorised batch, then map them in place
+        rng_.normals(next_draw_, n_paths, 0, out.data());
+        next_draw_ += n_paths;
         for(size_t i = 0; i < n_paths; i++){
-            double z = nd_(rng_);
-            out.push_back(S0_ * exp(drifts + vol * z));
+            out[i] = S0_ * exp(drifts + vol * out[i]);
         }
         return out;
     }
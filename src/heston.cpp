@@ -0,0 +1,89 @@
+#include "quant/heston.hpp"
+#include "quant/bs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace quant {
+    HestonQEStep::HestonQEStep(const HestonParams& p, double mu, double dt)
+        : theta(p.theta), xi(p.xi) {
+        const double kappa = std::max(p.kappa, 1e-12);
+        e_kdt = std::exp(-kappa * dt);
+        c1 = xi * xi * e_kdt * (1.0 - e_kdt) / kappa;
+        c2 = theta * xi * xi * (1.0 - e_kdt) * (1.0 - e_kdt) / (2.0 * kappa);
+
+        // Andersen (2008) eq. 33 with gamma1 = gamma2 = 1/2; xi = 0 degenerates to
+        // the Euler integral of a deterministic variance.
+        const double half_dt = 0.5 * dt;
+        const double rho_xi = xi > 0.0 ? p.rho / xi : 0.0;
+        k0 = mu * dt - rho_xi * kappa * theta * dt;
+        k1 = half_dt * (kappa * rho_xi - 0.5) - rho_xi;
+        k2 = half_dt * (kappa * rho_xi - 0.5) + rho_xi;
+        k3 = half_dt * (1.0 - p.rho * p.rho);
+        k4 = k3;
+        if (xi <= 0.0) {
+            k3 = half_dt;
+            k4 = half_dt;
+        }
+    }
+
+    // a (b + zv)^2 with a, b matched to the mean m and variance psi m^2.
+    double HestonQEStep::quadratic_variance(double m, double psi, double zv) {
+        const double inv_psi2 = 2.0 / psi;
+        const double b2 = inv_psi2 - 1.0 + std::sqrt(inv_psi2) * std::sqrt(inv_psi2 - 1.0);
+        const double a = m / (1.0 + b2);
+        const double b = std::sqrt(b2) + zv;
+        return a * b * b;
+    }
+
+    // Point mass p at 0, exponential above, with u = N(zv).
+    double HestonQEStep::exponential_variance(double m, double psi, double zv) {
+        const double p = (psi - 1.0) / (psi + 1.0);
+        const double u = norm_cdf(zv);
+        return u <= p ? 0.0 : std::log((1.0 - p) / (1.0 - u)) * m / (1.0 - p);
+    }
+
+    void HestonQEStep::step(double& x, double& v, double zv, double z) const {
+        const double m = theta + (v - theta) * e_kdt;
+        const double s2 = v * c1 + c2;
+        double v_next;
+        if (m <= 0.0) {
+            v_next = 0.0;
+        } else if (s2 <= 0.0) {
+            v_next = m;   // xi = 0: deterministic variance
+        } else {
+            const double psi = s2 / (m * m);
+            v_next = psi <= 1.5 ? quadratic_variance(m, psi, zv) : exponential_variance(m, psi, zv);
+        }
+        x += k0 + k1 * v + k2 * v_next + std::sqrt(std::max(0.0, k3 * v + k4 * v_next)) * z;
+        v = v_next;
+    }
+
+    static uint64_t default_time_seed() {
+        return static_cast<uint64_t>(
+            std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    }
+
+    HestonProcess::HestonProcess(double S0, double mu, const HestonParams& p, uint64_t seed)
+        : S0_(S0), mu_(mu), p_(p), rng_(seed == 0 ? default_time_seed() : seed), v_(p.v0),
+          qe_(p, mu, 0.0) {}
+
+    void HestonProcess::reseed(uint64_t seed) {
+        rng_ = CounterRNG(seed == 0 ? default_time_seed() : seed);
+        x_ = 0.0;
+        v_ = p_.v0;
+        n_steps_ = 0;
+    }
+
+    double HestonProcess::step(double dt) {
+        if (dt != dt_) {
+            qe_ = HestonQEStep(p_, mu_, dt);
+            dt_ = dt;
+        }
+        const double zv = rng_.normal(n_steps_, 0);
+        const double z = rng_.normal(n_steps_, 1);
+        ++n_steps_;
+        qe_.step(x_, v_, zv, z);
+        return spot();
+    }
+}
@@ -5,6 +5,8 @@
 #include "quant/bs_bot.hpp"
 
 #include <iostream>
+#include <cstdlib>
+#include <string>
 #include <chrono>
 #include <thread>
 
@@ -20,7 +22,12 @@ int main() {
 #endif
 
     std::cout << "=== Starting Matching Engine ===\n";
-    quant::MatchingServer engine(4096, 4096);
+    // QUANT_COST_BASIS=fifo switches PnL to FIFO lot accounting (default: average cost).
+    quant::CostBasis basis = quant::CostBasis::AverageCost;
+    if (const char* cb = std::getenv("QUANT_COST_BASIS")) {
+        if (std::string(cb) == "fifo") basis = quant::CostBasis::FIFO;
+    }
+    quant::MatchingServer engine(4096, 4096, basis);
     engine.start();
 
     std::cout << "=== Starting Monte Carlo Market Simulator ===\n";
@@ -30,8 +37,19 @@ int main() {
         /*mu*/   0.0,
         /*sigma*/0.20,
         /*dt*/   0.15,
-        /*tick*/ 0.01
+        /*tick*/ 0.01,
+        /*instrument*/ quant::DEFAULT_INSTRUMENT_ID
     );
+    // QUANT_SIM_HESTON=1 drives the simulated price with Heston stochastic volatility
+    // (v0 = theta = 0.2^2) instead of the mean-reverting log process.
+    if (const char* hs = std::getenv("QUANT_SIM_HESTON")) {
+        if (std::string(hs) == "1") {
+            quant::HestonParams hp;
+            hp.v0 = 0.04;
+            hp.theta = 0.04;
+            sim.use_heston(hp);
+        }
+    }
     sim.start();
 
     std::cout << "=== Starting Black-Scholes Market-Making Bot ===\n";
@@ -48,11 +66,36 @@ int main() {
     cfg.qty = 5.0;
     cfg.hedge_tolerance = 0.5;
 
+    // Register the bot's option so its book feeds portfolio Greeks (RISK_UPDATE).
+    quant::OptionSpec opt;
+    opt.instrument_id = cfg.option_instrument;
+    opt.underlying_id = cfg.underlying_instrument;
+    opt.strike        = cfg.strike;
+    opt.expiry_ms     = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count())
+                      + static_cast<uint64_t>(cfg.expiry_seconds * 1000.0);
+    opt.is_call       = cfg.opt_type == quant::OptionType::Call;
+    opt.iv            = cfg.iv;
+    opt.r             = cfg.r;
+    engine.define_option(opt);
+
     quant::BSBot bot(&engine, cfg);
     bot.start();
 
     std::cout << "=== Starting TCP Network Server on port 9001 ===\n";
     quant::NetworkServer net(&engine, 9001);
+#if !QPLAT_WINDOWS
+    // Co-located consumers (the bridge) can skip loopback TCP via this path.
+    net.listen_unix("/tmp/quant_engine.sock");
+#endif
+    // Optional multicast market-data feed, e.g. QUANT_MCAST=239.1.1.1:30001
+    if (const char* mc = std::getenv("QUANT_MCAST")) {
+        std::string spec(mc);
+        auto colon = spec.find(':');
+        if (colon != std::string::npos) {
+            net.enable_multicast(spec.substr(0, colon), std::atoi(spec.c_str() + colon + 1));
+        }
+    }
     net.start();
 
     std::cout << "System ready. Press Ctrl+C to exit.\n";
@@ -9,8 +9,10 @@ MarketSimulator::MarketSimulator(MatchingServer* engine,
                                  double mu,
                                  double sigma,
                                  double dt_seconds,
-                                 double tick_size)
+                                 double tick_size,
+                                 uint32_t instrument_id)
     : engine_(engine),
+      instrument_id_(instrument_id),
       running_(false),
       s_(s0),
       mu_(mu),
@@ -25,12 +27,19 @@ MarketSimulator::MarketSimulator(MatchingServer* engine,
     // but we now use a mean-reverting log process in loop()).
     drift_term_ = (mu_ - 0.5 * sigma_ * sigma_) * dt_;
     vol_term_   = sigma_ * std::sqrt(dt_);
+
+    engine_->register_instrument(instrument_id_);
 }
 
 MarketSimulator::~MarketSimulator() {
     stop();
 }
 
+void MarketSimulator::use_heston(const HestonParams& params, uint64_t seed) {
+    if (running_) return;
+    heston_.reset(new HestonProcess(s_, mu_, params, seed));
+}
+
 void MarketSimulator::start() {
     if (running_) return;
     running_ = true;
@@ -49,6 +58,7 @@ void MarketSimulator::send_limit_order(uint8_t side, double price, uint64_t qty)
     m.side     = side;     // 0 = buy, 1 = sell
     m.price    = price;
     m.quantity = qty;
+    m.instrument_id = instrument_id_;
     engine_->submit_new_order(m);
 }
 
@@ -60,18 +70,23 @@ void MarketSimulator::loop() {
     const double kappa      = 1.0;     // mean reversion speed
 
     while (running_) {
-        // 1) advance a mean-reverting *log-price* process
-        double z = norm_(rng_);
-
-        // work in log space
-        double logS     = std::log(std::max(s_, tick_));   // avoid log(0)
-        double logMean  = std::log(mean_level);
-
-        // Ornstein–Uhlenbeck on log S:
-        // d logS = kappa (logMean - logS) dt + sigma dW
-        logS += kappa * (logMean - logS) * dt_ + sigma_ * std::sqrt(dt_) * z;
-
-        s_ = std::exp(logS);
+        // 1) advance the price: Heston when configured, otherwise a mean-reverting
+        //    *log-price* process
+        if (heston_) {
+            s_ = heston_->step(dt_);
+        } else {
+            double z = norm_(rng_);
+
+            // work in log space
+            double logS     = std::log(std::max(s_, tick_));   // avoid log(0)
+            double logMean  = std::log(mean_level);
+
+            // Ornstein–Uhlenbeck on log S:
+            // d logS = kappa (logMean - logS) dt + sigma dW
+            logS += kappa * (logMean - logS) * dt_ + sigma_ * std::sqrt(dt_) * z;
+
+            s_ = std::exp(logS);
+        }
 
         // 2) round to ticks
         auto round_to_tick = [&](double x) {
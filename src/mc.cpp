@@ -1,9 +1,12 @@
 #include "quant/mc.hpp"
 #include "quant/gbm.hpp"
 #include "quant/bs.hpp"
-#include <thread>
+#include "quant/rng.hpp"
+#include "quant/sobol.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/thread_pool.hpp"
+#include <atomic>
 #include <vector>
-#include <random>
 #include <chrono>
 #include <cmath>
 #include <algorithm>
@@ -12,30 +15,241 @@
 #include <iostream>
 
 namespace quant {
+    // Draws per pool task: large enough to amortise scheduling, small enough to
+    // balance across uneven cores.
+    static constexpr std::size_t MC_CHUNK_DRAWS = 16384;
+    // First adaptive batch, in chunks. Fixed rather than tied to the worker count so
+    // the stopping point (and so the result) does not depend on the machine.
+    static constexpr std::size_t MC_ADAPTIVE_MIN_BATCH = 8;
+
     // Fallback seed source if user does not provide a seed.
-    static uint64_t default_time_seed() {
+    uint64_t mc_resolve_seed(uint64_t seed) {
+        if (seed != 0) return seed;
         return static_cast<uint64_t>(
             std::chrono::high_resolution_clock::now().time_since_epoch().count());
     }
 
-    // Internal struct for per-thread accumulators (no allocations inside loops)
-    // Per-thread accumulators to avoid contention and allocations in the hot path.
-    struct ThreadAcc {
-        // sums for payoff (Y) and control (X = S_T)
-        long double sumY = 0.0L;
-        long double sumY2 = 0.0L;
-        long double sumX = 0.0L;
-        long double sumX2 = 0.0L;
-        long double sumYX = 0.0L;
-        std::size_t n = 0;
+    // Per-chunk accumulators of the Greek estimators.
+    struct GreekMoments {
+        Moments delta, gamma, vega, rho;
+
+        void merge(const GreekMoments& o) {
+            delta.merge(o.delta);
+            gamma.merge(o.gamma);
+            vega.merge(o.vega);
+            rho.merge(o.rho);
+        }
     };
 
-    // Vanilla terminal payoffs.
-    static inline double payoff_call(double ST, double K) {
-        return std::max(0.0, ST - K);
+    // Single-pass Greek estimators for a European vanilla under GBM, from S_T and its
+    // normal z (S_T = S0 exp((r - sigma^2/2) T + sigma sqrt(T) z)):
+    //   delta = disc * 1{itm} * S_T / S0                       (pathwise)
+    //   vega  = disc * 1{itm} * S_T * (sqrt(T) z - sigma T)    (pathwise, dS_T/dsigma)
+    //   rho   = disc * 1{itm} * K T                            (pathwise)
+    //   gamma = delta / S0 * (z / (sigma sqrt(T)) - 1)         (likelihood ratio on delta)
+    // with signs flipped for puts. With sigma sqrt(T) == 0, S_T is deterministic: delta
+    // is the intrinsic one and gamma and vega are 0, as in bs_greeks_batch.
+    struct GreekSampler {
+        double S0, K, sigma, T, disc;
+        bool is_call;
+
+        void add(GreekMoments& g, double ST, double z) const {
+            const double sqrtT = std::sqrt(T);
+            const double vol = sigma * sqrtT;
+            const bool itm = is_call ? ST > K : ST < K;
+            const double w = itm ? (is_call ? disc : -disc) : 0.0;
+            const double delta = w * ST / S0;
+            g.delta.add(delta);
+            g.vega.add(vol > 0.0 ? w * ST * (sqrtT * z - sigma * T) : 0.0);
+            g.rho.add(w * K * T);
+            g.gamma.add(vol > 0.0 ? delta / S0 * (z / vol - 1.0) : 0.0);
+        }
+    };
+
+    // Greeks and standard errors from per-chunk accumulators (replicate-major). With
+    // several replicates (QMC) the error comes from the spread of replicate means.
+    static MCGreeks greeks_from_chunks(std::vector<GreekMoments>& chunks, std::size_t n_reps,
+                                       std::size_t chunks_per_rep) {
+        MCGreeks out;
+        auto fill = [](const Moments& m, double& value, double& se) {
+            value = m.mean;
+            se = m.n > 0 ? std::sqrt(m.var() / static_cast<double>(m.n)) : 0.0;
+        };
+        if (n_reps <= 1) {
+            const GreekMoments total = merge_pairwise(chunks.data(), chunks.size());
+            fill(total.delta, out.delta, out.delta_se);
+            fill(total.gamma, out.gamma, out.gamma_se);
+            fill(total.vega, out.vega, out.vega_se);
+            fill(total.rho, out.rho, out.rho_se);
+            return out;
+        }
+        GreekMoments spread;   // moments of the replicate means
+        for (std::size_t r = 0; r < n_reps; ++r) {
+            const GreekMoments rep = merge_pairwise(&chunks[r * chunks_per_rep], chunks_per_rep);
+            spread.delta.add(rep.delta.mean);
+            spread.gamma.add(rep.gamma.mean);
+            spread.vega.add(rep.vega.mean);
+            spread.rho.add(rep.rho.mean);
+        }
+        fill(spread.delta, out.delta, out.delta_se);
+        fill(spread.gamma, out.gamma, out.gamma_se);
+        fill(spread.vega, out.vega, out.vega_se);
+        fill(spread.rho, out.rho, out.rho_se);
+        return out;
     }
-    static inline double payoff_put(double ST, double K) {
-        return std::max(0.0, K - ST);
+
+    MCResult mc_result_from_moments(const PairMoments& total, double EX, double disc, bool use_cv) {
+        const std::size_t N = total.n;
+        if (N == 0) {
+            return MCResult{};
+        }
+
+        // Sample means on undiscounted payoffs (Y) and control variate (X = S_T).
+        const double meanY = total.meanY;
+        const double meanX = total.meanX;
+
+        // Covariance and variance (unbiased, N-1) for optimal control variate coefficient.
+        const double covYX = total.cov_yx();
+        const double varX = total.var_x();
+        const double varY = total.var_y();
+
+        double b_opt = 0.0;
+        if (use_cv && varX > 0.0) {
+            b_opt = covYX / varX;
+        }
+
+        // Construct adjusted estimator (undiscounted) with optimal b: Y_cv = Y - b*(X - E[X]).
+        // mean(Y_cv) = meanY - b*(meanX - EX)
+        const double meanYcv = meanY - b_opt * (meanX - EX);
+
+        // Variance of adjusted estimator: var(Y - bX) = varY - 2 b covYX + b^2 varX; clamp at 0 for safety.
+        double varYcv = varY - 2.0 * b_opt * covYX + b_opt * b_opt * varX;
+        if (varYcv < 0.0) varYcv = 0.0; // numerical safety
+
+        // Discount to present value.
+        const double price = disc * meanYcv;
+        const double stderr_ = std::sqrt(varYcv / static_cast<double>(N)) * disc;
+
+        // Symmetric 95% normal-approximation confidence interval.
+        const double z95 = 1.959963984540054; // ~1.96
+        const double ci_low  = price - z95 * stderr_;
+        const double ci_high = price + z95 * stderr_;
+
+        MCResult res;
+        res.price = price;
+        res.stderr_ = stderr_;
+        res.ci_low = ci_low;
+        res.ci_high = ci_high;
+        res.n_samples = N;
+        return res;
+    }
+
+    MCResult mc_result_from_replicates(const std::vector<PairMoments>& reps, double EX, double disc,
+                                       bool use_cv) {
+        std::vector<PairMoments> parts(reps);
+        const PairMoments pooled = merge_pairwise(parts.data(), parts.size());
+        const std::size_t R = reps.size();
+        if (R < 2 || pooled.n == 0) return mc_result_from_moments(pooled, EX, disc, use_cv);
+
+        double b_opt = 0.0;
+        if (use_cv && pooled.var_x() > 0.0) b_opt = pooled.cov_yx() / pooled.var_x();
+
+        // one estimate per scrambling; each is unbiased, so their spread is the error
+        PairMoments est;
+        for (const PairMoments& m : reps) {
+            est.add(disc * (m.meanY - b_opt * (m.meanX - EX)), 0.0);
+        }
+        const double price = est.meanY;
+        const double stderr_ = std::sqrt(est.var_y() / static_cast<double>(R));
+
+        // Student-t 97.5% quantile with R - 1 dof (Cornish-Fisher expansion around z).
+        const double z = 1.959963984540054;
+        const double nu = static_cast<double>(R - 1);
+        const double t = z + (z * z * z + z) / (4.0 * nu) +
+                         (5.0 * std::pow(z, 5) + 16.0 * z * z * z + 3.0 * z) / (96.0 * nu * nu);
+
+        MCResult res;
+        res.price = price;
+        res.stderr_ = stderr_;
+        res.ci_low = price - t * stderr_;
+        res.ci_high = price + t * stderr_;
+        res.n_samples = pooled.n;
+        return res;
+    }
+
+    void mc_for_each_chunk(std::size_t n, const MCOptions& opts, const std::function<void(std::size_t)>& fn) {
+        if (opts.n_threads == 1 || n <= 1) {
+            for (std::size_t c = 0; c < n; ++c) fn(c);
+        } else if (opts.n_threads == 0 || opts.n_threads >= n) {
+            parallel_for(n, fn);
+        } else {
+            // the caller runs one of the tasks, so no more than n_threads chunks overlap
+            std::atomic<std::size_t> next{0};
+            parallel_for(opts.n_threads, [&](std::size_t) {
+                for (std::size_t c = next++; c < n; c = next++) fn(c);
+            });
+        }
+    }
+
+    std::size_t mc_run_chunks(std::size_t n_chunks, const MCOptions& opts,
+                              const std::function<void(std::size_t)>& price_chunk,
+                              const std::function<double(std::size_t)>& stderr_of) {
+        auto run_range = [&](std::size_t begin, std::size_t end) {
+            mc_for_each_chunk(end - begin, opts, [&](std::size_t i) { price_chunk(begin + i); });
+        };
+
+        const bool adaptive = !opts.use_qmc &&
+            (opts.target_stderr > 0.0 || opts.target_ci_width > 0.0 || opts.time_budget_ms > 0.0);
+        if (!adaptive) {
+            run_range(0, n_chunks);
+            return n_chunks;
+        }
+
+        // The CI is +-z95 * stderr, so a width target is a stderr target; 0 = budget only.
+        double target = opts.target_stderr;
+        if (opts.target_ci_width > 0.0) {
+            const double se_ci = opts.target_ci_width / (2.0 * 1.959963984540054);
+            target = target > 0.0 ? std::min(target, se_ci) : se_ci;
+        }
+        const double budget_ms = opts.time_budget_ms;
+
+        // Batch sizes depend only on the stderr path, never on timing or threads, unless
+        // a time budget cuts the run short.
+        const std::size_t min_batch = MC_ADAPTIVE_MIN_BATCH;
+
+        const auto start = std::chrono::steady_clock::now();
+        std::size_t done = 0;
+        std::size_t batch = std::min(n_chunks, min_batch);
+        while (batch > 0) {
+            run_range(done, done + batch);
+            done += batch;
+            if (done >= n_chunks) break;
+
+            const double se = stderr_of(done);
+            if (target > 0.0 && se <= target) break;
+
+            // Paths still needed at the current variance (stderr ~ 1/sqrt(n)), 5% margin.
+            std::size_t next = done;
+            if (target > 0.0 && se > 0.0) {
+                const double ratio = se / target;
+                const double need = 1.05 * static_cast<double>(done) * ratio * ratio;
+                next = static_cast<std::size_t>(std::ceil(need)) - done;
+            }
+            next = std::min(std::max(next, min_batch), std::min(done, n_chunks - done));
+
+            if (budget_ms > 0.0) {
+                const double elapsed = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start).count();
+                const double per_chunk = elapsed / static_cast<double>(done);
+                const double room = budget_ms - elapsed;
+                if (room <= 0.0) break;
+                if (per_chunk > 0.0) {
+                    next = std::min(next, static_cast<std::size_t>(room / per_chunk));
+                }
+            }
+            batch = next;
+        }
+        return done;
     }
 
     MCResult monte_carlo_terminal(
@@ -48,192 +262,193 @@ namespace quant {
         double (*bs_price_fn)(double, double, double, double, double)
     ) {
         MCOptions local_opts = opts;
-        // Resolve thread count and seed defaults.
-        if (local_opts.n_threads == 0) {
-            local_opts.n_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
-        }
-        if (local_opts.seed == 0) local_opts.seed = default_time_seed();
+        local_opts.seed = mc_resolve_seed(local_opts.seed);
 
-        const std::size_t n_total = local_opts.n_paths;
-        const std::size_t n_threads = std::min(local_opts.n_threads, n_total);
-        const bool use_antithetic = local_opts.use_antithetic;
+        // QMC splits the paths over independent scramblings (replicates); pseudo-random
+        // runs are a single replicate.
+        const bool use_qmc = local_opts.use_qmc;
+        const bool use_antithetic = local_opts.use_antithetic && !use_qmc;
         const bool use_cv = local_opts.use_control_variate;
-
-        // Determine per-thread workloads. We'll split as evenly as possible.
-        std::vector<std::size_t> counts(n_threads, n_total / n_threads);
-        for (std::size_t i = 0; i < (n_total % n_threads); ++i) counts[i]++;
-
-        // If antithetic, ensure each thread handles an even number of draws (pairs) to maintain pairing.
-        if (use_antithetic) {
-            for (std::size_t i = 0; i < n_threads; ++i) {
-                if (counts[i] % 2 != 0) {
-                    // borrow one from another thread if possible, else increment to next even
-                    counts[i]++;
-                    // adjust total counts if we exceed n_total -- that's ok; we'll report effective samples
-                }
+        const std::size_t n_reps = use_qmc ? std::max<std::size_t>(2, local_opts.qmc_scrambles) : 1;
+
+        // Counter-based draws: normal(d, 0) is draw d of the run (a path, or an antithetic
+        // pair), so any chunk of draw indices can be priced independently. Under QMC,
+        // draw d of a replicate is Sobol point d of its scrambling.
+        const std::size_t n_draws = use_qmc ? (local_opts.n_paths + n_reps - 1) / n_reps
+                                  : use_antithetic ? (local_opts.n_paths + 1) / 2 : local_opts.n_paths;
+        const std::size_t chunks_per_rep = (n_draws + MC_CHUNK_DRAWS - 1) / MC_CHUNK_DRAWS;
+        const std::size_t n_chunks = n_reps * chunks_per_rep;
+        const CounterRNG rng(local_opts.seed);
+        std::vector<SobolSequence> sobol;
+        if (use_qmc) {
+            sobol.reserve(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                sobol.emplace_back(1, SobolSequence::replicate_seed(local_opts.seed, r));
             }
         }
 
-        // Container for per-thread accumulators
-        std::vector<ThreadAcc> acc(n_threads);
-
-        // We'll spawn threads and accumulate locally (no mutexes in hot loop).
-        std::vector<std::thread> workers;
-        workers.reserve(n_threads);
-
-        // Prepare distinct per-thread seeds using seed_seq for reproducibility while avoiding correlation.
-        std::vector<uint32_t> seq_input;
-        seq_input.reserve(8);
-        seq_input.push_back(static_cast<uint32_t>(local_opts.seed & 0xFFFFFFFFu)); //Lower 32 bit
-        seq_input.push_back(static_cast<uint32_t>((local_opts.seed >> 32) & 0xFFFFFFFFu)); //Upper 32 bit
-        std::seed_seq seedseq(seq_input.begin(), seq_input.end());
-        std::vector<uint32_t> thread_seeds(n_threads);
-        seedseq.generate(thread_seeds.begin(), thread_seeds.end());
-
         // Precompute drift/vol terms for terminal lognormal sampling; discount factor for price.
         const double drift = (local_opts.r - 0.5 * sigma * sigma) * T;
         const double vol = sigma * std::sqrt(T);
-        const long double exp_neg_rT = std::expl(-local_opts.r * T);
-
-        for (std::size_t t = 0; t < n_threads; ++t) {
-            workers.emplace_back([t, &counts, &acc, S0, K, drift, vol, T, use_antithetic, use_cv, is_call, n_threads, &thread_seeds, local_opts]() {
-                // each thread local rng
-                // Per-thread RNG; seed mixed with index to decorrelate streams.
-                std::mt19937_64 rng;
-                // Derive a unique seed for each thread based on thread_seeds and thread index
-                // Combine with index to ensure distinctness
-                // 0x9e3779b97f4a7c15ULL Golden ratio constant for good mixing
-                uint64_t thread_seed = static_cast<uint64_t>(thread_seeds[t]) ^ (uint64_t(0x9e3779b97f4a7c15ULL) + (uint64_t)t + (static_cast<uint64_t>(thread_seeds[0])<<1));
-                rng.seed(thread_seed);
-
-                std::normal_distribution<double> nd(0.0, 1.0);
-
-                ThreadAcc local;
-                const std::size_t my_count = counts[t];
-
-                // Hot loop: generate samples and accumulate sums. No heap allocs here.
-                std::size_t i = 0;
-                if (use_antithetic) {
-                    // Antithetic variates: use z and -z to reduce variance of the estimator.
-                    // process in pairs
-                    for (; i + 1 < my_count; i += 2) {
-                        double z = nd(rng);
-                        double z2 = -z;
-
-                        double ST1 = S0 * std::exp(drift + vol * z);
-                        double ST2 = S0 * std::exp(drift + vol * z2);
-
-                        double Y1 = is_call ? payoff_call(ST1, K) : payoff_put(ST1, K);
-                        double Y2 = is_call ? payoff_call(ST2, K) : payoff_put(ST2, K);
-
-                        // control variate X = ST (undiscounted)
-                        double X1 = ST1;
-                        double X2 = ST2;
-
-                        local.sumY  += static_cast<long double>(Y1 + Y2);
-                        local.sumY2 += static_cast<long double>(Y1*Y1 + Y2*Y2);
-                        local.sumX  += static_cast<long double>(X1 + X2);
-                        local.sumX2 += static_cast<long double>(X1*X1 + X2*X2);
-                        local.sumYX += static_cast<long double>(Y1*X1 + Y2*X2);
-                        local.n += 2;
-                    }
-                    // If my_count was odd, do one more
-                    if (i < my_count) {
-                        double z = nd(rng);
-                        double ST = S0 * std::exp(drift + vol * z);
-                        double Y = is_call ? payoff_call(ST, K) : payoff_put(ST, K);
-                        double X = ST;
-                        local.sumY  += static_cast<long double>(Y);
-                        local.sumY2 += static_cast<long double>(Y*Y);
-                        local.sumX  += static_cast<long double>(X);
-                        local.sumX2 += static_cast<long double>(X*X);
-                        local.sumYX += static_cast<long double>(Y*X);
-                        local.n += 1;
+        const double exp_neg_rT = std::exp(-local_opts.r * T);
+        const TerminalParams params{S0, K, drift, vol, is_call, use_antithetic};
+
+        // Per-chunk streaming moments (Welford/Chan, see moments.hpp), replicate-major
+        std::vector<PairMoments> acc(n_chunks);
+        const bool compute_greeks = local_opts.compute_greeks;
+        const bool single = local_opts.precision == MCPrecision::Single;
+        std::vector<GreekMoments> greek_acc(compute_greeks ? n_chunks : 0);
+        const GreekSampler greek_sampler{S0, K, sigma, T, exp_neg_rT, is_call};
+
+        auto price_chunk = [&](std::size_t t) {
+            PairMoments local;
+            const std::size_t rep = t / chunks_per_rep;
+            const std::size_t first = (t % chunks_per_rep) * MC_CHUNK_DRAWS;
+            const std::size_t last = std::min(n_draws, first + MC_CHUNK_DRAWS);
+
+            // Normals are produced in blocks (vectorised Philox + Box-Muller, or Sobol
+            // + inverse CDF) and fed to the SIMD payoff kernel; no allocation here.
+            constexpr std::size_t BLOCK = 1024;
+            double zbuf[BLOCK];
+            float zf[BLOCK];      // Single: the block the kernel reads, half the bytes
+            double st[2 * BLOCK];
+            GreekMoments greeks;
+
+            for (std::size_t base = first; base < last; base += BLOCK) {
+                const std::size_t m = std::min(BLOCK, last - base);
+                if (single) {
+                    if (use_qmc) {
+                        sobol[rep].normals(base, m, 0, zbuf);
+                        for (std::size_t i = 0; i < m; ++i) zf[i] = static_cast<float>(zbuf[i]);
+                    } else {
+                        rng.normals(base, m, 0, zf);
+                        // Greeks use the same (rounded) draws as the price
+                        if (compute_greeks) for (std::size_t i = 0; i < m; ++i) zbuf[i] = zf[i];
                     }
+                    terminal_kernel_f32(params, zf, m, local);
                 } else {
-                    for (; i < my_count; ++i) {
-                        double z = nd(rng);
-                        double ST = S0 * std::exp(drift + vol * z);
-                        double Y = is_call ? payoff_call(ST, K) : payoff_put(ST, K);
-                        double X = ST;
-                        local.sumY  += static_cast<long double>(Y);
-                        local.sumY2 += static_cast<long double>(Y*Y);
-                        local.sumX  += static_cast<long double>(X);
-                        local.sumX2 += static_cast<long double>(X*X);
-                        local.sumYX += static_cast<long double>(Y*X);
-                        local.n += 1;
-                    }
+                    if (use_qmc) sobol[rep].normals(base, m, 0, zbuf);
+                    else rng.normals(base, m, 0, zbuf);
+                    terminal_kernel(params, zbuf, m, local);
                 }
-                // store local results
-                acc[t] = local;
-            });
-        }
 
-        // join threads
-        for (auto &th : workers) th.join();
+                if (compute_greeks) {
+                    // same draws as the price, so Greeks and price are consistent
+                    terminal_prices(S0, drift, vol, zbuf, m, use_antithetic, st, m);
+                    for (std::size_t i = 0; i < m; ++i) {
+                        greek_sampler.add(greeks, st[i], zbuf[i]);
+                        if (use_antithetic) greek_sampler.add(greeks, st[m + i], -zbuf[i]);
+                    }
+                }
+            }
+            acc[t] = local;
+            if (compute_greeks) greek_acc[t] = greeks;
+        };
+
+        const double EX = S0 * std::exp(local_opts.r * T);
+
+        // Chunks go to the shared work-stealing pool; n_threads == 1 (or a single
+        // chunk) prices on the caller with no thread handoff at all, k caps the chunks
+        // in flight.
+        std::vector<PairMoments> scratch;
+        const std::size_t done = mc_run_chunks(n_chunks, local_opts, price_chunk, [&](std::size_t k) {
+            scratch.assign(acc.begin(), acc.begin() + k);
+            return mc_result_from_moments(merge_pairwise(scratch.data(), k), EX, exp_neg_rT, use_cv).stderr_;
+        });
+        acc.resize(done);
+        if (compute_greeks) greek_acc.resize(done);
 
-        // combine results from threads
-        long double sumY = 0.0L, sumY2 = 0.0L, sumX = 0.0L, sumX2 = 0.0L, sumYX = 0.0L;
-        std::size_t N = 0;
-        for (std::size_t t = 0; t < n_threads; ++t) {
-            sumY  += acc[t].sumY;
-            sumY2 += acc[t].sumY2;
-            sumX  += acc[t].sumX;
-            sumX2 += acc[t].sumX2;
-            sumYX += acc[t].sumYX;
-            N += acc[t].n;
+        MCResult res;
+        if (use_qmc) {
+            std::vector<PairMoments> reps(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                reps[r] = merge_pairwise(&acc[r * chunks_per_rep], chunks_per_rep);
+            }
+            res = mc_result_from_replicates(reps, EX, exp_neg_rT, use_cv);
+        } else {
+            // combine chunk results (pairwise Chan merge, fixed chunk order)
+            const PairMoments total = merge_pairwise(acc.data(), acc.size());
+            res = mc_result_from_moments(total, EX, exp_neg_rT, use_cv);
         }
-
-        if (N == 0) {
-            return MCResult{0.0, 0.0, 0.0, 0.0, 0};
+        if (compute_greeks) {
+            res.has_greeks = true;
+            res.greeks = greeks_from_chunks(greek_acc, n_reps, chunks_per_rep);
         }
+        return res;
+    }
 
-        // Sample means on undiscounted payoffs (Y) and control variate (X = S_T).
-        long double meanY = sumY / static_cast<long double>(N);
-        long double meanX = sumX / static_cast<long double>(N);
-
-        // Control variate expectation under risk-neutral measure: E[S_T] = S0 * exp(r T).
-        long double EX = static_cast<long double>(S0 * std::exp(local_opts.r * T));
+    std::vector<MCResult> monte_carlo_strip(
+        double S0,
+        double sigma,
+        const std::vector<MCStripOption>& options,
+        const MCOptions& opts
+    ) {
+        MCOptions local_opts = opts;
+        local_opts.seed = mc_resolve_seed(local_opts.seed);
 
-        // Covariance and variance (unbiased, N-1) for optimal control variate coefficient.
-        long double covYX = (sumYX - static_cast<long double>(N) * meanY * meanX) / static_cast<long double>(N - 1);
-        long double varX  =  (sumX2 - static_cast<long double>(N) * meanX * meanX) / static_cast<long double>(N - 1);
-        long double varY  =  (sumY2 - static_cast<long double>(N) * meanY * meanY) / static_cast<long double>(N - 1);
+        const std::size_t n_opt = options.size();
+        if (n_opt == 0) return {};
+        const bool use_antithetic = local_opts.use_antithetic;
 
-        long double b_opt = 0.0L;
-        if (use_cv && varX > 0.0L) {
-            b_opt = covYX / varX;
+        // Group instruments by maturity; each distinct T gets one terminal-price pass.
+        std::vector<double> maturities;
+        std::vector<std::vector<std::size_t>> by_maturity;
+        for (std::size_t o = 0; o < n_opt; ++o) {
+            auto it = std::find(maturities.begin(), maturities.end(), options[o].T);
+            if (it == maturities.end()) {
+                maturities.push_back(options[o].T);
+                by_maturity.emplace_back();
+                it = maturities.end() - 1;
+            }
+            by_maturity[static_cast<std::size_t>(it - maturities.begin())].push_back(o);
+        }
+        std::vector<double> drift(maturities.size()), vol(maturities.size());
+        for (std::size_t j = 0; j < maturities.size(); ++j) {
+            drift[j] = (local_opts.r - 0.5 * sigma * sigma) * maturities[j];
+            vol[j] = sigma * std::sqrt(maturities[j]);
         }
 
-        // Construct adjusted estimator (undiscounted) with optimal b: Y_cv = Y - b*(X - E[X]).
-        // Y_cv = Y - b*(X - E[X])
-        // mean(Y_cv) = meanY - b*(meanX - EX)
-        long double meanYcv = meanY - b_opt * (meanX - EX);
-
-        // Variance of adjusted estimator: var(Y - bX) = varY - 2 b covYX + b^2 varX; clamp at 0 for safety.
-        long double varYcv = varY - 2.0L * b_opt * covYX + b_opt * b_opt * varX;
-        if (varYcv < 0.0L) varYcv = 0.0L; // numerical safety
+        // Same draw layout as monte_carlo_terminal: every maturity reuses the same
+        // normals (common random numbers), so the strip is internally consistent.
+        const std::size_t n_draws = use_antithetic ? (local_opts.n_paths + 1) / 2 : local_opts.n_paths;
+        const std::size_t n_chunks = (n_draws + MC_CHUNK_DRAWS - 1) / MC_CHUNK_DRAWS;
+        const CounterRNG rng(local_opts.seed);
+
+        // Moments per (instrument, chunk), instrument-major so each merges contiguously.
+        std::vector<PairMoments> acc(n_opt * n_chunks);
+
+        auto price_chunk = [&](std::size_t c) {
+            const std::size_t first = c * MC_CHUNK_DRAWS;
+            const std::size_t last = std::min(n_draws, first + MC_CHUNK_DRAWS);
+            std::vector<PairMoments> local(n_opt);
+
+            constexpr std::size_t BLOCK = 1024;
+            double zbuf[BLOCK];
+            double st[2 * BLOCK];   // +z terminal prices, then -z when antithetic
+
+            for (std::size_t base = first; base < last; base += BLOCK) {
+                const std::size_t m = std::min(BLOCK, last - base);
+                const std::size_t n_st = use_antithetic ? 2 * m : m;
+                rng.normals(base, m, 0, zbuf);
+                for (std::size_t j = 0; j < maturities.size(); ++j) {
+                    terminal_prices(S0, drift[j], vol[j], zbuf, m, use_antithetic, st, m);
+                    for (std::size_t o : by_maturity[j]) {
+                        payoff_moments(st, n_st, options[o].K, options[o].is_call, local[o]);
+                    }
+                }
+            }
+            for (std::size_t o = 0; o < n_opt; ++o) acc[o * n_chunks + c] = local[o];
+        };
 
-        // Discount to present value.
-        long double price = exp_neg_rT * meanYcv;
+        mc_for_each_chunk(n_chunks, local_opts, price_chunk);
 
-        long double stderr_ = 0.0L;
-        if (N > 0) {
-            long double var_mean = varYcv / static_cast<long double>(N);
-            stderr_ = static_cast<double>(std::sqrt(var_mean) * exp_neg_rT);
+        std::vector<MCResult> out(n_opt);
+        for (std::size_t o = 0; o < n_opt; ++o) {
+            const double T = options[o].T;
+            const PairMoments total = merge_pairwise(&acc[o * n_chunks], n_chunks);
+            out[o] = mc_result_from_moments(total, S0 * std::exp(local_opts.r * T),
+                                            std::exp(-local_opts.r * T), local_opts.use_control_variate);
         }
-
-        // Symmetric 95% normal-approximation confidence interval.
-        const long double z95 = 1.959963984540054; // ~1.96
-        long double ci_low  = price - z95 * stderr_;
-        long double ci_high = price + z95 * stderr_;
-
-        MCResult res;
-        res.price = static_cast<double>(price);
-        res.stderr_ = static_cast<double>(stderr_);
-        res.ci_low = static_cast<double>(ci_low);
-        res.ci_high = static_cast<double>(ci_high);
-        res.n_samples = N;
-        return res;
+        return out;
     }
-}
\ No newline at end of file
+}
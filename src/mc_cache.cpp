@@ -0,0 +1,193 @@
+#include "quant/mc_cache.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/rng.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace quant {
+    // Paths per task when building or pricing from growth factors.
+    static constexpr std::size_t CACHE_CHUNK = 16384;
+
+    static int64_t quantise(double x, double tick) {
+        return tick > 0.0 ? static_cast<int64_t>(std::llround(x / tick)) : static_cast<int64_t>(std::llround(x * 1e12));
+    }
+
+    static double dequantise(int64_t q, double tick) {
+        return tick > 0.0 ? static_cast<double>(q) * tick : static_cast<double>(q) * 1e-12;
+    }
+
+    std::size_t MCPriceCache::KeyHash::operator()(const RunKey& k) const {
+        uint64_t h = static_cast<uint64_t>(k.sigma);
+        h = h * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(k.T);
+        h = h * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(k.r);
+        h = h * 0x9e3779b97f4a7c15ULL ^ k.n_paths;
+        h = h * 0x9e3779b97f4a7c15ULL ^ k.seed;
+        h = h * 0x9e3779b97f4a7c15ULL ^ k.flags;
+        return std::hash<uint64_t>()(h);
+    }
+
+    std::size_t MCPriceCache::KeyHash::operator()(const PriceKey& k) const {
+        uint64_t h = (*this)(k.run);
+        h = h * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(k.S);
+        h = h * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(k.K);
+        h = h * 0x9e3779b97f4a7c15ULL ^ static_cast<uint64_t>(k.is_call);
+        return std::hash<uint64_t>()(h);
+    }
+
+    MCPriceCache::MCPriceCache(const MCCacheConfig& cfg) : cfg_(cfg) {}
+
+    MCPriceCache::Growth MCPriceCache::simulate_growth(double sigma, double T, const MCOptions& opts) {
+        const bool use_antithetic = opts.use_antithetic;
+        const std::size_t n_draws = use_antithetic ? (opts.n_paths + 1) / 2 : opts.n_paths;
+        const double drift = (opts.r - 0.5 * sigma * sigma) * T;
+        const double vol = sigma * std::sqrt(T);
+        const CounterRNG rng(mc_resolve_seed(opts.seed));
+
+        // R[d] = exp(drift + vol z_d); antithetic twins at R[n_draws + d]
+        std::shared_ptr<std::vector<double>> R(new std::vector<double>(use_antithetic ? 2 * n_draws : n_draws));
+        const std::size_t n_chunks = (n_draws + CACHE_CHUNK - 1) / CACHE_CHUNK;
+        mc_for_each_chunk(n_chunks, opts, [&](std::size_t c) {
+            const std::size_t first = c * CACHE_CHUNK;
+            const std::size_t last = std::min(n_draws, first + CACHE_CHUNK);
+            constexpr std::size_t BLOCK = 1024;
+            double z[BLOCK];
+            for (std::size_t base = first; base < last; base += BLOCK) {
+                const std::size_t m = std::min(BLOCK, last - base);
+                rng.normals(base, m, 0, z);
+                terminal_prices(1.0, drift, vol, z, m, use_antithetic, R->data() + base, n_draws);
+            }
+        });
+        return R;
+    }
+
+    MCResult MCPriceCache::price_from_growth(const std::vector<double>& R, double S0, double K, double T,
+                                             const MCOptions& opts, bool is_call) {
+        const std::size_t n = R.size();
+        const std::size_t n_chunks = (n + CACHE_CHUNK - 1) / CACHE_CHUNK;
+        std::vector<PairMoments> acc(n_chunks);
+        mc_for_each_chunk(n_chunks, opts, [&](std::size_t c) {
+            const std::size_t first = c * CACHE_CHUNK;
+            const std::size_t last = std::min(n, first + CACHE_CHUNK);
+            constexpr std::size_t BLOCK = 1024;
+            double ST[BLOCK];
+            PairMoments local;
+            for (std::size_t base = first; base < last; base += BLOCK) {
+                const std::size_t m = std::min(BLOCK, last - base);
+                for (std::size_t i = 0; i < m; ++i) ST[i] = S0 * R[base + i];
+                payoff_moments(ST, m, K, is_call, local);
+            }
+            acc[c] = local;
+        });
+        const PairMoments total = merge_pairwise(acc.data(), acc.size());
+        return mc_result_from_moments(total, S0 * std::exp(opts.r * T), std::exp(-opts.r * T),
+                                      opts.use_control_variate);
+    }
+
+    MCResult MCPriceCache::price(double S0, double K, double sigma, double T, const MCOptions& opts,
+                                 bool is_call) {
+        // Adaptive runs depend on timing, and seed == 0 asks for a fresh clock-seeded run
+        // every call: neither can be served from (or usefully stored in) the cache.
+        if (opts.seed == 0 || opts.target_stderr > 0.0 || opts.target_ci_width > 0.0 ||
+            opts.time_budget_ms > 0.0) {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                ++stats_.misses;
+            }
+            return monte_carlo_terminal(S0, K, sigma, T, opts, is_call);
+        }
+
+        PriceKey key;
+        key.run.sigma = quantise(sigma, cfg_.vol_tick);
+        key.run.T = quantise(T, cfg_.time_tick);
+        key.run.r = quantise(opts.r, cfg_.rate_tick);
+        key.run.n_paths = opts.n_paths;
+        key.run.seed = opts.seed;
+        key.run.flags = (opts.use_antithetic ? 1u : 0u) | (opts.use_control_variate ? 2u : 0u) |
+                        (opts.use_qmc ? 4u | (static_cast<uint64_t>(opts.qmc_scrambles) << 8) : 0u) |
+                        (opts.compute_greeks ? 8u : 0u) |
+                        (opts.precision == MCPrecision::Single ? 16u : 0u);
+        key.S = quantise(S0, cfg_.spot_tick);
+        key.K = quantise(K, cfg_.strike_tick);
+        key.is_call = is_call;
+
+        // price at the bucket's inputs, not the caller's, so hits are order-independent
+        MCOptions q_opts = opts;
+        q_opts.r = dequantise(key.run.r, cfg_.rate_tick);
+        const double qS = dequantise(key.S, cfg_.spot_tick);
+        const double qK = dequantise(key.K, cfg_.strike_tick);
+        const double qsigma = dequantise(key.run.sigma, cfg_.vol_tick);
+        const double qT = dequantise(key.run.T, cfg_.time_tick);
+        const bool path_cacheable = !opts.use_qmc && !opts.compute_greeks &&
+                                    opts.n_paths <= cfg_.max_cached_paths && cfg_.path_capacity > 0;
+
+        Growth growth;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            auto it = price_index_.find(key);
+            if (it != price_index_.end()) {
+                prices_.splice(prices_.begin(), prices_, it->second);
+                ++stats_.hits;
+                return it->second->second;
+            }
+            if (path_cacheable) {
+                auto rit = run_index_.find(key.run);
+                if (rit != run_index_.end()) {
+                    runs_.splice(runs_.begin(), runs_, rit->second);
+                    growth = rit->second->second;
+                    ++stats_.path_hits;
+                } else {
+                    ++stats_.misses;
+                }
+            } else {
+                ++stats_.misses;
+            }
+        }
+
+        MCResult res;
+        if (path_cacheable) {
+            const bool fresh = !growth;
+            if (fresh) growth = simulate_growth(qsigma, qT, q_opts);
+            res = price_from_growth(*growth, qS, qK, qT, q_opts, is_call);
+            if (fresh) {
+                std::lock_guard<std::mutex> lk(mtx_);
+                if (run_index_.find(key.run) == run_index_.end()) {
+                    runs_.emplace_front(key.run, growth);
+                    run_index_[key.run] = runs_.begin();
+                    while (runs_.size() > cfg_.path_capacity) {
+                        run_index_.erase(runs_.back().first);
+                        runs_.pop_back();
+                        ++stats_.evictions;
+                    }
+                }
+            }
+        } else {
+            res = monte_carlo_terminal(qS, qK, qsigma, qT, q_opts, is_call);
+        }
+
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (price_index_.find(key) == price_index_.end() && cfg_.capacity > 0) {
+            prices_.emplace_front(key, res);
+            price_index_[key] = prices_.begin();
+            while (prices_.size() > cfg_.capacity) {
+                price_index_.erase(prices_.back().first);
+                prices_.pop_back();
+                ++stats_.evictions;
+            }
+        }
+        return res;
+    }
+
+    MCCacheStats MCPriceCache::stats() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return stats_;
+    }
+
+    void MCPriceCache::clear() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        prices_.clear();
+        price_index_.clear();
+        runs_.clear();
+        run_index_.clear();
+    }
+}
@@ -0,0 +1,174 @@
+#include "quant/mc_heston.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/rng.hpp"
+#include "quant/sobol.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace quant {
+    // Same granularity as the GBM path engine: a block's state stays in cache
+    // across all steps.
+    static constexpr std::size_t HESTON_CHUNK_DRAWS = 4096;
+    static constexpr std::size_t HESTON_BLOCK = 256;
+
+    // Running state of up to 2 * HESTON_BLOCK paths (antithetic twins in the upper half).
+    struct HestonBlockState {
+        std::vector<double> x, x_prev, v, v_prev;   // ln(S / S0) and variance, now and one step back
+        std::vector<double> S, sum, mn, mx;
+        std::vector<double> surv_up, surv_down;
+        std::vector<double> zv, z, tmp;
+
+        HestonBlockState()
+            : x(2 * HESTON_BLOCK), x_prev(2 * HESTON_BLOCK), v(2 * HESTON_BLOCK),
+              v_prev(2 * HESTON_BLOCK), S(2 * HESTON_BLOCK), sum(2 * HESTON_BLOCK),
+              mn(2 * HESTON_BLOCK), mx(2 * HESTON_BLOCK), surv_up(2 * HESTON_BLOCK),
+              surv_down(2 * HESTON_BLOCK), zv(HESTON_BLOCK), z(HESTON_BLOCK), tmp(2 * HESTON_BLOCK) {}
+    };
+
+    // Fold one barrier into surv[0..n) for the step just taken (see monitor_barrier in
+    // mc_path.cpp); the bridge variance is the step's mean of v.
+    static void monitor_barrier(HestonBlockState& st, std::size_t n, double lnB, double sign,
+                                double dt, bool bridge, double* surv) {
+        double* e = st.tmp.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            const double a = sign * (lnB - st.x_prev[i]);
+            const double b = sign * (lnB - st.x[i]);
+            const bool alive = a > 0.0 && b > 0.0;
+            const double var = 0.5 * (st.v_prev[i] + st.v[i]) * dt;
+            // zero variance over the step: the path cannot have crossed in between
+            e[i] = alive ? (bridge ? (var > 0.0 ? -2.0 * a * b / var : -INFINITY) : -INFINITY) : 0.0;
+        }
+        exp_array(e, n, e);
+        for (std::size_t i = 0; i < n; ++i) surv[i] *= 1.0 - e[i];
+    }
+
+    MCResult monte_carlo_heston(
+        double S0,
+        double T,
+        const HestonParams& params,
+        const PathPayoff& payoff,
+        const MCOptions& opts,
+        const PathMCOptions& path_opts
+    ) {
+        const std::size_t n_steps = std::max<std::size_t>(1, path_opts.n_steps);
+        const uint64_t seed = mc_resolve_seed(opts.seed);
+        const bool use_qmc = opts.use_qmc;
+        const bool use_antithetic = opts.use_antithetic && !use_qmc;
+        const CounterRNG rng(seed);
+
+        const double dt = T / static_cast<double>(n_steps);
+        const HestonQEStep qe(params, opts.r, dt);
+        const bool has_up = payoff.barrier_up > 0.0;
+        const bool has_down = payoff.barrier_down > 0.0;
+        const double lnB_up = has_up ? std::log(payoff.barrier_up / S0) : 0.0;
+        const double lnB_down = has_down ? std::log(payoff.barrier_down / S0) : 0.0;
+
+        // QMC: a 2 * n_steps-dimensional Sobol sequence per scrambling; dimensions past
+        // SOBOL_MAX_DIM are pseudo-random padding.
+        const std::size_t n_reps = use_qmc ? std::max<std::size_t>(2, opts.qmc_scrambles) : 1;
+        std::vector<SobolSequence> sobol;
+        if (use_qmc) {
+            sobol.reserve(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                sobol.emplace_back(static_cast<uint32_t>(2 * n_steps), SobolSequence::replicate_seed(seed, r));
+            }
+        }
+
+        const std::size_t n_draws = use_qmc ? (opts.n_paths + n_reps - 1) / n_reps
+                                  : use_antithetic ? (opts.n_paths + 1) / 2 : opts.n_paths;
+        const std::size_t chunks_per_rep = (n_draws + HESTON_CHUNK_DRAWS - 1) / HESTON_CHUNK_DRAWS;
+        const std::size_t n_chunks = n_reps * chunks_per_rep;
+        std::vector<PairMoments> acc(n_chunks);
+
+        auto price_chunk = [&](std::size_t t) {
+            PairMoments local;
+            HestonBlockState st;
+            const std::size_t rep = t / chunks_per_rep;
+            const std::size_t first = (t % chunks_per_rep) * HESTON_CHUNK_DRAWS;
+            const std::size_t last = std::min(n_draws, first + HESTON_CHUNK_DRAWS);
+
+            for (std::size_t base = first; base < last; base += HESTON_BLOCK) {
+                const std::size_t m = std::min(HESTON_BLOCK, last - base);
+                const std::size_t n = use_antithetic ? 2 * m : m;
+                std::fill(st.x.begin(), st.x.begin() + n, 0.0);
+                std::fill(st.v.begin(), st.v.begin() + n, params.v0);
+                std::fill(st.sum.begin(), st.sum.begin() + n, 0.0);
+                std::fill(st.mn.begin(), st.mn.begin() + n, S0);
+                std::fill(st.mx.begin(), st.mx.begin() + n, S0);
+                std::fill(st.surv_up.begin(), st.surv_up.begin() + n, 1.0);
+                std::fill(st.surv_down.begin(), st.surv_down.begin() + n, 1.0);
+
+                for (std::size_t k = 0; k < n_steps; ++k) {
+                    const uint32_t dim_v = static_cast<uint32_t>(2 * k);
+                    if (use_qmc) {
+                        sobol[rep].normals(base, m, dim_v, st.zv.data());
+                        sobol[rep].normals(base, m, dim_v + 1, st.z.data());
+                    } else {
+                        rng.normals(base, m, dim_v, st.zv.data());
+                        rng.normals(base, m, dim_v + 1, st.z.data());
+                    }
+                    std::copy(st.x.begin(), st.x.begin() + n, st.x_prev.begin());
+                    std::copy(st.v.begin(), st.v.begin() + n, st.v_prev.begin());
+                    heston_qe_block(qe, st.x.data(), st.v.data(), st.zv.data(), st.z.data(), m, 1.0,
+                                    st.tmp.data());
+                    if (use_antithetic) {
+                        heston_qe_block(qe, st.x.data() + m, st.v.data() + m, st.zv.data(), st.z.data(),
+                                        m, -1.0, st.tmp.data());
+                    }
+                    // S = S0 * exp(x) with the vector exp (drift 0, vol 1)
+                    terminal_prices(S0, 0.0, 1.0, st.x.data(), n, false, st.S.data(), 0);
+                    for (std::size_t i = 0; i < n; ++i) {
+                        st.sum[i] += st.S[i];
+                        st.mn[i] = std::min(st.mn[i], st.S[i]);
+                        st.mx[i] = std::max(st.mx[i], st.S[i]);
+                    }
+                    if (has_up) {
+                        monitor_barrier(st, n, lnB_up, 1.0, dt, path_opts.brownian_bridge,
+                                        st.surv_up.data());
+                    }
+                    if (has_down) {
+                        monitor_barrier(st, n, lnB_down, -1.0, dt, path_opts.brownian_bridge,
+                                        st.surv_down.data());
+                    }
+                }
+
+                for (std::size_t i = 0; i < n; ++i) {
+                    PathState ps;
+                    ps.S0 = S0;
+                    ps.S_T = st.S[i];
+                    ps.average = st.sum[i] / static_cast<double>(n_steps);
+                    ps.min = st.mn[i];
+                    ps.max = st.mx[i];
+                    ps.survival_up = st.surv_up[i];
+                    ps.survival_down = st.surv_down[i];
+                    local.add(payoff.fn(ps), ps.S_T);
+                }
+            }
+            acc[t] = local;
+        };
+
+        // S_T is a martingale after discounting under Heston too, so it stays the
+        // control variate.
+        const double EX = S0 * std::exp(opts.r * T);
+        const double disc = std::exp(-opts.r * T);
+
+        std::vector<PairMoments> scratch;
+        const std::size_t done = mc_run_chunks(n_chunks, opts, price_chunk, [&](std::size_t k) {
+            scratch.assign(acc.begin(), acc.begin() + k);
+            return mc_result_from_moments(merge_pairwise(scratch.data(), k), EX, disc,
+                                          opts.use_control_variate).stderr_;
+        });
+        acc.resize(done);
+
+        if (use_qmc) {
+            std::vector<PairMoments> reps(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                reps[r] = merge_pairwise(&acc[r * chunks_per_rep], chunks_per_rep);
+            }
+            return mc_result_from_replicates(reps, EX, disc, opts.use_control_variate);
+        }
+        const PairMoments total = merge_pairwise(acc.data(), acc.size());
+        return mc_result_from_moments(total, EX, disc, opts.use_control_variate);
+    }
+}
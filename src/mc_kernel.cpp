@@ -0,0 +1,520 @@
+#include "quant/mc_kernel.hpp"
+#include "quant/cpu_dispatch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// The always-inline vector helpers below return wide vectors; they are only ever
+// inlined into target-attributed kernels, so the ABI note does not apply.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace quant {
+    // -----------------------------------------
+    // Scalar fallback
+    // -----------------------------------------
+
+    // z may be float (MCPrecision::Single draws); the arithmetic is double either way.
+    template <class T>
+    static void terminal_kernel_scalar(const TerminalParams& p, const T* z, std::size_t n,
+                                       PairMoments& acc) {
+        const double sgn = p.is_call ? 1.0 : -1.0;
+        auto add = [&](double x) {
+            double ST = p.S0 * std::exp(x);
+            acc.add(std::max(0.0, sgn * (ST - p.K)), ST);
+        };
+        for (std::size_t i = 0; i < n; ++i) {
+            add(p.drift + p.vol * z[i]);
+            if (p.antithetic) add(p.drift - p.vol * z[i]);
+        }
+    }
+
+    static void terminal_prices_scalar(double S0, double drift, double vol, const double* z,
+                                       std::size_t n, bool antithetic, double* out,
+                                       std::size_t out_stride) {
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = S0 * std::exp(drift + vol * z[i]);
+            if (antithetic) out[out_stride + i] = S0 * std::exp(drift - vol * z[i]);
+        }
+    }
+
+    static void payoff_moments_scalar(const double* ST, std::size_t n, double K, bool is_call,
+                                      PairMoments& acc) {
+        const double sgn = is_call ? 1.0 : -1.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            acc.add(std::max(0.0, sgn * (ST[i] - K)), ST[i]);
+        }
+    }
+
+    static void heston_qe_scalar(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                                 const double* z, std::size_t n, double sign, double*) {
+        for (std::size_t i = 0; i < n; ++i) qe.step(x[i], v[i], sign * zv[i], sign * z[i]);
+    }
+
+#if QUANT_X86_DISPATCH
+    // -----------------------------------------
+    // Vector kernels (W lanes of double)
+    // -----------------------------------------
+    // Written once with GCC vector extensions; the always-inline bodies are compiled
+    // for the ISA of the target-attributed entry point that instantiates them.
+
+    template <int W> struct Lanes {
+        typedef double  vd __attribute__((vector_size(W * sizeof(double))));
+        typedef int64_t vi __attribute__((vector_size(W * sizeof(double))));
+    };
+
+    template <class To, class From>
+    __attribute__((always_inline)) static inline To bit_cast_vec(const From& from) {
+        To to;
+        std::memcpy(&to, &from, sizeof(to));
+        return to;
+    }
+
+    // exp(x): x = k ln2 + r with |r| <= ln2 / 2 (Cody-Waite split of ln2), Taylor
+    // polynomial to r^13 (error < 1e-16 relative), 2^k built in the exponent bits.
+    // Inputs are clamped to [-708, 709] so 2^k stays a normal double.
+    template <class VD, class VI>
+    __attribute__((always_inline)) static inline VD vexp(const VD& in) {
+        const double magic = 6755399441055744.0; // 1.5 * 2^52: round-to-nearest shifter
+        VD x = in < 709.0 ? in : VD{} + 709.0;
+        x = x > -708.0 ? x : VD{} - 708.0;
+
+        VD kf = x * 1.4426950408889634 + magic;
+        VI ki = bit_cast_vec<VI>(kf) - bit_cast_vec<VI>(VD{} + magic);
+        kf = kf - magic;
+        VD r = x - kf * 0.6931471803691238 - kf * 1.9082149292705877e-10;
+
+        VD e = VD{} + 1.0 / 6227020800.0;
+        e = e * r + 1.0 / 479001600.0;
+        e = e * r + 1.0 / 39916800.0;
+        e = e * r + 1.0 / 3628800.0;
+        e = e * r + 1.0 / 362880.0;
+        e = e * r + 1.0 / 40320.0;
+        e = e * r + 1.0 / 5040.0;
+        e = e * r + 1.0 / 720.0;
+        e = e * r + 1.0 / 120.0;
+        e = e * r + 1.0 / 24.0;
+        e = e * r + 1.0 / 6.0;
+        e = e * r + 0.5;
+        e = e * r + 1.0;
+        e = e * r + 1.0;
+
+        VI bits = (ki + 1023) << 52;
+        return e * bit_cast_vec<VD>(bits);
+    }
+
+    template <int W> struct LanesF {
+        typedef float   vf __attribute__((vector_size(W * sizeof(float))));
+        typedef int32_t vi __attribute__((vector_size(W * sizeof(float))));
+    };
+
+    // Single-precision exp: same reduction as vexp with a float split of ln2 and a
+    // degree-7 Taylor polynomial (|r| <= ln2 / 2, error < 1e-8 relative); inputs
+    // clamped to [-87, 88].
+    template <class VF, class VI>
+    __attribute__((always_inline)) static inline VF vexpf(const VF& in) {
+        const float magic = 12582912.0f; // 1.5 * 2^23
+        VF x = in < 88.0f ? in : VF{} + 88.0f;
+        x = x > -87.0f ? x : VF{} - 87.0f;
+
+        VF kf = x * 1.44269504f + magic;
+        VI ki = bit_cast_vec<VI>(kf) - bit_cast_vec<VI>(VF{} + magic);
+        kf = kf - magic;
+        VF r = x - kf * 0.693359375f - kf * -2.12194440e-4f;
+
+        VF e = VF{} + 1.0f / 5040.0f;
+        e = e * r + 1.0f / 720.0f;
+        e = e * r + 1.0f / 120.0f;
+        e = e * r + 1.0f / 24.0f;
+        e = e * r + 1.0f / 6.0f;
+        e = e * r + 0.5f;
+        e = e * r + 1.0f;
+        e = e * r + 1.0f;
+
+        VI bits = (ki + 127) << 23;
+        return e * bit_cast_vec<VF>(bits);
+    }
+
+    // Per-lane Welford moments. All lanes see the same sample count, so one scalar
+    // reciprocal per step serves every lane.
+    template <class VD>
+    struct LaneMoments {
+        std::size_t n = 0;
+        VD mY{}, mX{}, m2Y{}, m2X{}, cYX{};
+
+        __attribute__((always_inline)) inline void add(const VD& Y, const VD& X) {
+            add(Y, X, 1.0 / static_cast<double>(n + 1));
+        }
+
+        // inv must be 1 / (n + 1); lets several accumulators at the same count share it.
+        __attribute__((always_inline)) inline void add(const VD& Y, const VD& X, double inv) {
+            ++n;
+            VD dY = Y - mY;
+            VD dX = X - mX;
+            mY += dY * inv;
+            mX += dX * inv;
+            VD eX = X - mX;
+            m2Y += dY * (Y - mY);
+            m2X += dX * eX;
+            cYX += dY * eX;
+        }
+
+        template <int W>
+        __attribute__((always_inline)) inline void merge_into(PairMoments& acc) const {
+            if (n == 0) return;
+            PairMoments lanes[W];
+            for (int l = 0; l < W; ++l) {
+                lanes[l] = PairMoments{n, mY[l], mX[l], m2Y[l], m2X[l], cYX[l]};
+            }
+            acc.merge(merge_pairwise(lanes, W));
+        }
+    };
+
+    template <class V, class T>
+    __attribute__((always_inline)) static inline V load_vec(const T* p) {
+        V v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    template <class VD>
+    __attribute__((always_inline)) static inline void store_vec(double* p, const VD& v) {
+        std::memcpy(p, &v, sizeof(v));
+    }
+
+    // sqrt(x) for x >= 0 as x / sqrt(x): bit-trick 1/sqrt(x) estimate (< 3.5% error)
+    // and four Newton steps, each squaring the relative error, so plain vector ops stay
+    // ISA-neutral like vexp. sqrt(0) = 0.
+    template <class VD, class VI>
+    __attribute__((always_inline)) static inline VD vsqrt(const VD& x) {
+        const VI magic = VI{} + static_cast<int64_t>(0x5FE6EB50C7B537A9ll);
+        VD y = bit_cast_vec<VD>(magic - (bit_cast_vec<VI>(x) >> 1));
+        const VD half_x = 0.5 * x;
+        y = y * (1.5 - half_x * y * y);
+        y = y * (1.5 - half_x * y * y);
+        y = y * (1.5 - half_x * y * y);
+        y = y * (1.5 - half_x * y * y);
+        return x * y;
+    }
+
+    // Undiscounted payoff max(sgn * (ST - K), 0), branch-free.
+    template <class VD>
+    __attribute__((always_inline)) static inline VD payoff_vec(const VD& ST, double K, double sgn) {
+        VD d = sgn * (ST - K);
+        return d > 0.0 ? d : VD{};
+    }
+
+    template <int W, bool Anti>
+    __attribute__((always_inline))
+    static inline void terminal_kernel_vec(const TerminalParams& p, const double* z, std::size_t n,
+                                           PairMoments& acc) {
+        typedef typename Lanes<W>::vd VD;
+        typedef typename Lanes<W>::vi VI;
+        const double sgn = p.is_call ? 1.0 : -1.0;
+        LaneMoments<VD> s;
+
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            VD zv = load_vec<VD>(z + i);
+            VD ST = p.S0 * vexp<VD, VI>(p.drift + p.vol * zv);
+            s.add(payoff_vec(ST, p.K, sgn), ST);
+            if (Anti) {
+                ST = p.S0 * vexp<VD, VI>(p.drift - p.vol * zv);
+                s.add(payoff_vec(ST, p.K, sgn), ST);
+            }
+        }
+
+        s.template merge_into<W>(acc);
+        PairMoments tail;
+        terminal_kernel_scalar(p, z + i, n - i, tail);
+        acc.merge(tail);
+    }
+
+    template <int W>
+    __attribute__((always_inline))
+    static inline void terminal_prices_vec(double S0, double drift, double vol, const double* z,
+                                           std::size_t n, bool antithetic, double* out,
+                                           std::size_t out_stride) {
+        typedef typename Lanes<W>::vd VD;
+        typedef typename Lanes<W>::vi VI;
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            VD zv = load_vec<VD>(z + i);
+            store_vec(out + i, S0 * vexp<VD, VI>(drift + vol * zv));
+            if (antithetic) store_vec(out + out_stride + i, S0 * vexp<VD, VI>(drift - vol * zv));
+        }
+        terminal_prices_scalar(S0, drift, vol, z + i, n - i, antithetic, out + i, out_stride);
+    }
+
+    template <int W>
+    __attribute__((always_inline))
+    static inline void payoff_moments_vec(const double* ST, std::size_t n, double K, bool is_call,
+                                          PairMoments& acc) {
+        typedef typename Lanes<W>::vd VD;
+        const double sgn = is_call ? 1.0 : -1.0;
+        // Four independent accumulators hide the latency of the Welford mean update,
+        // which otherwise serialises consecutive vectors.
+        LaneMoments<VD> s[4];
+        std::size_t i = 0;
+        for (; i + 4 * W <= n; i += 4 * W) {
+            const double inv = 1.0 / static_cast<double>(s[0].n + 1);
+            for (int u = 0; u < 4; ++u) {
+                VD X = load_vec<VD>(ST + i + u * W);
+                s[u].add(payoff_vec(X, K, sgn), X, inv);
+            }
+        }
+        for (; i + W <= n; i += W) {
+            VD X = load_vec<VD>(ST + i);
+            s[0].add(payoff_vec(X, K, sgn), X);
+        }
+        for (int u = 0; u < 4; ++u) s[u].template merge_into<W>(acc);
+        PairMoments tail;
+        payoff_moments_scalar(ST + i, n - i, K, is_call, tail);
+        acc.merge(tail);
+    }
+
+    template <int W, bool Anti>
+    __attribute__((always_inline))
+    static inline void terminal_kernel_f32_vec(const TerminalParams& p, const float* z, std::size_t n,
+                                               PairMoments& acc) {
+        typedef typename LanesF<W>::vf VF;
+        typedef typename LanesF<W>::vi VI;
+        // Float sums stay short (BLOCK / W terms per lane) and centred, so rounding
+        // stays near float epsilon; each block then merges into acc in double.
+        constexpr std::size_t BLOCK = 256;
+        const float sgn = p.is_call ? 1.0f : -1.0f;
+        const double cX = p.S0 * std::exp(p.drift + 0.5 * p.vol * p.vol);
+        const double cY = std::max(0.0, (p.is_call ? 1.0 : -1.0) * (cX - p.K));
+        const float S0 = static_cast<float>(p.S0), K = static_cast<float>(p.K);
+        const float drift = static_cast<float>(p.drift), vol = static_cast<float>(p.vol);
+        const float cXf = static_cast<float>(cX), cYf = static_cast<float>(cY);
+
+        const std::size_t nv = n - n % W;
+        for (std::size_t first = 0; first < nv; first += BLOCK) {
+            const std::size_t last = std::min(nv, first + BLOCK);
+            VF sY{}, sX{}, sYY{}, sXX{}, sXY{};
+            auto fold = [&](const VF& ST) __attribute__((always_inline)) {
+                VF d = sgn * (ST - K);
+                const VF Y = (d > 0.0f ? d : VF{}) - cYf;
+                const VF X = ST - cXf;
+                sY += Y;
+                sX += X;
+                sYY += Y * Y;
+                sXX += X * X;
+                sXY += X * Y;
+            };
+            for (std::size_t i = first; i < last; i += W) {
+                const VF zf = load_vec<VF>(z + i);
+                fold(S0 * vexpf<VF, VI>(drift + vol * zf));
+                if (Anti) fold(S0 * vexpf<VF, VI>(drift - vol * zf));
+            }
+            double t[5] = {};
+            for (int l = 0; l < W; ++l) {
+                t[0] += sY[l];
+                t[1] += sX[l];
+                t[2] += sYY[l];
+                t[3] += sXX[l];
+                t[4] += sXY[l];
+            }
+            const std::size_t cnt = (last - first) * (Anti ? 2 : 1);
+            const double nb = static_cast<double>(cnt);
+            const double mY = t[0] / nb, mX = t[1] / nb;
+            acc.merge(PairMoments{cnt, cY + mY, cX + mX, std::max(0.0, t[2] - t[0] * mY),
+                                  std::max(0.0, t[3] - t[1] * mX), t[4] - t[0] * mX});
+        }
+        PairMoments tail;
+        TerminalParams tp = p;
+        tp.antithetic = Anti;
+        terminal_kernel_scalar(tp, z + nv, n - nv, tail);
+        acc.merge(tail);
+    }
+
+    template <int W>
+    __attribute__((always_inline))
+    static inline void heston_qe_vec(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                                     const double* z, std::size_t n, double sign, double* vn) {
+        typedef typename Lanes<W>::vd VD;
+        typedef typename Lanes<W>::vi VI;
+        const std::size_t nv = n - n % W;
+
+        // Quadratic branch for every lane, psi clamped into its domain. Lanes outside
+        // it are redone in scalar: psi > 1.5 (including m == 0) takes the exponential
+        // branch, and psi below the clamp (xi ~ 0) the exact quadratic, since a clamped
+        // psi would inflate the variance noise that k1, k2 (~ rho / xi) amplify.
+        for (std::size_t i = 0; i < nv; i += W) {
+            const VD vi = load_vec<VD>(v + i);
+            VD m = qe.theta + (vi - qe.theta) * qe.e_kdt;
+            m = m > 0.0 ? m : VD{};
+            const VD s2 = vi * qe.c1 + qe.c2;
+            VD m2 = m * m;
+            m2 = m2 > 1e-300 ? m2 : VD{} + 1e-300;
+            const VD psi = s2 / m2;
+            VD pc = psi > 1e-12 ? psi : VD{} + 1e-12;
+            pc = pc < 1.5 ? pc : VD{} + 1.5;
+            const VD ip = 2.0 / pc;
+            const VD b2 = ip - 1.0 + vsqrt<VD, VI>(ip) * vsqrt<VD, VI>(ip - 1.0);
+            const VD b = vsqrt<VD, VI>(b2) + sign * load_vec<VD>(zv + i);
+            const VD q = m / (1.0 + b2) * b * b;
+            store_vec(vn + i, s2 > 0.0 ? q : m);
+
+            const VI fix_lane = (psi > 1.5) | ((psi < 1e-12) & (s2 > 0.0));
+            int64_t any = 0;
+            for (int l = 0; l < W; ++l) any |= fix_lane[l];
+            if (any) {
+                for (int l = 0; l < W; ++l) {
+                    if (!fix_lane[l]) continue;
+                    const double zl = sign * zv[i + l];
+                    if (!(m[l] > 0.0)) vn[i + l] = 0.0;
+                    else if (psi[l] > 1.5) vn[i + l] = HestonQEStep::exponential_variance(m[l], psi[l], zl);
+                    else vn[i + l] = HestonQEStep::quadratic_variance(m[l], psi[l], zl);
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < nv; i += W) {
+            const VD vi = load_vec<VD>(v + i);
+            const VD vni = load_vec<VD>(vn + i);
+            VD var = qe.k3 * vi + qe.k4 * vni;
+            var = var > 0.0 ? var : VD{};
+            const VD xi = load_vec<VD>(x + i) + qe.k0 + qe.k1 * vi + qe.k2 * vni +
+                          vsqrt<VD, VI>(var) * (sign * load_vec<VD>(z + i));
+            store_vec(x + i, xi);
+            store_vec(v + i, vni);
+        }
+        heston_qe_scalar(qe, x + nv, v + nv, zv + nv, z + nv, n - nv, sign, vn + nv);
+    }
+
+    __attribute__((target("avx2")))
+    static void terminal_kernel_avx2(const TerminalParams& p, const double* z, std::size_t n,
+                                         PairMoments& acc) {
+        if (p.antithetic) terminal_kernel_vec<4, true>(p, z, n, acc);
+        else terminal_kernel_vec<4, false>(p, z, n, acc);
+    }
+
+    __attribute__((target("avx2")))
+    static void terminal_prices_avx2(double S0, double drift, double vol, const double* z,
+                                         std::size_t n, bool antithetic, double* out,
+                                         std::size_t out_stride) {
+        terminal_prices_vec<4>(S0, drift, vol, z, n, antithetic, out, out_stride);
+    }
+
+    __attribute__((target("avx2")))
+    static void payoff_moments_avx2(const double* ST, std::size_t n, double K, bool is_call,
+                                        PairMoments& acc) {
+        payoff_moments_vec<4>(ST, n, K, is_call, acc);
+    }
+
+    __attribute__((target("avx512f")))
+    static void terminal_kernel_avx512(const TerminalParams& p, const double* z, std::size_t n,
+                                           PairMoments& acc) {
+        if (p.antithetic) terminal_kernel_vec<8, true>(p, z, n, acc);
+        else terminal_kernel_vec<8, false>(p, z, n, acc);
+    }
+
+    __attribute__((target("avx512f")))
+    static void terminal_prices_avx512(double S0, double drift, double vol, const double* z,
+                                           std::size_t n, bool antithetic, double* out,
+                                           std::size_t out_stride) {
+        terminal_prices_vec<8>(S0, drift, vol, z, n, antithetic, out, out_stride);
+    }
+
+    __attribute__((target("avx512f")))
+    static void payoff_moments_avx512(const double* ST, std::size_t n, double K, bool is_call,
+                                          PairMoments& acc) {
+        payoff_moments_vec<8>(ST, n, K, is_call, acc);
+    }
+
+    __attribute__((target("avx2")))
+    static void terminal_kernel_f32_avx2(const TerminalParams& p, const float* z, std::size_t n,
+                                         PairMoments& acc) {
+        if (p.antithetic) terminal_kernel_f32_vec<8, true>(p, z, n, acc);
+        else terminal_kernel_f32_vec<8, false>(p, z, n, acc);
+    }
+
+    __attribute__((target("avx512f")))
+    static void terminal_kernel_f32_avx512(const TerminalParams& p, const float* z, std::size_t n,
+                                           PairMoments& acc) {
+        if (p.antithetic) terminal_kernel_f32_vec<16, true>(p, z, n, acc);
+        else terminal_kernel_f32_vec<16, false>(p, z, n, acc);
+    }
+
+    __attribute__((target("avx2")))
+    static void heston_qe_avx2(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                               const double* z, std::size_t n, double sign, double* scratch) {
+        heston_qe_vec<4>(qe, x, v, zv, z, n, sign, scratch);
+    }
+
+    __attribute__((target("avx512f")))
+    static void heston_qe_avx512(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                                 const double* z, std::size_t n, double sign, double* scratch) {
+        heston_qe_vec<8>(qe, x, v, zv, z, n, sign, scratch);
+    }
+#endif
+
+    // -----------------------------------------
+    // Dispatch
+    // -----------------------------------------
+
+    struct KernelTable {
+        void (*terminal)(const TerminalParams&, const double*, std::size_t, PairMoments&);
+        void (*prices)(double, double, double, const double*, std::size_t, bool, double*, std::size_t);
+        void (*payoff)(const double*, std::size_t, double, bool, PairMoments&);
+        void (*heston)(const HestonQEStep&, double*, double*, const double*, const double*,
+                       std::size_t, double, double*);
+        void (*terminal_f32)(const TerminalParams&, const float*, std::size_t, PairMoments&);
+        const char* isa;
+    };
+
+    static KernelTable select_kernels() {
+#if QUANT_X86_DISPATCH
+        if (cpu_has_avx512f()) {
+            return {terminal_kernel_avx512, terminal_prices_avx512, payoff_moments_avx512, heston_qe_avx512,
+                    terminal_kernel_f32_avx512, "avx512"};
+        }
+        if (cpu_has_avx2()) {
+            return {terminal_kernel_avx2, terminal_prices_avx2, payoff_moments_avx2, heston_qe_avx2,
+                    terminal_kernel_f32_avx2, "avx2"};
+        }
+#endif
+        return {terminal_kernel_scalar<double>, terminal_prices_scalar, payoff_moments_scalar, heston_qe_scalar,
+                terminal_kernel_scalar<float>, "scalar"};
+    }
+
+    static const KernelTable& kernels() {
+        static const KernelTable table = select_kernels();
+        return table;
+    }
+
+    void terminal_kernel(const TerminalParams& p, const double* z, std::size_t n, PairMoments& acc) {
+        kernels().terminal(p, z, n, acc);
+    }
+
+    void terminal_kernel_f32(const TerminalParams& p, const float* z, std::size_t n, PairMoments& acc) {
+        kernels().terminal_f32(p, z, n, acc);
+    }
+
+    void terminal_prices(double S0, double drift, double vol, const double* z, std::size_t n,
+                         bool antithetic, double* out, std::size_t out_stride) {
+        kernels().prices(S0, drift, vol, z, n, antithetic, out, out_stride);
+    }
+
+    void payoff_moments(const double* ST, std::size_t n, double K, bool is_call, PairMoments& acc) {
+        kernels().payoff(ST, n, K, is_call, acc);
+    }
+
+    void exp_array(const double* x, std::size_t n, double* out) {
+        // 1 * exp(0 + 1 * x) is exact in every kernel, so this is a plain exp
+        kernels().prices(1.0, 0.0, 1.0, x, n, false, out, 0);
+    }
+
+    void heston_qe_block(const HestonQEStep& qe, double* x, double* v, const double* zv,
+                         const double* z, std::size_t n, double sign, double* scratch) {
+        kernels().heston(qe, x, v, zv, z, n, sign, scratch);
+    }
+
+    const char* terminal_kernel_isa() {
+        return kernels().isa;
+    }
+}
@@ -0,0 +1,194 @@
+#include "quant/mc_lsm.hpp"
+#include "quant/bs.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/rng.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace quant {
+    // Draws per simulation task / paths per regression task, and paths advanced
+    // together inside a simulation task.
+    static constexpr std::size_t LSM_CHUNK_PATHS = 8192;
+    static constexpr std::size_t LSM_BLOCK = 256;
+    static constexpr std::size_t LSM_MAX_BASIS = 6;
+
+    // Normal equations sum(phi phi^T) beta = sum(phi y) of one regression, upper
+    // triangle only; mergeable so chunks reduce in a fixed order (merge_pairwise).
+    struct NormalEquations {
+        std::size_t n = 0;
+        double A[LSM_MAX_BASIS][LSM_MAX_BASIS] = {};
+        double b[LSM_MAX_BASIS] = {};
+
+        void merge(const NormalEquations& o) {
+            n += o.n;
+            for (std::size_t i = 0; i < LSM_MAX_BASIS; ++i) {
+                b[i] += o.b[i];
+                for (std::size_t j = i; j < LSM_MAX_BASIS; ++j) A[i][j] += o.A[i][j];
+            }
+        }
+    };
+
+    // Solve the d x d system by Cholesky; false when it is (numerically) singular.
+    static bool solve_normal_equations(const NormalEquations& ne, std::size_t d, double* beta) {
+        double L[LSM_MAX_BASIS][LSM_MAX_BASIS] = {};
+        for (std::size_t i = 0; i < d; ++i) {
+            for (std::size_t j = 0; j <= i; ++j) {
+                double s = ne.A[j][i];
+                for (std::size_t k = 0; k < j; ++k) s -= L[i][k] * L[j][k];
+                if (i == j) {
+                    if (s <= 1e-12 * ne.A[i][i] || s <= 0.0) return false;
+                    L[i][i] = std::sqrt(s);
+                } else {
+                    L[i][j] = s / L[j][j];
+                }
+            }
+        }
+        double y[LSM_MAX_BASIS];
+        for (std::size_t i = 0; i < d; ++i) {
+            double s = ne.b[i];
+            for (std::size_t k = 0; k < i; ++k) s -= L[i][k] * y[k];
+            y[i] = s / L[i][i];
+        }
+        for (std::size_t i = d; i-- > 0;) {
+            double s = y[i];
+            for (std::size_t k = i + 1; k < d; ++k) s -= L[k][i] * beta[k];
+            beta[i] = s / L[i][i];
+        }
+        return true;
+    }
+
+    MCResult monte_carlo_american(
+        double S0,
+        double K,
+        double sigma,
+        double T,
+        const MCOptions& opts,
+        bool is_call,
+        const LSMOptions& lsm
+    ) {
+        const std::size_t n_steps = std::max<std::size_t>(1, lsm.n_steps);
+        const std::size_t d = std::min<std::size_t>(std::max<std::size_t>(1, lsm.basis_degree), 5) + 1;
+        const uint64_t seed = mc_resolve_seed(opts.seed);
+        const bool use_antithetic = opts.use_antithetic;
+        const CounterRNG rng(seed);
+
+        const double dt = T / static_cast<double>(n_steps);
+        const double drift_dt = (opts.r - 0.5 * sigma * sigma) * dt;
+        const double vol_dt = sigma * std::sqrt(dt);
+        const double df = std::exp(-opts.r * dt);
+        const double sgn = is_call ? 1.0 : -1.0;
+        const double inv_K = 1.0 / K;
+
+        // Draw d drives path d and, when antithetic, path n_draws + d.
+        const std::size_t n_draws = use_antithetic ? (opts.n_paths + 1) / 2 : opts.n_paths;
+        const std::size_t n_p = use_antithetic ? 2 * n_draws : n_draws;
+        if (n_draws == 0) return MCResult{};
+
+        // Time-major spot matrix: S[k * n_p + p] is path p at t_{k+1}.
+        std::vector<double> S(n_steps * n_p);
+        const std::size_t n_sim_chunks = (n_draws + LSM_CHUNK_PATHS - 1) / LSM_CHUNK_PATHS;
+        mc_for_each_chunk(n_sim_chunks, opts, [&](std::size_t c) {
+            const std::size_t first = c * LSM_CHUNK_PATHS;
+            const std::size_t last = std::min(n_draws, first + LSM_CHUNK_PATHS);
+            double z[LSM_BLOCK], x[LSM_BLOCK], xa[LSM_BLOCK];
+            for (std::size_t base = first; base < last; base += LSM_BLOCK) {
+                const std::size_t m = std::min(LSM_BLOCK, last - base);
+                std::fill(x, x + m, 0.0);
+                std::fill(xa, xa + m, 0.0);
+                for (std::size_t k = 0; k < n_steps; ++k) {
+                    rng.normals(base, m, static_cast<uint32_t>(k), z);
+                    for (std::size_t i = 0; i < m; ++i) {
+                        x[i] += drift_dt + vol_dt * z[i];
+                        xa[i] += drift_dt - vol_dt * z[i];
+                    }
+                    double* row = &S[k * n_p];
+                    terminal_prices(S0, 0.0, 1.0, x, m, false, row + base, 0);
+                    if (use_antithetic) terminal_prices(S0, 0.0, 1.0, xa, m, false, row + n_draws + base, 0);
+                }
+            }
+        });
+
+        // Cash flow of each path under the current exercise policy, discounted to the
+        // date being processed; starts as the payoff at T.
+        std::vector<double> cf(n_p), european(n_p);
+        const double* ST = &S[(n_steps - 1) * n_p];
+        for (std::size_t p = 0; p < n_p; ++p) {
+            cf[p] = std::max(0.0, sgn * (ST[p] - K));
+            european[p] = cf[p];
+        }
+
+        const std::size_t n_chunks = (n_p + LSM_CHUNK_PATHS - 1) / LSM_CHUNK_PATHS;
+        std::vector<NormalEquations> ne(n_chunks);
+
+        for (std::size_t k = n_steps - 1; k-- > 0;) {
+            const double* row = &S[k * n_p];
+
+            // Fused pass per chunk: discount one step, then fold the in-the-money
+            // paths' basis outer products and cash flows into the normal equations.
+            mc_for_each_chunk(n_chunks, opts, [&](std::size_t c) {
+                NormalEquations local;
+                const std::size_t first = c * LSM_CHUNK_PATHS;
+                const std::size_t last = std::min(n_p, first + LSM_CHUNK_PATHS);
+                for (std::size_t p = first; p < last; ++p) {
+                    cf[p] *= df;
+                    if (sgn * (row[p] - K) <= 0.0) continue;
+                    double phi[LSM_MAX_BASIS];
+                    const double xk = row[p] * inv_K;
+                    phi[0] = 1.0;
+                    for (std::size_t j = 1; j < d; ++j) phi[j] = phi[j - 1] * xk;
+                    ++local.n;
+                    for (std::size_t i = 0; i < d; ++i) {
+                        local.b[i] += phi[i] * cf[p];
+                        for (std::size_t j = i; j < d; ++j) local.A[i][j] += phi[i] * phi[j];
+                    }
+                }
+                ne[c] = local;
+            });
+
+            std::vector<NormalEquations> parts(ne);
+            const NormalEquations total = merge_pairwise(parts.data(), parts.size());
+            double beta[LSM_MAX_BASIS] = {};
+            if (total.n <= d || !solve_normal_equations(total, d, beta)) continue;
+
+            // Exercise where the immediate payoff beats the regressed continuation value.
+            mc_for_each_chunk(n_chunks, opts, [&](std::size_t c) {
+                const std::size_t first = c * LSM_CHUNK_PATHS;
+                const std::size_t last = std::min(n_p, first + LSM_CHUNK_PATHS);
+                for (std::size_t p = first; p < last; ++p) {
+                    const double exercise = sgn * (row[p] - K);
+                    if (exercise <= 0.0) continue;
+                    const double xk = row[p] * inv_K;
+                    double cont = beta[d - 1];
+                    for (std::size_t j = d - 1; j-- > 0;) cont = cont * xk + beta[j];
+                    if (exercise > cont) cf[p] = exercise;
+                }
+            });
+        }
+
+        // Back to t = 0; the European payoff is the control (E = its BS price).
+        const double disc_T = std::exp(-opts.r * T);
+        std::vector<PairMoments> acc(n_chunks);
+        mc_for_each_chunk(n_chunks, opts, [&](std::size_t c) {
+            PairMoments local;
+            const std::size_t first = c * LSM_CHUNK_PATHS;
+            const std::size_t last = std::min(n_p, first + LSM_CHUNK_PATHS);
+            for (std::size_t p = first; p < last; ++p) local.add(cf[p] * df, european[p] * disc_T);
+            acc[c] = local;
+        });
+        const PairMoments total = merge_pairwise(acc.data(), acc.size());
+        const BSInputs in{S0, K, opts.r, sigma, T};
+        const double EX = is_call ? bs_call(in) : bs_put(in);
+        MCResult res = mc_result_from_moments(total, EX, 1.0, opts.use_control_variate);
+
+        // exercising at t = 0 is also allowed
+        const double intrinsic = std::max(0.0, sgn * (S0 - K));
+        if (intrinsic > res.price) {
+            res.price = intrinsic;
+            res.stderr_ = 0.0;
+            res.ci_low = res.ci_high = intrinsic;
+        }
+        return res;
+    }
+}
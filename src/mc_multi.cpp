@@ -0,0 +1,190 @@
+#include "quant/mc_multi.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/rng.hpp"
+#include "quant/sobol.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace quant {
+    // Draws per pool task and paths per block inside a task; a block holds one row of
+    // 2 * MULTI_BLOCK doubles per asset.
+    static constexpr std::size_t MULTI_CHUNK_DRAWS = 8192;
+    static constexpr std::size_t MULTI_BLOCK = 256;
+
+    // -----------------------------------------
+    // Payoffs
+    // -----------------------------------------
+
+    static inline double vanilla(double S, double K, bool is_call) {
+        return is_call ? std::max(0.0, S - K) : std::max(0.0, K - S);
+    }
+
+    MultiAssetPayoff basket_option(std::vector<double> weights, double K, bool is_call) {
+        MultiAssetPayoff p;
+        p.fn = [weights = std::move(weights), K, is_call](const BasketState& s) {
+            double b = 0.0;
+            const std::size_t n = std::min(weights.size(), s.n_assets);
+            for (std::size_t i = 0; i < n; ++i) b += weights[i] * s.S_T[i];
+            return vanilla(b, K, is_call);
+        };
+        return p;
+    }
+
+    MultiAssetPayoff spread_option(double K, bool is_call) {
+        MultiAssetPayoff p;
+        p.fn = [K, is_call](const BasketState& s) {
+            return s.n_assets < 2 ? 0.0 : vanilla(s.S_T[0] - s.S_T[1], K, is_call);
+        };
+        return p;
+    }
+
+    MultiAssetPayoff worst_of(double K, bool is_call) {
+        MultiAssetPayoff p;
+        p.fn = [K, is_call](const BasketState& s) {
+            double worst = s.S_T[0] / s.S0[0];
+            for (std::size_t i = 1; i < s.n_assets; ++i) worst = std::min(worst, s.S_T[i] / s.S0[i]);
+            return vanilla(worst, K, is_call);
+        };
+        return p;
+    }
+
+    // -----------------------------------------
+    // Engine
+    // -----------------------------------------
+
+    bool cholesky_factor(const std::vector<double>& corr, std::size_t n, std::vector<double>& L) {
+        if (corr.size() != n * n) return false;
+        L.assign(n * n, 0.0);
+        const double tol = 1e-12;
+        for (std::size_t i = 0; i < n; ++i) {
+            for (std::size_t j = 0; j <= i; ++j) {
+                if (std::fabs(corr[i * n + j] - corr[j * n + i]) > tol) return false;
+                double s = corr[i * n + j];
+                for (std::size_t k = 0; k < j; ++k) s -= L[i * n + k] * L[j * n + k];
+                if (i == j) {
+                    // semi-definite (e.g. correlation 1) leaves a zero pivot
+                    if (s < -tol) return false;
+                    L[i * n + i] = std::sqrt(std::max(s, 0.0));
+                } else {
+                    L[i * n + j] = L[j * n + j] > 0.0 ? s / L[j * n + j] : 0.0;
+                }
+            }
+        }
+        return true;
+    }
+
+    MCResult monte_carlo_multi(
+        const MultiAssetModel& model,
+        double T,
+        const MultiAssetPayoff& payoff,
+        const MCOptions& opts
+    ) {
+        const std::size_t n_assets = model.S0.size();
+        std::vector<double> L;
+        if (n_assets == 0 || model.sigma.size() != n_assets ||
+            (!model.q.empty() && model.q.size() != n_assets) ||
+            !cholesky_factor(model.correlation, n_assets, L)) {
+            return MCResult{};
+        }
+
+        const uint64_t seed = mc_resolve_seed(opts.seed);
+        const bool use_qmc = opts.use_qmc;
+        const bool use_antithetic = opts.use_antithetic && !use_qmc;
+        const CounterRNG rng(seed);
+
+        std::vector<double> drift(n_assets), vol(n_assets);
+        double EX = 0.0;   // E[mean_i S_T[i] / S0[i]]
+        for (std::size_t i = 0; i < n_assets; ++i) {
+            const double q = model.q.empty() ? 0.0 : model.q[i];
+            drift[i] = (opts.r - q - 0.5 * model.sigma[i] * model.sigma[i]) * T;
+            vol[i] = model.sigma[i] * std::sqrt(T);
+            EX += std::exp((opts.r - q) * T);
+        }
+        EX /= static_cast<double>(n_assets);
+        const double inv_n = 1.0 / static_cast<double>(n_assets);
+
+        // QMC: one n_assets-dimensional Sobol sequence per scrambling (replicate).
+        const std::size_t n_reps = use_qmc ? std::max<std::size_t>(2, opts.qmc_scrambles) : 1;
+        std::vector<SobolSequence> sobol;
+        if (use_qmc) {
+            sobol.reserve(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                sobol.emplace_back(static_cast<uint32_t>(n_assets), SobolSequence::replicate_seed(seed, r));
+            }
+        }
+
+        const std::size_t n_draws = use_qmc ? (opts.n_paths + n_reps - 1) / n_reps
+                                  : use_antithetic ? (opts.n_paths + 1) / 2 : opts.n_paths;
+        const std::size_t chunks_per_rep = (n_draws + MULTI_CHUNK_DRAWS - 1) / MULTI_CHUNK_DRAWS;
+        const std::size_t n_chunks = n_reps * chunks_per_rep;
+        std::vector<PairMoments> acc(n_chunks);
+
+        auto price_chunk = [&](std::size_t t) {
+            PairMoments local;
+            const std::size_t rep = t / chunks_per_rep;
+            const std::size_t first = (t % chunks_per_rep) * MULTI_CHUNK_DRAWS;
+            const std::size_t last = std::min(n_draws, first + MULTI_CHUNK_DRAWS);
+
+            // Asset-major rows: z[j * MULTI_BLOCK + i] independent normals, w the
+            // correlated ones, ST[j * 2 * MULTI_BLOCK + i] terminal prices (antithetic
+            // twins at + MULTI_BLOCK).
+            std::vector<double> z(n_assets * MULTI_BLOCK), w(MULTI_BLOCK);
+            std::vector<double> ST(n_assets * 2 * MULTI_BLOCK), S_path(n_assets);
+
+            for (std::size_t base = first; base < last; base += MULTI_BLOCK) {
+                const std::size_t m = std::min(MULTI_BLOCK, last - base);
+                const std::size_t n = use_antithetic ? 2 * m : m;
+                for (std::size_t j = 0; j < n_assets; ++j) {
+                    double* zj = &z[j * MULTI_BLOCK];
+                    if (use_qmc) sobol[rep].normals(base, m, static_cast<uint32_t>(j), zj);
+                    else rng.normals(base, m, static_cast<uint32_t>(j), zj);
+                }
+                for (std::size_t a = 0; a < n_assets; ++a) {
+                    // w = sum_{j <= a} L[a][j] z_j, a flat loop per factor
+                    std::fill(w.begin(), w.begin() + m, 0.0);
+                    for (std::size_t j = 0; j <= a; ++j) {
+                        const double l = L[a * n_assets + j];
+                        if (l == 0.0) continue;
+                        const double* zj = &z[j * MULTI_BLOCK];
+                        for (std::size_t i = 0; i < m; ++i) w[i] += l * zj[i];
+                    }
+                    terminal_prices(model.S0[a], drift[a], vol[a], w.data(), m, use_antithetic,
+                                    &ST[a * 2 * MULTI_BLOCK], m);
+                }
+
+                for (std::size_t i = 0; i < n; ++i) {
+                    double x = 0.0;
+                    for (std::size_t a = 0; a < n_assets; ++a) {
+                        S_path[a] = ST[a * 2 * MULTI_BLOCK + i];
+                        x += S_path[a] / model.S0[a];
+                    }
+                    const BasketState bs{model.S0.data(), S_path.data(), n_assets};
+                    local.add(payoff.fn(bs), x * inv_n);
+                }
+            }
+            acc[t] = local;
+        };
+
+        const double disc = std::exp(-opts.r * T);
+
+        std::vector<PairMoments> scratch;
+        const std::size_t done = mc_run_chunks(n_chunks, opts, price_chunk, [&](std::size_t k) {
+            scratch.assign(acc.begin(), acc.begin() + k);
+            return mc_result_from_moments(merge_pairwise(scratch.data(), k), EX, disc,
+                                          opts.use_control_variate).stderr_;
+        });
+        acc.resize(done);
+
+        if (use_qmc) {
+            std::vector<PairMoments> reps(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                reps[r] = merge_pairwise(&acc[r * chunks_per_rep], chunks_per_rep);
+            }
+            return mc_result_from_replicates(reps, EX, disc, opts.use_control_variate);
+        }
+        const PairMoments total = merge_pairwise(acc.data(), acc.size());
+        return mc_result_from_moments(total, EX, disc, opts.use_control_variate);
+    }
+}
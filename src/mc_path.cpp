@@ -0,0 +1,292 @@
+#include "quant/mc_path.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/rng.hpp"
+#include "quant/sobol.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace quant {
+    // Draws per pool task and paths advanced together inside a task. A block's running
+    // state (a few arrays of 2 * PATH_BLOCK doubles) stays in L1/L2 across all steps.
+    static constexpr std::size_t PATH_CHUNK_DRAWS = 4096;
+    static constexpr std::size_t PATH_BLOCK = 256;
+
+    // -----------------------------------------
+    // Payoffs
+    // -----------------------------------------
+
+    static inline double vanilla(double S, double K, bool is_call) {
+        return is_call ? std::max(0.0, S - K) : std::max(0.0, K - S);
+    }
+
+    PathPayoff european_option(double K, bool is_call) {
+        PathPayoff p;
+        p.fn = [K, is_call](const PathState& s) { return vanilla(s.S_T, K, is_call); };
+        return p;
+    }
+
+    PathPayoff asian_arithmetic(double K, bool is_call) {
+        PathPayoff p;
+        p.fn = [K, is_call](const PathState& s) { return vanilla(s.average, K, is_call); };
+        return p;
+    }
+
+    PathPayoff barrier_option(double K, double barrier, BarrierKind kind, bool is_call) {
+        PathPayoff p;
+        const bool up = kind == BarrierKind::UpAndOut || kind == BarrierKind::UpAndIn;
+        const bool out = kind == BarrierKind::UpAndOut || kind == BarrierKind::DownAndOut;
+        if (up) p.barrier_up = barrier;
+        else p.barrier_down = barrier;
+        p.fn = [K, is_call, up, out](const PathState& s) {
+            const double survival = up ? s.survival_up : s.survival_down;
+            return vanilla(s.S_T, K, is_call) * (out ? survival : 1.0 - survival);
+        };
+        return p;
+    }
+
+    PathPayoff lookback_floating(bool is_call) {
+        PathPayoff p;
+        p.fn = [is_call](const PathState& s) { return is_call ? s.S_T - s.min : s.max - s.S_T; };
+        return p;
+    }
+
+    PathPayoff lookback_fixed(double K, bool is_call) {
+        PathPayoff p;
+        p.fn = [K, is_call](const PathState& s) {
+            return is_call ? std::max(0.0, s.max - K) : std::max(0.0, K - s.min);
+        };
+        return p;
+    }
+
+    // -----------------------------------------
+    // Engine
+    // -----------------------------------------
+
+    // Brownian-bridge construction on n equal steps (unit step variance): the first
+    // normal sets the terminal value, each later one fills the midpoint of the widest
+    // remaining gap. Under QMC this puts the low, best-distributed Sobol dimensions on
+    // the coarse path shape that drives most of the payoff variance.
+    class BrownianBridge {
+    public:
+        explicit BrownianBridge(std::size_t n)
+            : n_(n), bridge_(n), left_(n), right_(n), lw_(n), rw_(n), sd_(n), w_(n) {
+            std::vector<std::size_t> filled(n, 0);
+            filled[n - 1] = 1;
+            bridge_[0] = n - 1;
+            sd_[0] = std::sqrt(static_cast<double>(n));
+            std::size_t j = 0;
+            for (std::size_t i = 1; i < n; ++i) {
+                while (filled[j]) ++j;
+                std::size_t k = j;
+                while (!filled[k]) ++k;            // first filled point right of the gap
+                const std::size_t l = j + ((k - 1 - j) >> 1);
+                filled[l] = 1;
+                bridge_[i] = l;
+                left_[i] = j;                      // gap starts after point j - 1 (or t = 0)
+                right_[i] = k;
+                const double span = static_cast<double>(k + 1 - j);
+                lw_[i] = static_cast<double>(k - l) / span;
+                rw_[i] = static_cast<double>(l + 1 - j) / span;
+                sd_[i] = std::sqrt(static_cast<double>((l + 1 - j) * (k - l)) / span);
+                j = k + 1;
+                if (j >= n) j = 0;
+            }
+        }
+
+        // z[0..n) (bridge order) -> standard normal step increments out[0..n).
+        void build(const double* z, double* out) {
+            double* w = w_.data();
+            w[n_ - 1] = sd_[0] * z[0];
+            for (std::size_t i = 1; i < n_; ++i) {
+                const std::size_t l = bridge_[i];
+                const double left = left_[i] ? w[left_[i] - 1] : 0.0;
+                w[l] = lw_[i] * left + rw_[i] * w[right_[i]] + sd_[i] * z[i];
+            }
+            out[0] = w[0];
+            for (std::size_t i = 1; i < n_; ++i) out[i] = w[i] - w[i - 1];
+        }
+
+    private:
+        std::size_t n_;
+        std::vector<std::size_t> bridge_, left_, right_;
+        std::vector<double> lw_, rw_, sd_;
+        std::vector<double> w_;   // scratch: W at each step
+    };
+
+    // Running state of up to 2 * PATH_BLOCK paths (antithetic twins in the upper half),
+    // structure-of-arrays so each step is a few flat loops.
+    struct PathBlockState {
+        std::vector<double> x, x_prev;   // ln(S / S0) now and one step back
+        std::vector<double> S, sum, mn, mx;
+        std::vector<double> surv_up, surv_down;
+        std::vector<double> z, tmp;
+
+        PathBlockState()
+            : x(2 * PATH_BLOCK), x_prev(2 * PATH_BLOCK), S(2 * PATH_BLOCK), sum(2 * PATH_BLOCK),
+              mn(2 * PATH_BLOCK), mx(2 * PATH_BLOCK), surv_up(2 * PATH_BLOCK),
+              surv_down(2 * PATH_BLOCK), z(PATH_BLOCK), tmp(2 * PATH_BLOCK) {}
+    };
+
+    // Fold one barrier into surv[0..n) for the step x_prev -> x, with the level at
+    // log-distance lnB from S0 and sign +1 (up) / -1 (down). A touch at a simulated point
+    // zeroes survival; with the bridge, a path that stays on the safe side survives the
+    // step with probability 1 - exp(-2 a b / (sigma^2 dt)), a and b its log-distances to
+    // the barrier at both ends.
+    static void monitor_barrier(PathBlockState& st, std::size_t n, double lnB, double sign,
+                                double inv_var_dt, bool bridge, double* surv) {
+        double* e = st.tmp.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            const double a = sign * (lnB - st.x_prev[i]);
+            const double b = sign * (lnB - st.x[i]);
+            const bool alive = a > 0.0 && b > 0.0;
+            // exp(0) = 1 turns a touched path's factor into 0 below
+            e[i] = alive ? (bridge ? -2.0 * a * b * inv_var_dt : -INFINITY) : 0.0;
+        }
+        exp_array(e, n, e);
+        for (std::size_t i = 0; i < n; ++i) surv[i] *= 1.0 - e[i];
+    }
+
+    MCResult monte_carlo_path(
+        double S0,
+        double sigma,
+        double T,
+        const PathPayoff& payoff,
+        const MCOptions& opts,
+        const PathMCOptions& path_opts
+    ) {
+        const std::size_t n_steps = std::max<std::size_t>(1, path_opts.n_steps);
+        const uint64_t seed = mc_resolve_seed(opts.seed);
+        const bool use_qmc = opts.use_qmc;
+        const bool use_antithetic = opts.use_antithetic && !use_qmc;
+        const CounterRNG rng(seed);
+
+        const double dt = T / static_cast<double>(n_steps);
+        const double drift_dt = (opts.r - 0.5 * sigma * sigma) * dt;
+        const double vol_dt = sigma * std::sqrt(dt);
+        const double inv_var_dt = 1.0 / (sigma * sigma * dt);
+        const bool has_up = payoff.barrier_up > 0.0;
+        const bool has_down = payoff.barrier_down > 0.0;
+        const double lnB_up = has_up ? std::log(payoff.barrier_up / S0) : 0.0;
+        const double lnB_down = has_down ? std::log(payoff.barrier_down / S0) : 0.0;
+
+        // QMC: one n_steps-dimensional Sobol sequence per scrambling (replicate),
+        // mapped to steps through the Brownian bridge.
+        const std::size_t n_reps = use_qmc ? std::max<std::size_t>(2, opts.qmc_scrambles) : 1;
+        std::vector<SobolSequence> sobol;
+        if (use_qmc) {
+            sobol.reserve(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                sobol.emplace_back(static_cast<uint32_t>(n_steps), SobolSequence::replicate_seed(seed, r));
+            }
+        }
+
+        const std::size_t n_draws = use_qmc ? (opts.n_paths + n_reps - 1) / n_reps
+                                  : use_antithetic ? (opts.n_paths + 1) / 2 : opts.n_paths;
+        const std::size_t chunks_per_rep = (n_draws + PATH_CHUNK_DRAWS - 1) / PATH_CHUNK_DRAWS;
+        const std::size_t n_chunks = n_reps * chunks_per_rep;
+        std::vector<PairMoments> acc(n_chunks);
+
+        auto price_chunk = [&](std::size_t t) {
+            PairMoments local;
+            PathBlockState st;
+            const std::size_t rep = t / chunks_per_rep;
+            const std::size_t first = (t % chunks_per_rep) * PATH_CHUNK_DRAWS;
+            const std::size_t last = std::min(n_draws, first + PATH_CHUNK_DRAWS);
+
+            // QMC only: the block's step normals, step-major ([k * PATH_BLOCK + i]), so
+            // memory is O(PATH_BLOCK x n_steps) per task.
+            std::vector<double> zq;
+            std::vector<double> zpath, incr;
+            std::unique_ptr<BrownianBridge> bridge;
+            if (use_qmc) {
+                zq.resize(n_steps * PATH_BLOCK);
+                zpath.resize(n_steps);
+                incr.resize(n_steps);
+                bridge.reset(new BrownianBridge(n_steps));
+            }
+
+            for (std::size_t base = first; base < last; base += PATH_BLOCK) {
+                const std::size_t m = std::min(PATH_BLOCK, last - base);
+                const std::size_t n = use_antithetic ? 2 * m : m;
+                std::fill(st.x.begin(), st.x.begin() + n, 0.0);
+                std::fill(st.sum.begin(), st.sum.begin() + n, 0.0);
+                std::fill(st.mn.begin(), st.mn.begin() + n, S0);
+                std::fill(st.mx.begin(), st.mx.begin() + n, S0);
+                std::fill(st.surv_up.begin(), st.surv_up.begin() + n, 1.0);
+                std::fill(st.surv_down.begin(), st.surv_down.begin() + n, 1.0);
+
+                if (use_qmc) {
+                    for (std::size_t k = 0; k < n_steps; ++k) {
+                        sobol[rep].normals(base, m, static_cast<uint32_t>(k), &zq[k * PATH_BLOCK]);
+                    }
+                    for (std::size_t i = 0; i < m; ++i) {
+                        for (std::size_t k = 0; k < n_steps; ++k) zpath[k] = zq[k * PATH_BLOCK + i];
+                        bridge->build(zpath.data(), incr.data());
+                        for (std::size_t k = 0; k < n_steps; ++k) zq[k * PATH_BLOCK + i] = incr[k];
+                    }
+                }
+
+                for (std::size_t k = 0; k < n_steps; ++k) {
+                    const double* z = st.z.data();
+                    if (use_qmc) z = &zq[k * PATH_BLOCK];
+                    else rng.normals(base, m, static_cast<uint32_t>(k), st.z.data());
+                    std::copy(st.x.begin(), st.x.begin() + n, st.x_prev.begin());
+                    for (std::size_t i = 0; i < m; ++i) {
+                        st.x[i] += drift_dt + vol_dt * z[i];
+                        if (use_antithetic) st.x[m + i] += drift_dt - vol_dt * z[i];
+                    }
+                    // S = S0 * exp(x) with the vector exp (drift 0, vol 1)
+                    terminal_prices(S0, 0.0, 1.0, st.x.data(), n, false, st.S.data(), 0);
+                    for (std::size_t i = 0; i < n; ++i) {
+                        st.sum[i] += st.S[i];
+                        st.mn[i] = std::min(st.mn[i], st.S[i]);
+                        st.mx[i] = std::max(st.mx[i], st.S[i]);
+                    }
+                    if (has_up) {
+                        monitor_barrier(st, n, lnB_up, 1.0, inv_var_dt, path_opts.brownian_bridge,
+                                        st.surv_up.data());
+                    }
+                    if (has_down) {
+                        monitor_barrier(st, n, lnB_down, -1.0, inv_var_dt, path_opts.brownian_bridge,
+                                        st.surv_down.data());
+                    }
+                }
+
+                for (std::size_t i = 0; i < n; ++i) {
+                    PathState ps;
+                    ps.S0 = S0;
+                    ps.S_T = st.S[i];
+                    ps.average = st.sum[i] / static_cast<double>(n_steps);
+                    ps.min = st.mn[i];
+                    ps.max = st.mx[i];
+                    ps.survival_up = st.surv_up[i];
+                    ps.survival_down = st.surv_down[i];
+                    local.add(payoff.fn(ps), ps.S_T);
+                }
+            }
+            acc[t] = local;
+        };
+
+        const double EX = S0 * std::exp(opts.r * T);
+        const double disc = std::exp(-opts.r * T);
+
+        std::vector<PairMoments> scratch;
+        const std::size_t done = mc_run_chunks(n_chunks, opts, price_chunk, [&](std::size_t k) {
+            scratch.assign(acc.begin(), acc.begin() + k);
+            return mc_result_from_moments(merge_pairwise(scratch.data(), k), EX, disc,
+                                          opts.use_control_variate).stderr_;
+        });
+        acc.resize(done);
+        if (use_qmc) {
+            std::vector<PairMoments> reps(n_reps);
+            for (std::size_t r = 0; r < n_reps; ++r) {
+                reps[r] = merge_pairwise(&acc[r * chunks_per_rep], chunks_per_rep);
+            }
+            return mc_result_from_replicates(reps, EX, disc, opts.use_control_variate);
+        }
+        const PairMoments total = merge_pairwise(acc.data(), acc.size());
+        return mc_result_from_moments(total, EX, disc, opts.use_control_variate);
+    }
+}
@@ -0,0 +1,213 @@
+#include "quant/multicast_feed.hpp"
+#include "quant/wire_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace quant {
+
+static void put_u16_be(uint8_t* p, uint16_t v) {
+    p[0] = (v >> 8) & 0xFF;
+    p[1] = v & 0xFF;
+}
+
+static void put_u64_be(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = (v >> ((7 - i) * 8)) & 0xFF;
+}
+
+// Frame an arbitrary payload as [4-byte BE len][type][body].
+static std::vector<uint8_t> frame_payload(MsgType type, const uint8_t* body, std::size_t n) {
+    std::vector<uint8_t> out(4 + 1 + n);
+    uint32_t len = static_cast<uint32_t>(1 + n);
+    out[0] = (len >> 24) & 0xFF;
+    out[1] = (len >> 16) & 0xFF;
+    out[2] = (len >> 8) & 0xFF;
+    out[3] = len & 0xFF;
+    out[4] = static_cast<uint8_t>(type);
+    if (n) std::memcpy(out.data() + 5, body, n);
+    return out;
+}
+
+MulticastPublisher::MulticastPublisher(const std::string& group, int port,
+                                       const std::string& iface, int ttl,
+                                       std::size_t ring_packets)
+    : group_(group), port_(port), iface_(iface), ttl_(ttl),
+      fd_(QINVALID_SOCKET), ring_(std::max<std::size_t>(2, ring_packets))
+{
+    std::memset(&dest_, 0, sizeof(dest_));
+    for (auto& p : ring_) p.bytes.reserve(MAX_DATAGRAM);
+    begin_packet();
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    close();
+}
+
+bool MulticastPublisher::open() {
+    if (fd_ != QINVALID_SOCKET) return true;
+
+    fd_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd_ == QINVALID_SOCKET) {
+        std::cerr << "[mcast] socket() failed errno=" << q_last_error() << "\n";
+        return false;
+    }
+
+    dest_.sin_family = AF_INET;
+    dest_.sin_port = htons(static_cast<uint16_t>(port_));
+    if (inet_pton(AF_INET, group_.c_str(), &dest_.sin_addr) != 1) {
+        std::cerr << "[mcast] bad group address " << group_ << "\n";
+        close();
+        return false;
+    }
+
+    in_addr local{};
+    if (inet_pton(AF_INET, iface_.c_str(), &local) != 1) {
+        std::cerr << "[mcast] bad interface address " << iface_ << "\n";
+        close();
+        return false;
+    }
+
+    // Loopback delivery lets publisher and subscribers share a host (and tests run on lo).
+    unsigned char loop = 1;
+    unsigned char ttl = static_cast<unsigned char>(ttl_);
+    if (setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&local, sizeof(local)) != 0 ||
+        setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl)) != 0 ||
+        setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loop, sizeof(loop)) != 0) {
+        std::cerr << "[mcast] setsockopt failed errno=" << q_last_error() << "\n";
+        close();
+        return false;
+    }
+
+    q_set_nonblocking(fd_);
+    std::cout << "[mcast] publishing to " << group_ << ":" << port_ << " via " << iface_ << "\n";
+    return true;
+}
+
+void MulticastPublisher::close() {
+    if (fd_ != QINVALID_SOCKET) {
+        q_close(fd_);
+        fd_ = QINVALID_SOCKET;
+    }
+}
+
+bool MulticastPublisher::is_feed_message(MsgType type) {
+    return type == TRADE || type == TOB || type == L2_UPDATE || type == DEPTH_UPDATE || type == BAR;
+}
+
+void MulticastPublisher::begin_packet() {
+    Packet& p = ring_[head_];
+    p.first_seq = next_seq_;
+    p.count = 0;
+    p.bytes.clear();
+    p.bytes.resize(HEADER_SIZE);
+}
+
+void MulticastPublisher::apply_to_cache(const ServerMessage& msg) {
+    if (msg.type == TOB) {
+        BookCache& book = books_[msg.tob.instrument_id];
+        book.last_tob = msg;
+        book.have_tob = true;
+    } else if (msg.type == L2_UPDATE) {
+        // legacy per-level frame: carries no instrument
+        auto& side = books_[DEFAULT_INSTRUMENT_ID].levels[msg.l2.side & 1];
+        if (msg.l2.quantity == 0) side.erase(msg.l2.price);
+        else side[msg.l2.price] = msg.l2.quantity;
+    } else if (msg.type == DEPTH_UPDATE) {
+        auto& side = books_[msg.depth.instrument_id].levels[msg.depth.side & 1];
+        if (msg.depth.is_snapshot) side.clear();
+        for (uint8_t i = 0; i < msg.depth.count; ++i) {
+            const DepthLevel& lv = msg.depth.levels[i];
+            if (lv.quantity == 0) side.erase(lv.price);
+            else side[lv.price] = lv.quantity;
+        }
+    }
+}
+
+void MulticastPublisher::publish(const ServerMessage& msg, const std::vector<uint8_t>& framed) {
+    Packet* p = &ring_[head_];
+    if (p->count > 0 &&
+        (p->bytes.size() + framed.size() > MAX_DATAGRAM || p->count == UINT16_MAX)) {
+        flush();
+        p = &ring_[head_];
+    }
+    p->bytes.insert(p->bytes.end(), framed.begin(), framed.end());
+    ++p->count;
+    ++next_seq_;
+    apply_to_cache(msg);
+}
+
+void MulticastPublisher::flush() {
+    Packet& p = ring_[head_];
+    if (p.count == 0) return;
+
+    put_u64_be(p.bytes.data(), p.first_seq);
+    put_u16_be(p.bytes.data() + 8, p.count);
+
+    if (fd_ != QINVALID_SOCKET) {
+        // A dropped datagram is recoverable through recover(); never block the network loop.
+        sendto(fd_, (const char*)p.bytes.data(), static_cast<int>(p.bytes.size()), 0,
+               (const sockaddr*)&dest_, sizeof(dest_));
+    }
+
+    head_ = (head_ + 1) % ring_.size();
+    // one slot is always the pending datagram
+    sent_packets_ = std::min(sent_packets_ + 1, ring_.size() - 1);
+    begin_packet();
+}
+
+void MulticastPublisher::append_snapshot(std::vector<std::vector<uint8_t>>& out_frames) const {
+    // Best-first per side: the first frame replaces the side, the rest add deeper levels.
+    auto emit_side = [&](uint32_t instrument_id, uint8_t side, auto begin, auto end) {
+        ServerMessage sm{};
+        sm.type = DEPTH_UPDATE;
+        sm.depth = DepthUpdate{};
+        sm.depth.instrument_id = instrument_id;
+        sm.depth.side = side;
+        sm.depth.is_snapshot = 1;
+        for (auto it = begin; it != end; ++it) {
+            sm.depth.levels[sm.depth.count++] = DepthLevel{it->first, it->second};
+            if (sm.depth.count == MAX_DEPTH_LEVELS) {
+                out_frames.push_back(pack_server_message(sm));
+                sm.depth.is_snapshot = 0;
+                sm.depth.count = 0;
+            }
+        }
+        if (sm.depth.count > 0 || sm.depth.is_snapshot) out_frames.push_back(pack_server_message(sm));
+    };
+    for (const auto& kv : books_) {
+        const BookCache& book = kv.second;
+        if (book.have_tob) out_frames.push_back(pack_server_message(book.last_tob));
+        emit_side(kv.first, 0, book.levels[0].rbegin(), book.levels[0].rend());
+        emit_side(kv.first, 1, book.levels[1].begin(), book.levels[1].end());
+    }
+
+    uint8_t body[8];
+    put_u64_be(body, last_seq());
+    out_frames.push_back(frame_payload(SNAPSHOT_END, body, sizeof(body)));
+}
+
+void MulticastPublisher::recover(uint64_t from_seq, uint64_t to_seq,
+                                 std::vector<std::vector<uint8_t>>& out_frames) const {
+    if (to_seq < from_seq) return;
+
+    // Oldest retained datagram; anything before it can only be served by a snapshot.
+    const std::size_t n = ring_.size();
+    const std::size_t oldest = (head_ + n - sent_packets_) % n;
+    const uint64_t oldest_seq = sent_packets_ ? ring_[oldest].first_seq : next_seq_;
+
+    if (from_seq < oldest_seq) {
+        append_snapshot(out_frames);
+        return;
+    }
+
+    for (std::size_t k = 0; k < sent_packets_; ++k) {
+        const Packet& p = ring_[(oldest + k) % n];
+        const uint64_t last = p.first_seq + p.count - 1;
+        if (last < from_seq) continue;
+        if (p.first_seq > to_seq) break;
+        out_frames.push_back(frame_payload(MD_PACKET, p.bytes.data(), p.bytes.size()));
+    }
+}
+
+} // namespace quant
@@ -13,6 +13,8 @@
 #include "quant/network_server.hpp"
 #include "quant/server.hpp"
 #include "quant/messages.hpp"
+#include "quant/wire_codec.hpp"
+#include "quant/multicast_feed.hpp"
 
 #include <vector>
 #include <deque>
@@ -31,18 +33,27 @@
   using sock_t = SOCKET;
   #define CLOSESOCKET(s) closesocket(s)
   #define SOCKET_ERRNO() WSAGetLastError()
+  #define SEND_FLAGS 0
 #else
   #define QPLAT_WINDOWS 0
   #include <sys/types.h>
   #include <sys/socket.h>
   #include <netinet/in.h>
   #include <arpa/inet.h>
+  #include <sys/un.h>
+  #include <sys/uio.h>
   #include <unistd.h>
   #include <fcntl.h>
   using sock_t = int;
   #define INVALID_SOCKET (-1)
   #define CLOSESOCKET(s) close(s)
   #define SOCKET_ERRNO() errno
+  // a peer that closed makes send() fail with EPIPE instead of raising SIGPIPE
+  #ifdef MSG_NOSIGNAL
+    #define SEND_FLAGS MSG_NOSIGNAL
+  #else
+    #define SEND_FLAGS 0
+  #endif
 #endif
 
 namespace quant {
@@ -59,21 +70,72 @@ static bool set_nonblocking(sock_t s) {
 #endif
 }
 
-// helper to write big-endian 32-bit length
-static void write_u32_be(std::vector<uint8_t>& buf, uint32_t v) {
-    buf.push_back((v >> 24) & 0xFF);
-    buf.push_back((v >> 16) & 0xFF);
-    buf.push_back((v >> 8) & 0xFF);
-    buf.push_back((v >> 0) & 0xFF);
-}
-
 NetworkServer::NetworkServer(MatchingServer* engine, int port)
-    : engine_(engine), port_(port), running_(false), listen_fd_(INVALID_SOCKET) {}
+    : engine_(engine), port_(port), running_(false), listen_fd_(INVALID_SOCKET),
+      unix_fd_(INVALID_SOCKET) {}
 
 NetworkServer::~NetworkServer() {
     stop();
 }
 
+bool NetworkServer::listen_unix(const std::string& path, bool seqpacket) {
+#if QPLAT_WINDOWS
+    (void)path; (void)seqpacket;
+    std::cerr << "[net] AF_UNIX listener not supported on this platform\n";
+    return false;
+#else
+    if (running_) return false;
+    unix_path_ = path;
+    unix_seqpacket_ = seqpacket;
+    return true;
+#endif
+}
+
+bool NetworkServer::enable_multicast(const std::string& group, int port,
+                                     const std::string& iface, int ttl) {
+    if (running_) return false;
+    auto pub = std::make_unique<MulticastPublisher>(group, port, iface, ttl);
+    if (!pub->open()) return false;
+    mcast_ = std::move(pub);
+    return true;
+}
+
+bool NetworkServer::open_unix_listener() {
+#if QPLAT_WINDOWS
+    return false;
+#else
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (unix_path_.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[net] unix socket path too long: " << unix_path_ << "\n";
+        return false;
+    }
+    std::memcpy(addr.sun_path, unix_path_.c_str(), unix_path_.size());
+
+    unix_fd_ = socket(AF_UNIX, unix_seqpacket_ ? SOCK_SEQPACKET : SOCK_STREAM, 0);
+    if (unix_fd_ == INVALID_SOCKET) {
+        std::cerr << "[net] unix socket() failed errno=" << SOCKET_ERRNO() << "\n";
+        return false;
+    }
+
+    // remove a stale socket file left by a previous run
+    ::unlink(unix_path_.c_str());
+
+    if (bind(unix_fd_, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(unix_fd_, SOMAXCONN) != 0) {
+        std::cerr << "[net] unix bind/listen failed errno=" << SOCKET_ERRNO() << "\n";
+        CLOSESOCKET(unix_fd_);
+        unix_fd_ = INVALID_SOCKET;
+        return false;
+    }
+    set_nonblocking(unix_fd_);
+    std::cout << "[net] listening on unix:" << unix_path_
+              << (unix_seqpacket_ ? " (seqpacket)" : " (stream)") << "\n";
+    return true;
+#endif
+}
+
 bool NetworkServer::start() {
     if (running_) return true;
 
@@ -125,6 +187,11 @@ bool NetworkServer::start() {
         // continue anyway
     }
 
+    // local transport is optional: TCP keeps serving if it cannot be opened
+    if (!unix_path_.empty() && !open_unix_listener()) {
+        std::cerr << "[net] continuing without unix listener\n";
+    }
+
     running_ = true;
     worker_thread_ = std::thread(&NetworkServer::run_loop, this);
     std::cout << "[net] listening on 0.0.0.0:" << port_ << "\n";
@@ -146,6 +213,13 @@ void NetworkServer::stop() {
         CLOSESOCKET(listen_fd_);
         listen_fd_ = INVALID_SOCKET;
     }
+    if (unix_fd_ != INVALID_SOCKET) {
+        CLOSESOCKET(unix_fd_);
+        unix_fd_ = INVALID_SOCKET;
+#if !QPLAT_WINDOWS
+        ::unlink(unix_path_.c_str());
+#endif
+    }
 
 #if QPLAT_WINDOWS
     WSACleanup();
@@ -165,6 +239,10 @@ void NetworkServer::run_loop() {
         // always monitor listen socket for new connections
         FD_SET((unsigned)listen_fd_, &readset);
         sock_t maxfd = listen_fd_;
+        if (unix_fd_ != INVALID_SOCKET) {
+            FD_SET((unsigned)unix_fd_, &readset);
+            if (unix_fd_ > maxfd) maxfd = unix_fd_;
+        }
 
         // set client fds
         for (auto &kv : clients_) {
@@ -194,27 +272,10 @@ void NetworkServer::run_loop() {
 
         // 1) Accept new clients (handle possibly multiple accepts)
         if (FD_ISSET((unsigned)listen_fd_, &readset)) {
-            // accept in loop until EWOULDBLOCK
-            while (true) {
-                sockaddr_in cli_addr;
-                socklen_t cli_len = sizeof(cli_addr);
-                sock_t client_fd = accept(listen_fd_, (sockaddr*)&cli_addr, &cli_len);
-                if (client_fd == INVALID_SOCKET) break;
-
-                // set non-blocking
-                set_nonblocking(client_fd);
-
-                ClientState cs;
-                cs.fd = client_fd;
-                cs.recv_buffer.reserve(4096);
-                cs.send_offset = 0;
-                char ipbuf[64] = {0};
-                inet_ntop(AF_INET, &cli_addr.sin_addr, ipbuf, sizeof(ipbuf));
-                cs.peer = std::string(ipbuf) + ":" + std::to_string(ntohs(cli_addr.sin_port));
-
-                clients_.emplace((int)client_fd, std::move(cs));
-                std::cout << "[net] client connected: " << ipbuf << ":" << ntohs(cli_addr.sin_port) << "\n";
-            }
+            accept_clients(listen_fd_, false);
+        }
+        if (unix_fd_ != INVALID_SOCKET && FD_ISSET((unsigned)unix_fd_, &readset)) {
+            accept_clients(unix_fd_, true);
         }
 
         // buffer clients to remove (avoid erasing while iterating)
@@ -228,8 +289,33 @@ void NetworkServer::run_loop() {
             // read available data into temporary buffer
             uint8_t tmp[4096];
             while (true) {
-                int got = recv(cs.fd, (char*)tmp, sizeof(tmp), 0);
-                if (got > 0) {
+                int got;
+                bool truncated = false;
+#if QPLAT_WINDOWS
+                got = recv(cs.fd, (char*)tmp, sizeof(tmp), 0);
+#else
+                if (cs.message_mode) {
+                    // recvmsg reports packets longer than tmp instead of cutting them short
+                    iovec iov{tmp, sizeof(tmp)};
+                    msghdr mh{};
+                    mh.msg_iov = &iov;
+                    mh.msg_iovlen = 1;
+                    got = (int)recvmsg(cs.fd, &mh, 0);
+                    truncated = got > 0 && (mh.msg_flags & MSG_TRUNC);
+                } else {
+                    got = recv(cs.fd, (char*)tmp, sizeof(tmp), 0);
+                }
+#endif
+                if (truncated) {
+                    std::cerr << "[net] client " << cs.peer << " sent oversized packet (> "
+                              << sizeof(tmp) << " bytes)\n";
+                    to_remove.push_back(kv.first);
+                    break;
+                } else if (got > 0 && cs.message_mode) {
+                    // seqpacket: message boundaries are preserved, no deframing needed
+                    std::vector<uint8_t> payload(tmp, tmp + got);
+                    handle_client_payload(cs, payload);
+                } else if (got > 0) {
                     cs.recv_buffer.insert(cs.recv_buffer.end(), tmp, tmp + got);
 
                     // process as many complete frames as possible
@@ -279,8 +365,10 @@ void NetworkServer::run_loop() {
                 const char* data = (const char*)front.data();
                 size_t total = front.size();
                 size_t offset = cs.send_offset;
+                // seqpacket sends are atomic and unframed: skip the 4-byte length prefix
+                if (cs.message_mode && offset == 0) offset = cs.send_offset = 4;
 
-                ssize_t sent = send(cs.fd, data + offset, static_cast<int>(total - offset), 0);
+                ssize_t sent = send(cs.fd, data + offset, static_cast<int>(total - offset), SEND_FLAGS);
                 if (sent > 0) {
                     cs.send_offset += (size_t)sent;
                     if (cs.send_offset >= total) {
@@ -298,6 +386,14 @@ void NetworkServer::run_loop() {
                     if (err == WSAEWOULDBLOCK || err == WSAEINTR) break;
 #else
                     if (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR) break;
+                    if (errno == EMSGSIZE && cs.message_mode) {
+                        // larger than the socket send buffer: drop this message, keep the client
+                        std::cerr << "[net] dropped " << (total - 4) << "-byte message for " << cs.peer
+                                  << " (exceeds seqpacket limit)\n";
+                        cs.send_queue.pop_front();
+                        cs.send_offset = 0;
+                        continue;
+                    }
 #endif
                     // fatal send error
                     to_remove.push_back(kv.first);
@@ -310,13 +406,28 @@ void NetworkServer::run_loop() {
         {
             ServerMessage sm;
             while (engine_->get_next_server_message(sm)) {
-                std::vector<uint8_t> framed = pack_server_message(sm);
-                // push to every client send_queue
+                encode_server_message(sm, encode_buf_);
+                const uint32_t bit = 1u << sm.type;
+                if (sm.target_client != 0) {
+                    // addressed to one connection (e.g. its depth snapshot); not on the feed
+                    for (auto &kv : clients_) {
+                        ClientState &cs = kv.second;
+                        if (cs.id != sm.target_client) continue;
+                        if (cs.sub_mask & bit) cs.send_queue.push_back(encode_buf_);
+                        break;
+                    }
+                    continue;
+                }
+                if (mcast_ && MulticastPublisher::is_feed_message(sm.type)) {
+                    mcast_->publish(sm, encode_buf_);
+                }
+                // push to every subscribed client send_queue
                 for (auto &kv : clients_) {
                     ClientState &cs = kv.second;
-                    cs.send_queue.push_back(framed);
+                    if (cs.sub_mask & bit) cs.send_queue.push_back(encode_buf_);
                 }
             }
+            if (mcast_) mcast_->flush();
         }
 
         // 5) Remove and close clients outside iteration
@@ -333,6 +444,7 @@ void NetworkServer::run_loop() {
                 }
             }
             to_remove.clear();
+            update_l3_subscription();
         }
     } // while running
 
@@ -346,6 +458,60 @@ void NetworkServer::run_loop() {
         CLOSESOCKET(listen_fd_);
         listen_fd_ = INVALID_SOCKET;
     }
+    if (unix_fd_ != INVALID_SOCKET) {
+        CLOSESOCKET(unix_fd_);
+        unix_fd_ = INVALID_SOCKET;
+#if !QPLAT_WINDOWS
+        ::unlink(unix_path_.c_str());
+#endif
+    }
+}
+
+// Accept until EWOULDBLOCK; unix clients are tagged so the I/O paths can
+// skip framing for seqpacket sockets.
+void NetworkServer::accept_clients(qsocket_t lfd, bool is_unix) {
+    while (true) {
+        sockaddr_storage cli_addr;
+        socklen_t cli_len = sizeof(cli_addr);
+        sock_t client_fd = accept(lfd, (sockaddr*)&cli_addr, &cli_len);
+        if (client_fd == INVALID_SOCKET) break;
+
+        // set non-blocking
+        set_nonblocking(client_fd);
+#ifdef SO_NOSIGPIPE
+        // no MSG_NOSIGNAL (macOS): suppress SIGPIPE per socket instead
+        int one = 1;
+        setsockopt(client_fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+        ClientState cs;
+        cs.fd = client_fd;
+        cs.id = next_client_id_++;
+        cs.recv_buffer.reserve(4096);
+        cs.send_offset = 0;
+        if (is_unix) {
+            cs.message_mode = unix_seqpacket_;
+            cs.peer = "unix:" + unix_path_ + "#" + std::to_string((int)client_fd);
+        } else {
+            const sockaddr_in* sin = (const sockaddr_in*)&cli_addr;
+            char ipbuf[64] = {0};
+            inet_ntop(AF_INET, &sin->sin_addr, ipbuf, sizeof(ipbuf));
+            cs.peer = std::string(ipbuf) + ":" + std::to_string(ntohs(sin->sin_port));
+        }
+
+        std::cout << "[net] client connected: " << cs.peer << "\n";
+        // new consumer needs the full book before incremental DEPTH_UPDATEs make sense
+        engine_->request_depth_snapshot(cs.id);
+        clients_.emplace((int)client_fd, std::move(cs));
+    }
+}
+
+void NetworkServer::update_l3_subscription() {
+    bool any = false;
+    for (const auto& kv : clients_) {
+        if (kv.second.sub_mask & (1u << L3_EVENT)) { any = true; break; }
+    }
+    engine_->enable_l3_feed(any);
 }
 
 // Called when a complete framed payload arrives from a client
@@ -356,7 +522,7 @@ void NetworkServer::handle_client_payload(ClientState &cs, const std::vector<uin
     // The payload layout must match your existing Node / client encoder.
     // We only support the same ClientMessage types you defined in messages.hpp: NEW_ORDER, CANCEL.
     if (type == static_cast<uint8_t>(NEW_ORDER)) {
-        // expect: 1 byte type + 8 user_id + 1 side + 8 price(double) + 8 qty
+        // expect: 1 byte type + 8 user_id + 1 side + 8 price(double) + 8 qty [+ 4 instrument_id]
         if (payload.size() < 1 + 8 + 1 + 8 + 8) {
             std::cerr << "[net] bad NEW_ORDER frame size from " << cs.peer << "\n";
             return;
@@ -375,8 +541,16 @@ void NetworkServer::handle_client_payload(ClientState &cs, const std::vector<uin
         // **Note**: system endianness may require byteswap for IEEE-754; we assume the encoding on client matches host.
         uint64_t qty = 0;
         for (int i = 0; i < 8; ++i) qty = (qty << 8) | payload[off + i];
+        off += 8;
+        // optional trailing instrument id; older clients omit it
+        uint32_t instrument_id = DEFAULT_INSTRUMENT_ID;
+        if (payload.size() >= off + 4) {
+            instrument_id = 0;
+            for (int i = 0; i < 4; ++i) instrument_id = (instrument_id << 8) | payload[off + i];
+        }
         // build MsgNewOrder and push to engine
         MsgNewOrder m{};
+        m.instrument_id = instrument_id;
         m.user_id = user_id;
         m.side = side;
         m.price = price;
@@ -392,81 +566,85 @@ void NetworkServer::handle_client_payload(ClientState &cs, const std::vector<uin
         MsgCancel c{};
         c.order_id = order_id;
         engine_->submit_cancel(c);
+    } else if (type == static_cast<uint8_t>(SUBSCRIBE)) {
+        // expect: 1 byte type + 4 mask
+        if (payload.size() < 1 + 4) {
+            std::cerr << "[net] bad SUBSCRIBE frame size from " << cs.peer << "\n";
+            return;
+        }
+        uint32_t mask = 0;
+        for (int i = 0; i < 4; ++i) mask = (mask << 8) | payload[1 + i];
+        const uint32_t l3_bit = 1u << L3_EVENT;
+        const bool l3_added = (mask & l3_bit) && !(cs.sub_mask & l3_bit);
+        cs.sub_mask = mask;
+        update_l3_subscription();
+        // new L3 subscriber needs the resting orders before incremental events
+        if (l3_added) engine_->request_l3_snapshot();
+    } else if (type == static_cast<uint8_t>(AMEND)) {
+        // expect: 1 byte type + 8 order_id + 8 new quantity
+        if (payload.size() < 1 + 8 + 8) {
+            std::cerr << "[net] bad AMEND frame size from " << cs.peer << "\n";
+            return;
+        }
+        MsgAmend a{};
+        for (int i = 0; i < 8; ++i) a.order_id = (a.order_id << 8) | payload[1 + i];
+        for (int i = 0; i < 8; ++i) a.quantity = (a.quantity << 8) | payload[9 + i];
+        engine_->submit_amend(a);
+    } else if (type == static_cast<uint8_t>(RETRANSMIT_REQUEST)) {
+        // expect: 1 byte type + 8 from_seq + 8 to_seq; reply goes to this client only
+        if (payload.size() < 1 + 8 + 8) {
+            std::cerr << "[net] bad RETRANSMIT_REQUEST frame size from " << cs.peer << "\n";
+            return;
+        }
+        if (!mcast_) return;
+        uint64_t from_seq = 0, to_seq = 0;
+        for (int i = 0; i < 8; ++i) from_seq = (from_seq << 8) | payload[1 + i];
+        for (int i = 0; i < 8; ++i) to_seq = (to_seq << 8) | payload[9 + i];
+        std::vector<std::vector<uint8_t>> frames;
+        mcast_->recover(from_seq, to_seq, frames);
+        for (auto& f : frames) cs.send_queue.push_back(std::move(f));
+    } else if (type == static_cast<uint8_t>(PNL_HISTORY_REQUEST)) {
+        // expect: 1 byte type + 4 user_id + 4 instrument_id + 1 tier + 8 since_ms; reply to this client only
+        if (payload.size() < 1 + 4 + 4 + 1 + 8) {
+            std::cerr << "[net] bad PNL_HISTORY_REQUEST frame size from " << cs.peer << "\n";
+            return;
+        }
+        uint32_t user_id = 0, instrument_id = 0;
+        uint64_t since_ms = 0;
+        for (int i = 0; i < 4; ++i) user_id = (user_id << 8) | payload[1 + i];
+        for (int i = 0; i < 4; ++i) instrument_id = (instrument_id << 8) | payload[5 + i];
+        uint8_t tier = payload[9];
+        for (int i = 0; i < 8; ++i) since_ms = (since_ms << 8) | payload[10 + i];
+        std::vector<PnLSample> samples;
+        uint32_t bucket_ms = 0;
+        if (!engine_->query_pnl_history(user_id, instrument_id, tier, since_ms, samples, bucket_ms)) {
+            std::cerr << "[net] PNL_HISTORY_REQUEST for unknown tier " << (int)tier << " from " << cs.peer << "\n";
+            return;
+        }
+        std::vector<std::vector<uint8_t>> frames;
+        encode_pnl_history(user_id, instrument_id, tier, bucket_ms, samples, frames);
+        for (auto& f : frames) cs.send_queue.push_back(std::move(f));
+    } else if (type == static_cast<uint8_t>(LOTS_REQUEST)) {
+        // expect: 1 byte type + 4 user_id + 4 instrument_id; reply to this client only
+        if (payload.size() < 1 + 4 + 4) {
+            std::cerr << "[net] bad LOTS_REQUEST frame size from " << cs.peer << "\n";
+            return;
+        }
+        uint32_t user_id = 0, instrument_id = 0;
+        for (int i = 0; i < 4; ++i) user_id = (user_id << 8) | payload[1 + i];
+        for (int i = 0; i < 4; ++i) instrument_id = (instrument_id << 8) | payload[5 + i];
+        std::vector<LotInfo> open, closed;
+        if (!engine_->query_lots(user_id, instrument_id, open, closed)) {
+            std::cerr << "[net] LOTS_REQUEST from " << cs.peer << " needs QUANT_COST_BASIS=fifo\n";
+            return;
+        }
+        std::vector<std::vector<uint8_t>> frames;
+        encode_lots(user_id, instrument_id, open, closed, frames);
+        for (auto& f : frames) cs.send_queue.push_back(std::move(f));
     } else {
         // unknown client message; ignore or log
         std::cerr << "[net] unknown client message type=" << (int)type << " from " << cs.peer << "\n";
     }
 }
 
-// pack_server_message must return a framed message: 4-byte BE length + payload
-std::vector<uint8_t> NetworkServer::pack_server_message(const ServerMessage& m) {
-    std::vector<uint8_t> payload;
-    payload.push_back(static_cast<uint8_t>(m.type));
-    if (m.type == TRADE) {
-        auto append_u64 = [&](uint64_t v) {
-            for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        auto append_double = [&](double x) {
-            uint64_t v;
-            std::memcpy(&v, &x, sizeof(v));
-            for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        append_u64(m.trade.trade_id);
-        append_u64(m.trade.buy_order_id);
-        append_u64(m.trade.buy_user_id);
-        append_u64(m.trade.sell_order_id);
-        append_u64(m.trade.sell_user_id);
-        append_double(m.trade.price);
-        append_u64(m.trade.quantity);
-
-    }else if (m.type == ACK) {
-        payload.push_back(m.ack.status);
-        payload.push_back(m.ack.type);
-        uint64_t v = m.ack.order_id;
-        for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-    } else if (m.type == TOB) {
-        auto append_double = [&](double x) {
-            uint64_t v;
-            std::memcpy(&v, &x, sizeof(v));
-            for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        auto append_u64 = [&](uint64_t v) {
-            for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        append_double(m.tob.bid_price);
-        append_u64(m.tob.bid_quantity);
-        append_double(m.tob.ask_price);
-        append_u64(m.tob.ask_quantity);
-    } else if (m.type == L2_UPDATE) {
-        payload.push_back(m.l2.side);
-        uint64_t v;
-        std::memcpy(&v, &m.l2.price, sizeof(v));
-        for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        uint64_t q = m.l2.quantity;
-        for (int i = 7; i >= 0; --i) payload.push_back((q >> (i*8)) & 0xFF);
-    } else if (m.type == PNL_UPDATE) {
-        auto append_double = [&](double x) {
-            uint64_t v;
-            std::memcpy(&v, &x, sizeof(v));
-            for (int i = 7; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        auto append_u32 = [&](uint32_t v){
-            for (int i = 3; i >= 0; --i) payload.push_back((v >> (i*8)) & 0xFF);
-        };
-        append_u32(m.pnl.user_id);
-        append_double(m.pnl.realized);
-        append_double(m.pnl.unrealized);
-        append_double(m.pnl.position);
-        append_double(m.pnl.avg_price);
-        append_double(m.pnl.equity);
-    }
-    // frame it
-    std::vector<uint8_t> framed;
-    uint32_t len = static_cast<uint32_t>(payload.size());
-    framed.reserve(4 + payload.size());
-    write_u32_be(framed, len);
-    framed.insert(framed.end(), payload.begin(), payload.end());
-    return framed;
-}
-
 } // namespace quant
@@ -3,10 +3,11 @@
 
 namespace quant {
 
-// Reserve large pool capacity to avoid dynamic allocations in matching hot path.
-OrderBook::OrderBook(const std::string& symbol)
+// Reserve pool capacity up front to avoid dynamic allocations in matching hot path.
+// The engine runs one book per instrument, so the default is sized per book.
+OrderBook::OrderBook(const std::string& symbol, uint32_t pool_capacity)
     : symbol_(symbol),
-      pool_(1'000'000'000) // capacity
+      pool_(pool_capacity)
 {}
 
 // ID generators
@@ -19,6 +20,19 @@ bool OrderBook::level_empty(const PriceLevel& level) const {
     return level.head == UINT32_MAX;
 }
 
+void OrderBook::record_event(L3EventType type, uint64_t order_id, uint8_t side,
+                             double price, uint64_t qty) {
+    if (!events_) return;
+    L3Event ev;
+    ev.seq      = next_event_seq_++;
+    ev.order_id = order_id;
+    ev.price    = price;
+    ev.quantity = qty;
+    ev.type     = type;
+    ev.side     = side;
+    events_->push_back(ev);
+}
+
 // Append node at tail; maintain FIFO within price level.
 void OrderBook::append_to_level(PriceLevel& level, uint32_t idx) {
     PoolOrder& po = pool_[idx];
@@ -53,6 +67,9 @@ uint64_t OrderBook::submit_limit_order(const Order& order,
     out_trades.clear();
     // Fast-path: ignore zero-quantity orders.
     if (order.quantity == 0) return 0;
+    // No room for a residual: reject before matching so the order has no effect. Matching
+    // only frees slots, so a book that is not full can always rest the remainder.
+    if (pool_.full()) return 0;
 
     Order incoming = order;
     if (incoming.order_id == 0)
@@ -84,6 +101,9 @@ bool OrderBook::cancel_order(uint64_t order_id) {
     OrderRef ref = it->second;
     order_index_.erase(it);
 
+    record_event(L3EventType::Cancel, order_id, ref.side == Side::Buy ? 0 : 1,
+                 ref.price, pool_[ref.idx].quantity);
+
     if (ref.side == Side::Buy) {
         auto lvl_it = bids_.find(ref.price);
         if (lvl_it == bids_.end()) return false;
@@ -103,6 +123,46 @@ bool OrderBook::cancel_order(uint64_t order_id) {
     return true;
 }
 
+// Amend in place: shrinking keeps FIFO position, growing re-queues at the tail.
+bool OrderBook::amend_order(uint64_t order_id, uint64_t new_quantity) {
+    if (new_quantity == 0) return cancel_order(order_id);
+
+    auto it = order_index_.find(order_id);
+    if (it == order_index_.end()) return false;
+    const OrderRef& ref = it->second;
+    PoolOrder& po = pool_[ref.idx];
+
+    if (new_quantity > po.quantity) {
+        if (ref.side == Side::Buy) {
+            PriceLevel& level = bids_[ref.price];
+            unlink_from_level(level, ref.idx);
+            append_to_level(level, ref.idx);
+        } else {
+            PriceLevel& level = asks_[ref.price];
+            unlink_from_level(level, ref.idx);
+            append_to_level(level, ref.idx);
+        }
+        po.timestamp = allocate_timestamp();
+    }
+    po.quantity = new_quantity;
+
+    record_event(L3EventType::Amend, order_id, po.side, ref.price, new_quantity);
+    return true;
+}
+
+void OrderBook::snapshot_orders(std::vector<L3Event>& out) {
+    std::vector<L3Event>* saved = events_;
+    events_ = &out;
+    record_event(L3EventType::Reset, 0, 0, 0.0, 0);
+    auto emit_level = [&](uint8_t side, double price, const PriceLevel& level) {
+        for (uint32_t idx = level.head; idx != UINT32_MAX; idx = pool_[idx].next)
+            record_event(L3EventType::Add, pool_[idx].order_id, side, price, pool_[idx].quantity);
+    };
+    for (const auto& kv : bids_) emit_level(0, kv.first, kv.second);
+    for (const auto& kv : asks_) emit_level(1, kv.first, kv.second);
+    events_ = saved;
+}
+
 // ---------------- Top of Book ----------------
 
 // Aggregate best bid/ask price levels into a compact TOB snapshot.
@@ -199,6 +259,7 @@ void OrderBook::add_to_book(const Order& o) {
     }
 
     order_index_[o.order_id] = OrderRef{o.side, o.price, idx};
+    record_event(L3EventType::Add, o.order_id, po.side, o.price, o.quantity);
 }
 
 // ---------------- Matching engine ----------------
@@ -230,6 +291,7 @@ void OrderBook::match_buy(Order& incoming, std::vector<Trade>& out_trades) {
             tr.sell_user_id   = resting.user_id;
 
             out_trades.push_back(tr);
+            record_event(L3EventType::Execute, resting.order_id, 1, ask_price, qty);
 
 
             incoming.quantity -= qty;
@@ -276,6 +338,7 @@ void OrderBook::match_sell(Order& incoming, std::vector<Trade>& out_trades) {
             tr.sell_user_id   = incoming.user_id;
 
             out_trades.push_back(tr);
+            record_event(L3EventType::Execute, resting.order_id, 0, bid_price, qty);
 
 
             incoming.quantity -= qty;
@@ -1,32 +1,68 @@
 #include "quant/pnl.hpp"
+#include <algorithm>
 #include <cmath>
 
 namespace quant {
 
-PnLEngine::PnLEngine(uint64_t user_id)
-    : user_id_(user_id),
-      position_(0.0),
-      avg_price_(0.0),
-      realized_pnl_(0.0),
-      unrealized_pnl_(0.0),
-      last_mid_(0.0) {}
+PnLEngine::PnLEngine(CostBasis basis, uint32_t lot_capacity, uint32_t closed_lot_capacity)
+    : basis_(basis),
+      lots_(basis == CostBasis::FIFO ? lot_capacity : 1),
+      closed_(basis == CostBasis::FIFO ? std::max<uint32_t>(1, closed_lot_capacity) : 0)
+{}
 
-void PnLEngine::on_trade(bool user_is_buy, double price, uint64_t qty) {
-    std::lock_guard<std::mutex> g(mtx_);
-    double signed_qty = user_is_buy ? double(qty) : -double(qty);
+uint32_t PnLEngine::position_index(uint64_t user_id, uint32_t instrument_id) {
+    auto [it, inserted] = index_.try_emplace(Key{user_id, instrument_id},
+                                             static_cast<uint32_t>(positions_.size()));
+    if (inserted) {
+        Position p;
+        p.user_id = user_id;
+        p.instrument_id = instrument_id;
+        positions_.push_back(p);
+    }
+    return it->second;
+}
+
+void PnLEngine::remark(Position& p, double mark) {
+    double unrealized = 0.0;
+    if (mark > 0.0 && p.position != 0.0) {
+        if (p.position > 0.0) unrealized = (mark - p.avg_price) * std::abs(p.position);
+        else unrealized = (p.avg_price - mark) * std::abs(p.position);
+    }
+    users_[p.user_id].unrealized += unrealized - p.unrealized;
+    p.unrealized = unrealized;
+}
+
+void PnLEngine::update_holder(uint32_t idx, InstrumentMarks& im) {
+    Position& p = positions_[idx];
+    const bool open = p.position != 0.0;
+    if (open && p.holder_slot == UINT32_MAX) {
+        p.holder_slot = static_cast<uint32_t>(im.holders.size());
+        im.holders.push_back(idx);
+    } else if (!open && p.holder_slot != UINT32_MAX) {
+        // swap-remove, fixing up the moved holder's slot
+        uint32_t moved = im.holders.back();
+        im.holders[p.holder_slot] = moved;
+        positions_[moved].holder_slot = p.holder_slot;
+        im.holders.pop_back();
+        p.holder_slot = UINT32_MAX;
+    }
+}
+
+void PnLEngine::apply_average_cost(Position& pos, double signed_qty, double price) {
+    double& position_  = pos.position;
+    double& avg_price_ = pos.avg_price;
 
     // If closing (opposite sign), compute realized PnL on closed portion
     if (position_ != 0.0 && (position_ * signed_qty) < 0.0) {
         // qty that actually closes existing position
         double close_qty = std::min(std::abs(position_), std::abs(signed_qty));
         // realized = (sell_price - buy_price) * closed_qty
-        // determine whether the closing trade is selling existing long or buying to cover short
         if (position_ > 0.0) {
             // we had a long; closing by selling at 'price'
-            realized_pnl_ += (price - avg_price_) * close_qty;
+            pos.realized += (price - avg_price_) * close_qty;
         } else {
             // we had a short; closing by buying at 'price'
-            realized_pnl_ += (avg_price_ - price) * close_qty;
+            pos.realized += (avg_price_ - price) * close_qty;
         }
         // adjust remaining signed_qty after closing
         signed_qty = (std::abs(signed_qty) > close_qty)
@@ -45,50 +81,219 @@ void PnLEngine::on_trade(bool user_is_buy, double price, uint64_t qty) {
 
     // If there is remaining signed_qty with same sign as position (or new position), update avg price
     if (signed_qty != 0.0) {
-        // If we had zero position, simply set avg_price
         if (position_ == 0.0) {
             avg_price_ = price;
             position_ = signed_qty;
-        } else if ((position_ > 0.0 && signed_qty > 0.0) || (position_ < 0.0 && signed_qty < 0.0)) {
+        } else {
             double new_pos = position_ + signed_qty;
             // compute new VWAP
             avg_price_ = (avg_price_ * std::abs(position_) + price * std::abs(signed_qty)) / (std::abs(new_pos));
             position_ = new_pos;
-        } else {
-            // signed_qty opposite sign but fully absorbed by previous closing branch; unlikely to reach here
-            position_ += signed_qty;
-            if (position_ == 0.0) avg_price_ = 0.0;
+        }
+    }
+}
+
+void PnLEngine::apply_fifo(Position& pos, double signed_qty, double price) {
+    // Close the oldest lots first while the fill opposes the position.
+    while (signed_qty != 0.0 && pos.position * signed_qty < 0.0) {
+        PoolLot& lot = lots_[pos.lot_head];
+        double close_qty = std::min(lot.quantity, std::abs(signed_qty));
+        double pnl = (pos.position > 0.0) ? (price - lot.price) * close_qty
+                                          : (lot.price - price) * close_qty;
+        pos.realized  += pnl;
+        lot.realized  += pnl;
+        lot.quantity  -= close_qty;
+        pos.open_cost -= close_qty * lot.price;
+        pos.position  += (pos.position > 0.0) ? -close_qty : close_qty;
+        signed_qty    += (signed_qty > 0.0) ? -close_qty : close_qty;
+
+        if (lot.quantity <= 0.0) {
+            // keep the closed lot's record before its node is reused
+            closed_[closed_head_] = ClosedLot{pos.user_id, pos.instrument_id,
+                                              LotInfo{lot.opened, lot.price, lot.realized,
+                                                      lot.trade_seq, fill_seq_}};
+            closed_head_ = (closed_head_ + 1) % closed_.size();
+            closed_count_ = std::min(closed_count_ + 1, closed_.size());
+
+            uint32_t next = lot.next;
+            lots_.release(pos.lot_head);
+            pos.lot_head = next;
+            if (next == UINT32_MAX) pos.lot_tail = UINT32_MAX;
         }
     }
 
-    // update unrealized with last_mid_
-    if (last_mid_ > 0.0) {
-        if (position_ > 0.0) unrealized_pnl_ = (last_mid_ - avg_price_) * std::abs(position_);
-        else unrealized_pnl_ = (avg_price_ - last_mid_) * std::abs(position_);
+    // Any remainder opens a new lot at the back of the queue.
+    if (signed_qty != 0.0) {
+        uint32_t idx = lots_.allocate();
+        PoolLot& lot = lots_[idx];
+        lot.quantity  = std::abs(signed_qty);
+        lot.opened    = lot.quantity;
+        lot.price     = price;
+        lot.realized  = 0.0;
+        lot.trade_seq = fill_seq_;
+        if (pos.lot_tail == UINT32_MAX) pos.lot_head = idx;
+        else lots_[pos.lot_tail].next = idx;
+        pos.lot_tail = idx;
+        pos.position  += signed_qty;
+        pos.open_cost += lot.quantity * price;
     }
-}
 
-void PnLEngine::on_midprice(double mid) {
-    std::lock_guard<std::mutex> g(mtx_);
-    last_mid_ = mid;
-    if (position_ == 0.0) {
-        unrealized_pnl_ = 0.0;
-    } else if (position_ > 0.0) {
-        unrealized_pnl_ = (last_mid_ - avg_price_) * std::abs(position_);
+    if (pos.position == 0.0) {
+        pos.open_cost = 0.0;
+        pos.avg_price = 0.0;
     } else {
-        unrealized_pnl_ = (avg_price_ - last_mid_) * std::abs(position_);
+        pos.avg_price = pos.open_cost / std::abs(pos.position);
     }
 }
 
-quant::PnLUpdate PnLEngine::get() const {
+void PnLEngine::on_trade(uint64_t user_id, uint32_t instrument_id, bool user_is_buy,
+                         double price, uint64_t qty) {
     std::lock_guard<std::mutex> g(mtx_);
+    uint32_t idx = position_index(user_id, instrument_id);
+    Position& pos = positions_[idx];
+    const double realized_before = pos.realized;
+
+    double signed_qty = user_is_buy ? double(qty) : -double(qty);
+    ++fill_seq_;
+    if (basis_ == CostBasis::FIFO) apply_fifo(pos, signed_qty, price);
+    else apply_average_cost(pos, signed_qty, price);
+
+    users_[user_id].realized += pos.realized - realized_before;
+
+    InstrumentMarks& im = instruments_[instrument_id];
+    update_holder(idx, im);
+    remark(pos, im.mark);
+}
+
+void PnLEngine::on_mark(uint32_t instrument_id, double mid, std::vector<uint64_t>* touched_users) {
+    std::lock_guard<std::mutex> g(mtx_);
+    InstrumentMarks& im = instruments_[instrument_id];
+    if (mid == im.mark) return;
+    im.mark = mid;
+    for (uint32_t idx : im.holders) {
+        Position& p = positions_[idx];
+        remark(p, mid);
+        if (touched_users) touched_users->push_back(p.user_id);
+    }
+}
+
+quant::PnLUpdate PnLEngine::snapshot(const Position& p) const {
     quant::PnLUpdate out;
-    out.realized   = realized_pnl_;
-    out.unrealized = unrealized_pnl_;
-    out.position   = position_;
-    out.avg_price  = avg_price_;
-    out.equity     = realized_pnl_ + unrealized_pnl_;
+    out.user_id       = static_cast<uint32_t>(p.user_id);
+    out.instrument_id = p.instrument_id;
+    out.realized      = p.realized;
+    out.unrealized    = p.unrealized;
+    out.position      = p.position;
+    out.avg_price     = p.avg_price;
+    out.equity        = p.realized + p.unrealized;
     return out;
 }
 
+quant::PnLUpdate PnLEngine::get(uint64_t user_id, uint32_t instrument_id) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = index_.find(Key{user_id, instrument_id});
+    if (it == index_.end()) {
+        quant::PnLUpdate out{};
+        out.user_id = static_cast<uint32_t>(user_id);
+        out.instrument_id = instrument_id;
+        return out;
+    }
+    return snapshot(positions_[it->second]);
+}
+
+quant::PnLUpdate PnLEngine::get_total(uint64_t user_id) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    quant::PnLUpdate out{};
+    out.user_id = static_cast<uint32_t>(user_id);
+    out.instrument_id = ALL_INSTRUMENTS;
+    auto it = users_.find(user_id);
+    if (it != users_.end()) {
+        out.realized   = it->second.realized;
+        out.unrealized = it->second.unrealized;
+        out.equity     = it->second.realized + it->second.unrealized;
+    }
+    return out;
+}
+
+double PnLEngine::mark(uint32_t instrument_id) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = instruments_.find(instrument_id);
+    return it == instruments_.end() ? 0.0 : it->second.mark;
+}
+
+void PnLEngine::open_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& out) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = index_.find(Key{user_id, instrument_id});
+    if (it == index_.end()) return;
+    for (uint32_t l = positions_[it->second].lot_head; l != UINT32_MAX; l = lots_[l].next) {
+        const PoolLot& lot = lots_[l];
+        out.push_back(LotInfo{lot.quantity, lot.price, lot.realized, lot.trade_seq});
+    }
+}
+
+void PnLEngine::closed_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& out) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    const std::size_t n = closed_.size();
+    for (std::size_t k = 0; k < closed_count_; ++k) {
+        const ClosedLot& c = closed_[(closed_head_ + n - closed_count_ + k) % n];
+        if (c.user_id == user_id && c.instrument_id == instrument_id) out.push_back(c.lot);
+    }
+}
+
+// ---------------- PnLPublisher ----------------
+
+PnLPublisher::PnLPublisher(double max_rate_hz, double epsilon) {
+    configure(max_rate_hz, epsilon);
+}
+
+void PnLPublisher::configure(double max_rate_hz, double epsilon) {
+    min_interval_ns_ = max_rate_hz > 0.0 ? static_cast<uint64_t>(1e9 / max_rate_hz) : 0;
+    epsilon_ = epsilon;
+}
+
+void PnLPublisher::mark_dirty(uint64_t user_id, uint32_t instrument_id) {
+    UserState& u = users_[user_id];
+    if (std::find(u.dirty.begin(), u.dirty.end(), instrument_id) == u.dirty.end())
+        u.dirty.push_back(instrument_id);
+    if (!u.pending) {
+        u.pending = true;
+        pending_users_.push_back(user_id);
+    }
+}
+
+bool PnLPublisher::changed(const quant::PnLUpdate& a, const quant::PnLUpdate& b) const {
+    return std::abs(a.realized   - b.realized)   > epsilon_ ||
+           std::abs(a.unrealized - b.unrealized) > epsilon_ ||
+           std::abs(a.position   - b.position)   > epsilon_ ||
+           std::abs(a.avg_price  - b.avg_price)  > epsilon_ ||
+           std::abs(a.equity     - b.equity)     > epsilon_;
+}
+
+void PnLPublisher::collect(const PnLEngine& pnl, uint64_t now_ns,
+                           std::vector<quant::PnLUpdate>& out) {
+    std::size_t keep = 0;
+    for (std::size_t i = 0; i < pending_users_.size(); ++i) {
+        const uint64_t user_id = pending_users_[i];
+        UserState& u = users_[user_id];
+        if (u.last_publish_ns != 0 && now_ns - u.last_publish_ns < min_interval_ns_) {
+            pending_users_[keep++] = user_id;
+            continue;
+        }
+        bool sent_any = false;
+        for (uint32_t instrument_id : u.dirty) {
+            quant::PnLUpdate snap = pnl.get(user_id, instrument_id);
+            auto it = u.sent.find(instrument_id);
+            if (it != u.sent.end() && !changed(snap, it->second)) continue;
+            u.sent[instrument_id] = snap;
+            out.push_back(snap);
+            sent_any = true;
+        }
+        u.dirty.clear();
+        u.pending = false;
+        // Only an actual publication starts a new interval.
+        if (sent_any) u.last_publish_ns = now_ns;
+    }
+    pending_users_.resize(keep);
+}
+
 } // namespace quant
@@ -0,0 +1,100 @@
+#include "quant/pnl_history.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace quant {
+
+PnLHistory::PnLHistory(std::vector<Tier> tiers, uint64_t raw_window_ms, double raw_rate_hz)
+    : tiers_(std::move(tiers)),
+      raw_window_ms_(raw_window_ms),
+      raw_rate_hz_(raw_rate_hz > 0.0 ? raw_rate_hz : 60.0)
+{}
+
+void PnLHistory::set_raw_rate(double raw_rate_hz) {
+    std::lock_guard<std::mutex> g(mtx_);
+    if (raw_rate_hz > 0.0) raw_rate_hz_ = raw_rate_hz;
+}
+
+uint32_t PnLHistory::tier_capacity(std::size_t t) const {
+    const Tier& tier = tiers_[t];
+    if (tier.bucket_ms != 0 || tier.capacity != 0) return std::max<uint32_t>(1, tier.capacity);
+    // +1: the window includes both its ends
+    const double n = std::ceil(static_cast<double>(raw_window_ms_) * raw_rate_hz_ / 1000.0) + 1.0;
+    return static_cast<uint32_t>(std::min(std::max(n, 1.0), double(UINT32_MAX)));
+}
+
+void PnLHistory::record(const PnLUpdate& u, uint64_t now_ms) {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto& rings = series_[Key{u.user_id, u.instrument_id}];
+    if (rings.empty()) {
+        rings.resize(tiers_.size());
+        // bucket starts of UINT64_MAX mark slots that were never written
+        PnLSample unused;
+        unused.ts_ms = UINT64_MAX;
+        for (std::size_t t = 0; t < tiers_.size(); ++t)
+            rings[t].slots.resize(tier_capacity(t), unused);
+    }
+
+    for (std::size_t t = 0; t < tiers_.size(); ++t) {
+        Ring& r = rings[t];
+        const uint64_t cap = r.slots.size();
+        if (tiers_[t].bucket_ms == 0) {
+            PnLSample& s = r.slots[r.written % cap];
+            s.ts_ms = now_ms;
+            s.equity_min = s.equity_max = s.equity = u.equity;
+            s.realized = u.realized;
+            s.position = u.position;
+            ++r.written;
+            continue;
+        }
+
+        const uint64_t bucket = now_ms / tiers_[t].bucket_ms;
+        const uint64_t start  = bucket * tiers_[t].bucket_ms;
+        PnLSample& s = r.slots[bucket % cap];
+        if (s.ts_ms != start) {
+            // first sample of a new bucket overwrites whatever the slot held a lap ago
+            s.ts_ms = start;
+            s.equity_min = s.equity_max = u.equity;
+        } else {
+            s.equity_min = std::min(s.equity_min, u.equity);
+            s.equity_max = std::max(s.equity_max, u.equity);
+        }
+        s.equity   = u.equity;
+        s.realized = u.realized;
+        s.position = u.position;
+        r.last_bucket = std::max(r.last_bucket, bucket);
+    }
+}
+
+bool PnLHistory::query(uint64_t user_id, uint32_t instrument_id, uint8_t tier, uint64_t since_ms,
+                       std::vector<PnLSample>& out) const {
+    if (tier >= tiers_.size()) return false;
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = series_.find(Key{user_id, instrument_id});
+    if (it == series_.end()) return true;
+    const Ring& r = it->second[tier];
+    const uint64_t cap = r.slots.size();
+
+    if (tiers_[tier].bucket_ms == 0) {
+        if (r.written == 0) return true;
+        const uint64_t newest = r.slots[(r.written - 1) % cap].ts_ms;
+        const uint64_t floor_ms = std::max(since_ms, newest > raw_window_ms_ ? newest - raw_window_ms_ : 0);
+        for (uint64_t i = r.written > cap ? r.written - cap : 0; i < r.written; ++i) {
+            const PnLSample& s = r.slots[i % cap];
+            if (s.ts_ms >= floor_ms) out.push_back(s);
+        }
+        return true;
+    }
+
+    // Walk bucket numbers oldest -> newest; slots not stamped with the expected
+    // start are unused, empty buckets (no snapshots) or stale laps and are skipped.
+    const uint64_t width = tiers_[tier].bucket_ms;
+    const uint64_t first = r.last_bucket + 1 > cap ? r.last_bucket + 1 - cap : 0;
+    for (uint64_t b = first; b <= r.last_bucket; ++b) {
+        const PnLSample& s = r.slots[b % cap];
+        if (s.ts_ms == b * width && s.ts_ms >= since_ms) out.push_back(s);
+    }
+    return true;
+}
+
+} // namespace quant
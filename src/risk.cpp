@@ -0,0 +1,147 @@
+#include "quant/risk.hpp"
+#include <cmath>
+
+namespace quant {
+
+static constexpr double SECONDS_PER_YEAR = 365.0 * 24.0 * 3600.0;
+// Aggregates closer than this to the last published value are not re-published.
+static constexpr double RISK_EPSILON = 1e-9;
+
+RiskEngine::RiskEngine(uint64_t min_interval_ns)
+    : min_interval_ns_(min_interval_ns)
+{}
+
+void RiskEngine::define_option(const OptionSpec& spec) {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = options_.find(spec.instrument_id);
+    if (it != options_.end()) {
+        // moving an option between underlyings is not supported
+        if (it->second.underlying_id != spec.underlying_id) return;
+        // Redefinition on the same underlying updates the slot in place.
+        Underlying& u = underlyings_[spec.underlying_id];
+        uint32_t s = it->second.slot;
+        u.strike[s]    = spec.strike;
+        u.iv[s]        = spec.iv;
+        u.r[s]         = spec.r;
+        u.expiry_ms[s] = spec.expiry_ms;
+        u.is_call[s]   = spec.is_call ? 1 : 0;
+        u.dirty = true;
+        return;
+    }
+
+    Underlying& u = underlyings_[spec.underlying_id];
+    uint32_t slot = static_cast<uint32_t>(u.option_ids.size());
+    u.option_ids.push_back(spec.instrument_id);
+    u.strike.push_back(spec.strike);
+    u.iv.push_back(spec.iv);
+    u.r.push_back(spec.r);
+    u.expiry_ms.push_back(spec.expiry_ms);
+    u.is_call.push_back(spec.is_call ? 1 : 0);
+    u.dirty = true;
+    options_[spec.instrument_id] = OptionRef{spec.underlying_id, slot};
+}
+
+void RiskEngine::set_vol(uint32_t option_instrument_id, double iv) {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = options_.find(option_instrument_id);
+    if (it == options_.end()) return;
+    Underlying& u = underlyings_[it->second.underlying_id];
+    if (u.iv[it->second.slot] == iv) return;
+    u.iv[it->second.slot] = iv;
+    u.dirty = true;
+}
+
+void RiskEngine::on_fill(uint64_t user_id, uint32_t instrument_id, double signed_qty) {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto opt = options_.find(instrument_id);
+    if (opt != options_.end()) {
+        Underlying& u = underlyings_[opt->second.underlying_id];
+        Holding& h = u.holders[user_id];
+        if (h.option_qty.size() <= opt->second.slot) h.option_qty.resize(opt->second.slot + 1, 0.0);
+        h.option_qty[opt->second.slot] += signed_qty;
+        u.dirty = true;
+        return;
+    }
+    auto und = underlyings_.find(instrument_id);
+    if (und != underlyings_.end()) {
+        und->second.holders[user_id].underlying_qty += signed_qty;
+        und->second.dirty = true;
+    }
+}
+
+void RiskEngine::on_mark(uint32_t instrument_id, double mid) {
+    std::lock_guard<std::mutex> g(mtx_);
+    auto it = underlyings_.find(instrument_id);
+    if (it == underlyings_.end() || it->second.mid == mid) return;
+    it->second.mid = mid;
+    it->second.dirty = true;
+}
+
+void RiskEngine::recompute(uint64_t now_ns, std::vector<RiskUpdate>& out) {
+    std::lock_guard<std::mutex> g(mtx_);
+    for (auto& kv : underlyings_) {
+        Underlying& u = kv.second;
+        if (!u.dirty || u.mid <= 0.0 || u.holders.empty()) continue;
+        if (u.last_calc_ns != 0 && now_ns - u.last_calc_ns < min_interval_ns_) continue;
+        price_underlying(kv.first, u, now_ns, out);
+        u.dirty = false;
+        u.last_calc_ns = now_ns;
+    }
+}
+
+void RiskEngine::price_underlying(uint32_t underlying_id, Underlying& u, uint64_t now_ns,
+                                  std::vector<RiskUpdate>& out) {
+    const std::size_t n = u.option_ids.size();
+    const uint64_t now_ms = now_ns / 1'000'000;
+    u.tau.resize(n);
+    u.greeks.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        u.tau[i] = u.expiry_ms[i] > now_ms
+                 ? double(u.expiry_ms[i] - now_ms) / 1000.0 / SECONDS_PER_YEAR
+                 : 0.0;
+    }
+    bs_greeks_batch(u.mid, u.r.data(), u.strike.data(), u.iv.data(), u.tau.data(),
+                    u.is_call.data(), n, u.greeks.data());
+
+    for (auto& kv : u.holders) {
+        Holding& h = kv.second;
+        RiskUpdate ru;
+        ru.user_id        = static_cast<uint32_t>(kv.first);
+        ru.underlying_id  = underlying_id;
+        ru.underlying_mid = u.mid;
+        ru.delta          = h.underlying_qty;
+        for (std::size_t i = 0; i < h.option_qty.size(); ++i) {
+            const double q = h.option_qty[i];
+            if (q == 0.0) continue;
+            ru.delta += q * u.greeks[i].delta;
+            ru.gamma += q * u.greeks[i].gamma;
+            ru.vega  += q * u.greeks[i].vega;
+            ru.theta += q * u.greeks[i].theta;
+        }
+
+        const RiskUpdate& p = h.last;
+        bool changed = !h.published ||
+                       std::abs(ru.delta - p.delta) > RISK_EPSILON ||
+                       std::abs(ru.gamma - p.gamma) > RISK_EPSILON ||
+                       std::abs(ru.vega  - p.vega)  > RISK_EPSILON ||
+                       std::abs(ru.theta - p.theta) > RISK_EPSILON;
+        h.last = ru;
+        if (changed) {
+            h.published = true;
+            out.push_back(ru);
+        }
+    }
+}
+
+RiskUpdate RiskEngine::get(uint64_t user_id, uint32_t underlying_id) const {
+    std::lock_guard<std::mutex> g(mtx_);
+    RiskUpdate out;
+    out.user_id = static_cast<uint32_t>(user_id);
+    out.underlying_id = underlying_id;
+    auto u = underlyings_.find(underlying_id);
+    if (u == underlyings_.end()) return out;
+    auto h = u->second.holders.find(user_id);
+    return h == u->second.holders.end() ? out : h->second.last;
+}
+
+} // namespace quant
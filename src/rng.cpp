@@ -0,0 +1,370 @@
+#include "quant/rng.hpp"
+#include "quant/cpu_dispatch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#if QUANT_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace quant {
+    // -----------------------------------------
+    // Uniforms
+    // -----------------------------------------
+
+    // 53 random bits -> (0, 1): the half-ulp offset keeps log(u) finite.
+    static inline double to_unit(uint32_t hi, uint32_t lo) {
+        uint64_t bits = ((uint64_t(hi) << 32) | lo) >> 11;
+        return (double(bits) + 0.5) * (1.0 / 9007199254740992.0);
+    }
+
+    void CounterRNG::uniform_pair(uint64_t pair, uint32_t dim, double& u1, double& u2) const {
+        Philox4x32 ctr{{static_cast<uint32_t>(pair), static_cast<uint32_t>(pair >> 32), dim, 0u}};
+        Philox4x32 r = philox4x32_10(ctr, k0_, k1_);
+        u1 = to_unit(r.c[0], r.c[1]);
+        u2 = to_unit(r.c[2], r.c[3]);
+    }
+
+    double CounterRNG::uniform(uint64_t path, uint32_t dim) const {
+        double u1, u2;
+        uniform_pair(path >> 1, dim, u1, u2);
+        return (path & 1) ? u2 : u1;
+    }
+
+    // -----------------------------------------
+    // Branch-free log / sincos for Box-Muller
+    // -----------------------------------------
+
+    // log(x) for x in (0, 1]: x = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+    // log(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.1716 (odd series to s^21).
+    static inline double bm_log(double x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        int64_t e = int64_t((bits >> 52) & 0x7FF) - 1023;
+        uint64_t mbits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+        double m;
+        std::memcpy(&m, &mbits, sizeof(m));
+        // fold [sqrt2, 2) down so m is centred on 1
+        const bool big = m > 1.4142135623730951;
+        m = big ? 0.5 * m : m;
+        e = big ? e + 1 : e;
+
+        const double s = (m - 1.0) / (m + 1.0);
+        const double s2 = s * s;
+        double p = 1.0 / 21;
+        p = p * s2 + 1.0 / 19;
+        p = p * s2 + 1.0 / 17;
+        p = p * s2 + 1.0 / 15;
+        p = p * s2 + 1.0 / 13;
+        p = p * s2 + 1.0 / 11;
+        p = p * s2 + 1.0 / 9;
+        p = p * s2 + 1.0 / 7;
+        p = p * s2 + 1.0 / 5;
+        p = p * s2 + 1.0 / 3;
+        p = p * s2 + 1.0;
+        return 2.0 * s * p + double(e) * 0.6931471805599453;
+    }
+
+    // sin/cos of 2*pi*u for u in (0, 1): reduce to r in [-pi/4, pi/4] plus a quadrant,
+    // evaluate Taylor polynomials, then rotate by the quadrant with selects.
+    static inline void bm_sincos_2pi(double u, double& s_out, double& c_out) {
+        const double q = std::floor(4.0 * u + 0.5);     // quadrant 0..4
+        const double r = (u - 0.25 * q) * 6.283185307179586;
+        const double r2 = r * r;
+
+        double s = 1.0 / 355687428096000.0;             // 1/17! ... -1/3!
+        s = s * r2 - 1.0 / 1307674368000.0;
+        s = s * r2 + 1.0 / 6227020800.0;
+        s = s * r2 - 1.0 / 39916800.0;
+        s = s * r2 + 1.0 / 362880.0;
+        s = s * r2 - 1.0 / 5040.0;
+        s = s * r2 + 1.0 / 120.0;
+        s = s * r2 - 1.0 / 6.0;
+        s = r + r * r2 * s;
+        double c = 1.0 / 20922789888000.0;              // 1/16! ... 1
+        c = c * r2 - 1.0 / 87178291200.0;
+        c = c * r2 + 1.0 / 479001600.0;
+        c = c * r2 - 1.0 / 3628800.0;
+        c = c * r2 + 1.0 / 40320.0;
+        c = c * r2 - 1.0 / 720.0;
+        c = c * r2 + 1.0 / 24.0;
+        c = c * r2 - 0.5;
+        c = 1.0 + r2 * c;
+
+        const int k = static_cast<int>(q) & 3;
+        s_out = (k == 0) ? s : (k == 1) ? c : (k == 2) ? -s : -c;
+        c_out = (k == 0) ? c : (k == 1) ? -s : (k == 2) ? -c : s;
+    }
+
+    static inline void box_muller(double u1, double u2, double& z0, double& z1) {
+        const double rad = std::sqrt(-2.0 * bm_log(u1));
+        double s, c;
+        bm_sincos_2pi(u2, s, c);
+        z0 = rad * c;
+        z1 = rad * s;
+    }
+
+    static void box_muller_scalar(const double* u1, const double* u2, double* z0, double* z1,
+                                  std::size_t n) {
+        for (std::size_t j = 0; j < n; ++j) box_muller(u1[j], u2[j], z0[j], z1[j]);
+    }
+
+#if QUANT_X86_DISPATCH
+    // Same operations as box_muller() in the same order, 4 lanes at a time. No FMA is
+    // used, so results are bit-identical to the scalar path.
+    // p * x + c without contraction (matches the scalar Horner steps bit for bit)
+    __attribute__((target("avx2"), always_inline))
+    static inline __m256d horner(__m256d p, __m256d x, double c) {
+        return _mm256_add_pd(_mm256_mul_pd(p, x), _mm256_set1_pd(c));
+    }
+
+    __attribute__((target("avx2")))
+    static void box_muller_avx2(const double* u1, const double* u2, double* z0, double* z1,
+                                std::size_t n) {
+        const __m256d one   = _mm256_set1_pd(1.0);
+        const __m256d half  = _mm256_set1_pd(0.5);
+        const __m256d sqrt2 = _mm256_set1_pd(1.4142135623730951);
+        const __m256d ln2   = _mm256_set1_pd(0.6931471805599453);
+        const __m256d two_pi = _mm256_set1_pd(6.283185307179586);
+        const __m256i mant_mask = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll);
+        const __m256i one_bits  = _mm256_set1_epi64x(0x3FF0000000000000ll);
+        // 2^52 trick: small non-negative int64 -> double without AVX-512DQ
+        const __m256i magic_i = _mm256_set1_epi64x(0x4330000000000000ll);
+        const __m256d magic_d = _mm256_set1_pd(4503599627370496.0);
+        const __m256d bias    = _mm256_set1_pd(1023.0);
+
+        std::size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            // ---- log(u1) ----
+            __m256d x = _mm256_loadu_pd(u1 + j);
+            __m256i bits = _mm256_castpd_si256(x);
+            __m256i ebits = _mm256_srli_epi64(bits, 52);
+            __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(ebits, magic_i)), magic_d);
+            e = _mm256_sub_pd(e, bias);
+            __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, mant_mask), one_bits));
+            __m256d big = _mm256_cmp_pd(m, sqrt2, _CMP_GT_OQ);
+            m = _mm256_blendv_pd(m, _mm256_mul_pd(half, m), big);
+            e = _mm256_blendv_pd(e, _mm256_add_pd(e, one), big);
+
+            __m256d s  = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+            __m256d s2 = _mm256_mul_pd(s, s);
+            __m256d p = _mm256_set1_pd(1.0 / 21);
+            p = horner(p, s2, 1.0 / 19);
+            p = horner(p, s2, 1.0 / 17);
+            p = horner(p, s2, 1.0 / 15);
+            p = horner(p, s2, 1.0 / 13);
+            p = horner(p, s2, 1.0 / 11);
+            p = horner(p, s2, 1.0 / 9);
+            p = horner(p, s2, 1.0 / 7);
+            p = horner(p, s2, 1.0 / 5);
+            p = horner(p, s2, 1.0 / 3);
+            p = horner(p, s2, 1.0);
+            __m256d lg = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), s), p),
+                                       _mm256_mul_pd(e, ln2));
+            __m256d rad = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_set1_pd(-2.0), lg));
+
+            // ---- sincos(2 pi u2) ----
+            __m256d u = _mm256_loadu_pd(u2 + j);
+            __m256d q = _mm256_floor_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(4.0), u), half));
+            __m256d r = _mm256_mul_pd(_mm256_sub_pd(u, _mm256_mul_pd(_mm256_set1_pd(0.25), q)), two_pi);
+            __m256d r2 = _mm256_mul_pd(r, r);
+
+            __m256d sn = _mm256_set1_pd(1.0 / 355687428096000.0);
+            sn = horner(sn, r2, -1.0 / 1307674368000.0);
+            sn = horner(sn, r2, 1.0 / 6227020800.0);
+            sn = horner(sn, r2, -1.0 / 39916800.0);
+            sn = horner(sn, r2, 1.0 / 362880.0);
+            sn = horner(sn, r2, -1.0 / 5040.0);
+            sn = horner(sn, r2, 1.0 / 120.0);
+            sn = horner(sn, r2, -1.0 / 6.0);
+            sn = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, r2), sn));
+            __m256d cs = _mm256_set1_pd(1.0 / 20922789888000.0);
+            cs = horner(cs, r2, -1.0 / 87178291200.0);
+            cs = horner(cs, r2, 1.0 / 479001600.0);
+            cs = horner(cs, r2, -1.0 / 3628800.0);
+            cs = horner(cs, r2, 1.0 / 40320.0);
+            cs = horner(cs, r2, -1.0 / 720.0);
+            cs = horner(cs, r2, 1.0 / 24.0);
+            cs = horner(cs, r2, -0.5);
+            cs = _mm256_add_pd(one, _mm256_mul_pd(r2, cs));
+
+            // quadrant k = q mod 4 (q in 0..4): swap for odd k, negate per rotation table
+            __m256d k = _mm256_sub_pd(q, _mm256_mul_pd(_mm256_set1_pd(4.0),
+                                      _mm256_floor_pd(_mm256_mul_pd(q, _mm256_set1_pd(0.25)))));
+            __m256d odd  = _mm256_cmp_pd(_mm256_sub_pd(k, _mm256_mul_pd(_mm256_set1_pd(2.0),
+                                         _mm256_floor_pd(_mm256_mul_pd(k, half)))), one, _CMP_EQ_OQ);
+            __m256d sneg = _mm256_cmp_pd(k, one, _CMP_GT_OQ);            // k = 2, 3
+            __m256d cneg = _mm256_or_pd(_mm256_cmp_pd(k, one, _CMP_EQ_OQ),
+                                        _mm256_cmp_pd(k, _mm256_set1_pd(2.0), _CMP_EQ_OQ)); // k = 1, 2
+            const __m256d sign = _mm256_set1_pd(-0.0);
+            __m256d sv = _mm256_blendv_pd(sn, cs, odd);
+            __m256d cv = _mm256_blendv_pd(cs, sn, odd);
+            sv = _mm256_xor_pd(sv, _mm256_and_pd(sneg, sign));
+            cv = _mm256_xor_pd(cv, _mm256_and_pd(cneg, sign));
+
+            _mm256_storeu_pd(z0 + j, _mm256_mul_pd(rad, cv));
+            _mm256_storeu_pd(z1 + j, _mm256_mul_pd(rad, sv));
+        }
+        box_muller_scalar(u1 + j, u2 + j, z0 + j, z1 + j, n - j);
+    }
+#endif
+
+    // -----------------------------------------
+    // Uniform pairs
+    // -----------------------------------------
+
+    static void uniform_pairs_scalar(uint64_t pair0, uint32_t dim, uint32_t k0, uint32_t k1,
+                                     double* u1, double* u2, std::size_t n) {
+        for (std::size_t j = 0; j < n; ++j) {
+            const uint64_t pair = pair0 + j;
+            Philox4x32 r = philox4x32_10({{static_cast<uint32_t>(pair), static_cast<uint32_t>(pair >> 32), dim, 0u}},
+                                         k0, k1);
+            u1[j] = to_unit(r.c[0], r.c[1]);
+            u2[j] = to_unit(r.c[2], r.c[3]);
+        }
+    }
+
+#if QUANT_X86_DISPATCH
+    // (hi:lo >> 11 + 0.5) * 2^-53 per 64-bit lane, exactly as to_unit(): the 53-bit
+    // integer is split into 21 + 32 bits, each converted with the 2^52 trick.
+    __attribute__((target("avx2"), always_inline))
+    static inline __m256d to_unit_avx2(__m256i hi, __m256i lo) {
+        const __m256i magic_i = _mm256_set1_epi64x(0x4330000000000000ll);
+        const __m256d magic_d = _mm256_set1_pd(4503599627370496.0);
+        __m256i bits = _mm256_srli_epi64(_mm256_or_si256(_mm256_slli_epi64(hi, 32), lo), 11);
+        __m256i top  = _mm256_srli_epi64(bits, 32);
+        __m256i low  = _mm256_and_si256(bits, _mm256_set1_epi64x(0xFFFFFFFFll));
+        __m256d dtop = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(top, magic_i)), magic_d);
+        __m256d dlow = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(low, magic_i)), magic_d);
+        __m256d v = _mm256_add_pd(_mm256_mul_pd(dtop, _mm256_set1_pd(4294967296.0)), dlow);
+        return _mm256_mul_pd(_mm256_add_pd(v, _mm256_set1_pd(0.5)),
+                             _mm256_set1_pd(1.0 / 9007199254740992.0));
+    }
+
+    // Philox4x32-10 for 4 consecutive counters at once; each 32-bit word lives in the low
+    // half of a 64-bit lane so _mm256_mul_epu32 yields the full 64-bit products.
+    __attribute__((target("avx2")))
+    static void uniform_pairs_avx2(uint64_t pair0, uint32_t dim, uint32_t k0, uint32_t k1,
+                                   double* u1, double* u2, std::size_t n) {
+        const __m256i lo32 = _mm256_set1_epi64x(0xFFFFFFFFll);
+        const __m256i M0 = _mm256_set1_epi64x(0xD2511F53ll);
+        const __m256i M1 = _mm256_set1_epi64x(0xCD9E8D57ll);
+        std::size_t j = 0;
+        for (; j + 4 <= n; j += 4) {
+            const uint64_t p = pair0 + j;
+            __m256i pairs = _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>(p)),
+                                             _mm256_set_epi64x(3, 2, 1, 0));
+            __m256i c0 = _mm256_and_si256(pairs, lo32);
+            __m256i c1 = _mm256_srli_epi64(pairs, 32);
+            __m256i c2 = _mm256_set1_epi64x(dim);
+            __m256i c3 = _mm256_setzero_si256();
+            uint32_t key0 = k0, key1 = k1;
+            for (int round = 0; round < 10; ++round) {
+                __m256i p0 = _mm256_mul_epu32(c0, M0);
+                __m256i p1 = _mm256_mul_epu32(c2, M1);
+                __m256i kk0 = _mm256_set1_epi64x(key0);
+                __m256i kk1 = _mm256_set1_epi64x(key1);
+                c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), kk0);
+                c1 = _mm256_and_si256(p1, lo32);
+                c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), kk1);
+                c3 = _mm256_and_si256(p0, lo32);
+                key0 += 0x9E3779B9u;
+                key1 += 0xBB67AE85u;
+            }
+            _mm256_storeu_pd(u1 + j, to_unit_avx2(c0, c1));
+            _mm256_storeu_pd(u2 + j, to_unit_avx2(c2, c3));
+        }
+        uniform_pairs_scalar(pair0 + j, dim, k0, k1, u1 + j, u2 + j, n - j);
+    }
+#endif
+
+    using UniformPairsFn = void (*)(uint64_t, uint32_t, uint32_t, uint32_t, double*, double*, std::size_t);
+    using BoxMullerFn = void (*)(const double*, const double*, double*, double*, std::size_t);
+
+    static UniformPairsFn select_uniform_pairs() {
+#if QUANT_X86_DISPATCH
+        if (cpu_has_avx2()) return uniform_pairs_avx2;
+#endif
+        return uniform_pairs_scalar;
+    }
+
+    static BoxMullerFn select_box_muller() {
+#if QUANT_X86_DISPATCH
+        if (cpu_has_avx2()) return box_muller_avx2;
+#endif
+        return box_muller_scalar;
+    }
+
+    double CounterRNG::normal(uint64_t path, uint32_t dim) const {
+        double u1, u2, z0, z1;
+        uniform_pair(path >> 1, dim, u1, u2);
+        box_muller(u1, u2, z0, z1);
+        return (path & 1) ? z1 : z0;
+    }
+
+    // -----------------------------------------
+    // Batched draws
+    // -----------------------------------------
+
+    // Pairs per inner block: uniforms are staged in small arrays so the transform
+    // loop is a straight-line pass over contiguous doubles.
+    static constexpr std::size_t RNG_BLOCK = 64;
+
+    // Shared by the double and float outputs: Box-Muller runs in double and only the
+    // interleaving store narrows, so float draws are the rounded double draws.
+    template <class T>
+    static void normals_impl(const CounterRNG& rng, uint32_t k0, uint32_t k1, uint64_t path0,
+                             std::size_t n, uint32_t dim, T* out) {
+        static const UniformPairsFn uniform_pairs_block = select_uniform_pairs();
+        static const BoxMullerFn box_muller_block = select_box_muller();
+        std::size_t i = 0;
+        // leading odd path: second half of its pair
+        if (n > 0 && (path0 & 1)) {
+            out[i++] = static_cast<T>(rng.normal(path0, dim));
+        }
+
+        double u1[RNG_BLOCK], u2[RNG_BLOCK], z0[RNG_BLOCK], z1[RNG_BLOCK];
+        while (n - i >= 2) {
+            const uint64_t pair0 = (path0 + i) >> 1;
+            const std::size_t pairs = std::min<std::size_t>(RNG_BLOCK, (n - i) / 2);
+            uniform_pairs_block(pair0, dim, k0, k1, u1, u2, pairs);
+            box_muller_block(u1, u2, z0, z1, pairs);
+            for (std::size_t j = 0; j < pairs; ++j) {
+                out[i + 2 * j]     = static_cast<T>(z0[j]);
+                out[i + 2 * j + 1] = static_cast<T>(z1[j]);
+            }
+            i += 2 * pairs;
+        }
+        // trailing even path: first half of its pair
+        if (i < n) out[i] = static_cast<T>(rng.normal(path0 + i, dim));
+    }
+
+    void CounterRNG::normals(uint64_t path0, std::size_t n, uint32_t dim, double* out) const {
+        normals_impl(*this, k0_, k1_, path0, n, dim, out);
+    }
+
+    void CounterRNG::normals(uint64_t path0, std::size_t n, uint32_t dim, float* out) const {
+        normals_impl(*this, k0_, k1_, path0, n, dim, out);
+    }
+
+    void CounterRNG::uniforms(uint64_t path0, std::size_t n, uint32_t dim, double* out) const {
+        static const UniformPairsFn uniform_pairs_block = select_uniform_pairs();
+        std::size_t i = 0;
+        if (n > 0 && (path0 & 1)) {
+            out[i++] = uniform(path0, dim);
+        }
+
+        double u1[RNG_BLOCK], u2[RNG_BLOCK];
+        while (n - i >= 2) {
+            const uint64_t pair0 = (path0 + i) >> 1;
+            const std::size_t pairs = std::min<std::size_t>(RNG_BLOCK, (n - i) / 2);
+            uniform_pairs_block(pair0, dim, k0_, k1_, u1, u2, pairs);
+            for (std::size_t j = 0; j < pairs; ++j) {
+                out[i + 2 * j]     = u1[j];
+                out[i + 2 * j + 1] = u2[j];
+            }
+            i += 2 * pairs;
+        }
+        if (i < n) out[i] = uniform(path0 + i, dim);
+    }
+}
@@ -2,20 +2,38 @@
 #include <vector>
 #include <unordered_map>
 #include <chrono>
+#include <cstdint>
 #include <thread>
 #include <iostream>
+#include <string>
+#include <algorithm>
 
 namespace quant {
 
-MatchingServer::MatchingServer(std::size_t in_capacity, std::size_t out_capacity)
+// --- BS bot user id (must match BSBotConfig.user_id) ---
+static constexpr uint64_t BS_BOT_USER_ID = 9999;
+// --- UI user id whose PnL is streamed ---
+static constexpr uint64_t UI_USER_ID = 1;
+
+MatchingServer::InstrumentState::InstrumentState(uint32_t instrument_id)
+    : id(instrument_id),
+      book("INST-" + std::to_string(instrument_id)),
+      analytics(instrument_id)
+{
+    last_tob.instrument_id = instrument_id;
+}
+
+MatchingServer::MatchingServer(std::size_t in_capacity, std::size_t out_capacity,
+                               CostBasis cost_basis)
     : running_(false),
       in_queue_(in_capacity),
       out_queue_(out_capacity),
-      book_("FOO"),
-      tracked_user_id_(1),
-      pnl_(tracked_user_id_),
-      bs_pnl_(9999) // BS bot user id
-{}
+      strategy_queue_(out_capacity),
+      pnl_(cost_basis),
+      tracked_users_{UI_USER_ID, BS_BOT_USER_ID}
+{
+    instruments_.emplace(DEFAULT_INSTRUMENT_ID, std::make_unique<InstrumentState>(DEFAULT_INSTRUMENT_ID));
+}
 
 MatchingServer::~MatchingServer() {
     stop();
@@ -47,12 +65,24 @@ bool MatchingServer::submit_cancel(const MsgCancel& m) {
     return in_queue_.push(cm);
 }
 
+bool MatchingServer::submit_amend(const MsgAmend& m) {
+    ClientMessage cm{};
+    cm.type = AMEND;
+    cm.amend = m;
+    return in_queue_.push(cm);
+}
+
 bool MatchingServer::get_next_server_message(ServerMessage& out_msg) {
     return out_queue_.pop(out_msg);
 }
 
-// --- BS bot user id (must match BSBotConfig.user_id) ---
-static constexpr uint64_t BS_BOT_USER_ID = 9999;
+void MatchingServer::enable_strategy_feed(bool on) {
+    strategy_feed_.store(on, std::memory_order_release);
+}
+
+bool MatchingServer::get_next_strategy_message(ServerMessage& out_msg) {
+    return strategy_queue_.pop(out_msg);
+}
 
 void emit_trades(const std::vector<Trade>& trades,
                  SPSCQueue<ServerMessage>& out_queue_) {
@@ -70,144 +100,362 @@ void emit_trades(const std::vector<Trade>& trades,
     }
 }
 
+static uint64_t wall_clock_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
 static void emit_ack(MsgType type, uint64_t order_id, bool ok,
                      SPSCQueue<ServerMessage>& out_q) {
     ServerMessage sm{};
     sm.type = ACK;
+    sm.ack = Ack{};
     sm.ack.status   = ok ? 0 : 1; // 0=OK,1=ERROR
     sm.ack.type     = static_cast<uint8_t>(type);
     sm.ack.order_id = order_id;
     out_q.push(sm);
 }
 
-void MatchingServer::engine_loop() {
-    TopOfBook last_tob{};
-    bool have_last_tob = false;
+using Levels = std::vector<std::pair<double, uint64_t>>;
+
+static void begin_depth(ServerMessage& sm, uint32_t instrument_id, uint8_t side, bool snapshot) {
+    sm.type = DEPTH_UPDATE;
+    sm.depth = DepthUpdate{};
+    sm.depth.instrument_id = instrument_id;
+    sm.depth.side = side;
+    sm.depth.is_snapshot = snapshot ? 1 : 0;
+    sm.depth.count = 0;
+}
+
+// Merge-walk two best-first level snapshots and emit the changed levels (qty 0 => removed),
+// MAX_DEPTH_LEVELS per DEPTH_UPDATE. Nothing is emitted if the side is unchanged.
+static void emit_depth_diff(const Levels& before, const Levels& after,
+                            uint32_t instrument_id, uint8_t side,
+                            SPSCQueue<ServerMessage>& out_q) {
+    // bids are sorted by price desc, asks asc
+    auto better = [side](double a, double b) { return side == 0 ? a > b : a < b; };
+
+    ServerMessage sm{};
+    begin_depth(sm, instrument_id, side, false);
+    auto add = [&](double price, uint64_t qty) {
+        sm.depth.levels[sm.depth.count++] = DepthLevel{price, qty};
+        if (sm.depth.count == MAX_DEPTH_LEVELS) {
+            out_q.push(sm);
+            sm.depth.count = 0;
+        }
+    };
+
+    std::size_t i = 0, j = 0;
+    while (i < before.size() || j < after.size()) {
+        if (j == after.size() || (i < before.size() && better(before[i].first, after[j].first))) {
+            add(before[i].first, 0);                       // level removed
+            ++i;
+        } else if (i == before.size() || better(after[j].first, before[i].first)) {
+            add(after[j].first, after[j].second);          // level added
+            ++j;
+        } else {
+            if (before[i].second != after[j].second)
+                add(after[j].first, after[j].second);      // quantity changed
+            ++i;
+            ++j;
+        }
+    }
+    if (sm.depth.count > 0) out_q.push(sm);
+}
+
+// Emit every level of one side to one client: the first frame is the snapshot (replaces the
+// side; an empty side still sends count 0), the rest add deeper levels incrementally.
+static void emit_depth_snapshot(const Levels& levels, uint32_t instrument_id, uint8_t side,
+                                uint32_t client_id, SPSCQueue<ServerMessage>& out_q) {
+    ServerMessage sm{};
+    sm.target_client = client_id;
+    begin_depth(sm, instrument_id, side, true);
+    for (const auto& lv : levels) {
+        sm.depth.levels[sm.depth.count++] = DepthLevel{lv.first, lv.second};
+        if (sm.depth.count == MAX_DEPTH_LEVELS) {
+            out_q.push(sm);
+            sm.depth.is_snapshot = 0;
+            sm.depth.count = 0;
+        }
+    }
+    if (sm.depth.count > 0 || sm.depth.is_snapshot) out_q.push(sm);
+}
+
+void MatchingServer::request_depth_snapshot(uint32_t client_id) {
+    {
+        std::lock_guard<std::mutex> g(depth_snapshot_mtx_);
+        depth_snapshot_clients_.push_back(client_id);
+    }
+    depth_snapshot_requested_.store(true, std::memory_order_release);
+}
+
+void MatchingServer::enable_l3_feed(bool on) {
+    l3_enabled_.store(on, std::memory_order_release);
+}
+
+void MatchingServer::request_l3_snapshot() {
+    l3_snapshot_requested_.store(true, std::memory_order_release);
+}
+
+// Forward buffered book events as L3_EVENT messages and reset the buffer.
+static void emit_l3_events(std::vector<L3Event>& events, uint32_t instrument_id,
+                           SPSCQueue<ServerMessage>& out_q) {
+    for (const auto& ev : events) {
+        ServerMessage sm{};
+        sm.type = L3_EVENT;
+        sm.l3 = ev;
+        sm.l3.instrument_id = instrument_id;
+        out_q.push(sm);
+    }
+    events.clear();
+}
+
+void MatchingServer::register_instrument(uint32_t instrument_id) {
+    std::lock_guard<std::mutex> g(instruments_mtx_);
+    pending_instruments_.push_back(instrument_id);
+    instruments_pending_.store(true, std::memory_order_release);
+}
 
+void MatchingServer::define_option(const OptionSpec& spec) {
+    register_instrument(spec.underlying_id);
+    register_instrument(spec.instrument_id);
+    risk_.define_option(spec);
+}
+
+void MatchingServer::set_option_vol(uint32_t option_instrument_id, double iv) {
+    risk_.set_vol(option_instrument_id, iv);
+}
+
+bool MatchingServer::query_pnl_history(uint64_t user_id, uint32_t instrument_id, uint8_t tier,
+                                       uint64_t since_ms, std::vector<PnLSample>& out,
+                                       uint32_t& bucket_ms) const {
+    bucket_ms = pnl_history_.bucket_ms(tier);
+    return pnl_history_.query(user_id, instrument_id, tier, since_ms, out);
+}
+
+bool MatchingServer::query_lots(uint64_t user_id, uint32_t instrument_id, std::vector<LotInfo>& open,
+                                std::vector<LotInfo>& closed) const {
+    if (pnl_.cost_basis() != CostBasis::FIFO) return false;
+    pnl_.open_lots(user_id, instrument_id, open);
+    pnl_.closed_lots(user_id, instrument_id, closed);
+    return true;
+}
+
+MatchingServer::InstrumentState* MatchingServer::find_instrument(uint32_t instrument_id) {
+    auto it = instruments_.find(instrument_id);
+    if (it == instruments_.end() && instruments_pending_.load(std::memory_order_acquire)) {
+        // registered after this loop pass started
+        add_pending_instruments();
+        it = instruments_.find(instrument_id);
+    }
+    return it == instruments_.end() ? nullptr : it->second.get();
+}
+
+void MatchingServer::add_pending_instruments() {
+    std::vector<uint32_t> ids;
+    {
+        std::lock_guard<std::mutex> g(instruments_mtx_);
+        ids.swap(pending_instruments_);
+        instruments_pending_.store(false, std::memory_order_relaxed);
+    }
+    for (uint32_t id : ids) {
+        if (instruments_.find(id) == instruments_.end())
+            instruments_.emplace(id, std::make_unique<InstrumentState>(id));
+    }
+}
+
+void MatchingServer::mark_pnl_dirty(uint64_t user_id, uint32_t instrument_id) {
+    if (std::find(tracked_users_.begin(), tracked_users_.end(), user_id) == tracked_users_.end())
+        return;
+    pnl_publisher_.mark_dirty(user_id, instrument_id);
+}
+
+void MatchingServer::set_pnl_publish_rate(double max_rate_hz, double epsilon) {
+    pnl_publisher_.configure(max_rate_hz, epsilon);
+    // the raw history tier must hold its whole window at the new rate
+    pnl_history_.set_raw_rate(max_rate_hz);
+}
+
+void MatchingServer::engine_loop() {
     // Process up to BATCH_SIZE client messages per iteration to bound latency and work per tick.
     constexpr std::size_t BATCH_SIZE = 1024;
 
     while (running_) {
         std::size_t processed = 0;
 
+        if (instruments_pending_.load(std::memory_order_acquire)) add_pending_instruments();
+
+        // Close bars on the wall clock even when no trades arrive.
+        uint64_t now_ns = wall_clock_ns();
+        for (auto& kv : instruments_) {
+            kv.second->analytics.roll(now_ns, closed_bars_);
+        }
+        for (const auto& b : closed_bars_) {
+            ServerMessage sm{};
+            sm.type = BAR;
+            sm.bar  = b;
+            out_queue_.push(sm);
+        }
+        closed_bars_.clear();
+
+        // Portfolio Greeks for underlyings that moved since the last (throttled) pass.
+        risk_.recompute(now_ns, risk_updates_);
+        for (const auto& r : risk_updates_) {
+            ServerMessage sm{};
+            sm.type = RISK_UPDATE;
+            sm.risk = r;
+            out_queue_.push(sm);
+        }
+        risk_updates_.clear();
+
+        // PnL state is updated eagerly below; snapshots go out here, rate-limited per user.
+        pnl_publisher_.collect(pnl_, now_ns, pnl_updates_);
+        const uint64_t now_ms = now_ns / 1'000'000;
+        for (std::size_t i = 0; i < pnl_updates_.size(); ++i) {
+            const PnLUpdate& p = pnl_updates_[i];
+            ServerMessage sm{};
+            sm.type = PNL_UPDATE;
+            sm.pnl  = p;
+            out_queue_.push(sm);
+            pnl_history_.record(p, now_ms);
+            // one totals sample per user per batch (snapshots are grouped by user)
+            if (i + 1 == pnl_updates_.size() || pnl_updates_[i + 1].user_id != p.user_id)
+                pnl_history_.record(pnl_.get_total(p.user_id), now_ms);
+        }
+        pnl_updates_.clear();
+
+        // Full depth for newly connected consumers, sent to each of them only.
+        if (depth_snapshot_requested_.exchange(false, std::memory_order_acq_rel)) {
+            std::vector<uint32_t> clients;
+            {
+                std::lock_guard<std::mutex> g(depth_snapshot_mtx_);
+                clients.swap(depth_snapshot_clients_);
+            }
+            for (uint32_t client_id : clients) {
+                for (auto& kv : instruments_) {
+                    emit_depth_snapshot(kv.second->book.snapshot_bids(), kv.first, 0, client_id, out_queue_);
+                    emit_depth_snapshot(kv.second->book.snapshot_asks(), kv.first, 1, client_id, out_queue_);
+                }
+            }
+        }
+
+        // L3 feed: install/remove each book's event sink; snapshot for new subscribers.
+        // The request is only consumed while the feed is on: a subscribe sets the enable flag
+        // before the request, so a request seen with the feed still off is kept for next pass.
+        const bool l3_on = l3_enabled_.load(std::memory_order_acquire);
+        const bool strategy_on = strategy_feed_.load(std::memory_order_acquire);
+        const bool l3_snap = l3_on && l3_snapshot_requested_.exchange(false, std::memory_order_acq_rel);
+        for (auto& kv : instruments_) {
+            kv.second->book.set_event_sink(l3_on ? &l3_events_ : nullptr);
+            if (l3_snap) {
+                kv.second->book.snapshot_orders(l3_events_);
+                emit_l3_events(l3_events_, kv.first, out_queue_);
+            }
+        }
+
         while (processed < BATCH_SIZE) {
             ClientMessage cm;
             if (!in_queue_.pop(cm)) break;
             ++processed;
 
+            // Resolve the target book: new orders name it, cancels/amends look it up.
+            uint32_t instrument_id = DEFAULT_INSTRUMENT_ID;
+            if (cm.type == NEW_ORDER) {
+                instrument_id = cm.new_order.instrument_id;
+            } else {
+                uint64_t oid = (cm.type == CANCEL) ? cm.cancel.order_id : cm.amend.order_id;
+                auto it = order_instrument_.find(oid);
+                if (it == order_instrument_.end()) {
+                    emit_ack(cm.type, oid, false, out_queue_);
+                    continue;
+                }
+                instrument_id = it->second;
+            }
+            InstrumentState* inst_ptr = find_instrument(instrument_id);
+            if (!inst_ptr) {
+                // unregistered instrument: reject before any book is allocated
+                emit_ack(NEW_ORDER, 0, false, out_queue_);
+                continue;
+            }
+            InstrumentState& inst = *inst_ptr;
+            OrderBook& book = inst.book;
+            book.set_event_sink(l3_on ? &l3_events_ : nullptr);
+
             // Capture previous L2 snapshots to emit minimal diffs after processing.
-            auto prev_bids = book_.snapshot_bids();
-            auto prev_asks = book_.snapshot_asks();
+            auto prev_bids = book.snapshot_bids();
+            auto prev_asks = book.snapshot_asks();
 
             std::vector<Trade> trades;
             trades.reserve(8);
 
-            if (cm.type == NEW_ORDER) {
-                // Construct engine Order from client message; engine assigns id/timestamp as needed.
+            if (cm.type == NEW_ORDER && book.full()) {
+                // resting-order pool of this book exhausted: reject instead of failing
+                emit_ack(NEW_ORDER, 0, false, out_queue_);
+            } else if (cm.type == NEW_ORDER) {
+                // Construct engine Order from client message; engine assigns engine-wide id.
                 Order o;
-                o.order_id  = 0;
+                o.order_id  = next_order_id_++;
                 o.user_id   = cm.new_order.user_id;
-                o.instrument_id = cm.new_order.instrument_id;
+                o.instrument_id = instrument_id;
                 o.side      = (cm.new_order.side == 0 ? Side::Buy : Side::Sell);
                 o.price     = cm.new_order.price;
                 o.quantity  = cm.new_order.quantity;
                 o.remaining = o.quantity;
                 o.ts_ns = 0;
 
-                uint64_t assigned_id = book_.submit_limit_order(o, trades);
+                uint64_t assigned_id = book.submit_limit_order(o, trades);
 
-                // Map resting order id -> user_id (for attribution)
+                // Map resting order id -> instrument (for cancel/amend routing)
                 if (assigned_id != 0) {
-                    order_user_[assigned_id] = cm.new_order.user_id;
+                    order_instrument_[assigned_id] = instrument_id;
                 }
 
                 // ----- PnL attribution for trades -----
-                for (const auto& tr : trades) {
-                    // Determine per-trade attribution: whether tracked UI user and/or BS bot acted as buyer/seller.
-                    bool user_is_buy  = false;
-                    bool user_is_sell = false;
-
-                    bool bot_is_buy   = false;
-                    bool bot_is_sell  = false;
-
-                    // Incoming order side for UI-tracked user
-                    if (cm.new_order.user_id == tracked_user_id_) {
-                        if (cm.new_order.side == 0) user_is_buy  = true;
-                        else                        user_is_sell = true;
-                    }
-                    // Incoming side for BS bot
-                    if (cm.new_order.user_id == BS_BOT_USER_ID) {
-                        if (cm.new_order.side == 0) bot_is_buy  = true;
-                        else                        bot_is_sell = true;
-                    }
-
-                    // Resting side (look up via order_user_ map)
-                    auto itB = order_user_.find(tr.buy_order_id);
-                    if (itB != order_user_.end()) {
-                        if (itB->second == tracked_user_id_) {
-                            user_is_buy = true;
-                            user_is_sell = false;
-                        }
-                        if (itB->second == BS_BOT_USER_ID) {
-                            bot_is_buy = true;
-                            bot_is_sell = false;
-                        }
-                    }
-
-                    auto itS = order_user_.find(tr.sell_order_id);
-                    if (itS != order_user_.end()) {
-                        if (itS->second == tracked_user_id_) {
-                            user_is_sell = true;
-                            user_is_buy  = false;
-                        }
-                        if (itS->second == BS_BOT_USER_ID) {
-                            bot_is_sell = true;
-                            bot_is_buy  = false;
-                        }
-                    }
-
-                    // --- PnL for UI user (e.g. user_id = 1) ---
-                    if (user_is_buy || user_is_sell) {
-                        pnl_.on_trade(user_is_buy, tr.price, tr.quantity);
-                        PnLUpdate pu = pnl_.get();
-                        pu.user_id = static_cast<uint32_t>(tracked_user_id_);
-
-                        ServerMessage sm_p{};
-                        sm_p.type = PNL_UPDATE;
-                        sm_p.pnl  = pu;
-                        out_queue_.push(sm_p);
-                    }
-
-                    // --- PnL for BS bot (user_id = 9999) ---
-                    if (bot_is_buy || bot_is_sell) {
-                        bs_pnl_.on_trade(bot_is_buy, tr.price, tr.quantity);
-                        PnLUpdate pu_b = bs_pnl_.get();
-                        pu_b.user_id = static_cast<uint32_t>(BS_BOT_USER_ID);
-
-                        ServerMessage sm_p{};
-                        sm_p.type = PNL_UPDATE;
-                        sm_p.pnl  = pu_b;
-                        out_queue_.push(sm_p);
-                    }
+                // Both counterparties are on the trade; fully filled resting orders leave the index.
+                for (auto& tr : trades) {
+                    tr.trade_id = next_trade_id_++;
+                    pnl_.on_trade(tr.buy_user_id,  instrument_id, true,  tr.price, tr.quantity);
+                    pnl_.on_trade(tr.sell_user_id, instrument_id, false, tr.price, tr.quantity);
+                    mark_pnl_dirty(tr.buy_user_id, instrument_id);
+                    mark_pnl_dirty(tr.sell_user_id, instrument_id);
+                    risk_.on_fill(tr.buy_user_id,  instrument_id,  double(tr.quantity));
+                    risk_.on_fill(tr.sell_user_id, instrument_id, -double(tr.quantity));
+
+                    uint64_t resting = (o.side == Side::Buy) ? tr.sell_order_id : tr.buy_order_id;
+                    if (!book.contains(resting)) order_instrument_.erase(resting);
+
+                    inst.analytics.on_trade(tr.price, tr.quantity, now_ns);
                 }
 
                 emit_trades(trades, out_queue_);
+                if (strategy_on) emit_trades(trades, strategy_queue_);
                 emit_ack(NEW_ORDER, assigned_id, true, out_queue_);
             } else if (cm.type == CANCEL) {
-                bool ok = book_.cancel_order(cm.cancel.order_id);
+                bool ok = book.cancel_order(cm.cancel.order_id);
                 if (ok) {
-                    order_user_.erase(cm.cancel.order_id);
+                    order_instrument_.erase(cm.cancel.order_id);
                 }
                 emit_ack(CANCEL, cm.cancel.order_id, ok, out_queue_);
+            } else if (cm.type == AMEND) {
+                bool ok = book.amend_order(cm.amend.order_id, cm.amend.quantity);
+                if (ok && cm.amend.quantity == 0) {
+                    order_instrument_.erase(cm.amend.order_id);
+                }
+                emit_ack(AMEND, cm.amend.order_id, ok, out_queue_);
             }
 
+            // L3 events go out before the derived TOB/depth messages for the same mutation.
+            if (!l3_events_.empty()) emit_l3_events(l3_events_, instrument_id, out_queue_);
+
             // ----- Top of book + PnL (midprice) -----
             // Emit TOB changes only when the top-of-book differs from last snapshot; mid price drives PnL.
-            TopOfBook tob = book_.top_of_book();
+            TopOfBook tob = book.top_of_book();
+            tob.instrument_id = instrument_id;
+            const TopOfBook& last_tob = inst.last_tob;
             bool tob_changed = false;
-            if (!have_last_tob) {
+            if (!inst.have_last_tob) {
                 tob_changed = true;
-                have_last_tob = true;
+                inst.have_last_tob = true;
             } else {
                 if (tob.has_bid != last_tob.has_bid ||
                     tob.has_ask != last_tob.has_ask ||
@@ -220,14 +468,17 @@ void MatchingServer::engine_loop() {
             }
 
             if (tob_changed) {
-                last_tob = tob;
+                inst.last_tob = tob;
                 ServerMessage sm{};
                 sm.type          = TOB;
+                sm.tob = TopOfBook{};
+                sm.tob.instrument_id = instrument_id;
                 sm.tob.bid_price = tob.has_bid ? tob.bid_price : 0.0;
                 sm.tob.bid_quantity   = tob.has_bid ? tob.bid_quantity : 0;
                 sm.tob.ask_price = tob.has_ask ? tob.ask_price : 0.0;
                 sm.tob.ask_quantity   = tob.has_ask ? tob.ask_quantity : 0;
                 out_queue_.push(sm);
+                if (strategy_on) strategy_queue_.push(sm);
 
                 // Midprice for PnL
                 double mid = 0.0;
@@ -239,63 +490,19 @@ void MatchingServer::engine_loop() {
                     mid = tob.ask_price;
                 }
 
+                // Re-mark only the holders of this instrument.
                 if (mid > 0.0) {
-                    // UI user
-                    pnl_.on_midprice(mid);
-                    PnLUpdate pu = pnl_.get();
-                    pu.user_id = static_cast<uint32_t>(tracked_user_id_);
-
-                    ServerMessage sm_p{};
-                    sm_p.type = PNL_UPDATE;
-                    sm_p.pnl  = pu;
-                    out_queue_.push(sm_p);
-
-                    // BS bot
-                    bs_pnl_.on_midprice(mid);
-                    PnLUpdate pu_b = bs_pnl_.get();
-                    pu_b.user_id = static_cast<uint32_t>(BS_BOT_USER_ID);
-
-                    ServerMessage sm_pb{};
-                    sm_pb.type = PNL_UPDATE;
-                    sm_pb.pnl  = pu_b;
-                    out_queue_.push(sm_pb);
+                    risk_.on_mark(instrument_id, mid);
+                    touched_users_.clear();
+                    pnl_.on_mark(instrument_id, mid, &touched_users_);
+                    for (uint64_t uid : touched_users_) mark_pnl_dirty(uid, instrument_id);
                 }
             }
 
             // ----- L2 diffs (for order book) -----
-            auto new_bids = book_.snapshot_bids();
-            auto new_asks = book_.snapshot_asks();
-
-            // Compute per-price quantity diffs between snapshots and emit L2_UPDATE frames per change.
-            auto diff_side = [&](const std::vector<std::pair<double,uint64_t>>& before,
-                                 const std::vector<std::pair<double,uint64_t>>& after,
-                                 uint8_t side_flag) {
-                std::unordered_map<double,uint64_t> prev_map;
-                for (auto& p : before) prev_map[p.first] = p.second;
-                std::unordered_map<double,uint64_t> new_map;
-                for (auto& p : after) new_map[p.first] = p.second;
-
-                std::unordered_map<double,bool> seen;
-                for (auto& kv : prev_map) seen[kv.first] = true;
-                for (auto& kv : new_map)  seen[kv.first] = true;
-
-                for (auto& kv : seen) {
-                    double price   = kv.first;
-                    uint64_t old_q = prev_map.count(price) ? prev_map[price] : 0;
-                    uint64_t new_q = new_map.count(price) ? new_map[price] : 0;
-                    if (old_q != new_q) {
-                        ServerMessage sm{};
-                        sm.type = L2_UPDATE;
-                        sm.l2.side = side_flag;
-                        sm.l2.price = price;
-                        sm.l2.quantity = new_q;
-                        out_queue_.push(sm);
-                    }
-                }
-            };
-
-            diff_side(prev_bids, new_bids, 0);
-            diff_side(prev_asks, new_asks, 1);
+            // One DEPTH_UPDATE per side carries every level changed by this message.
+            emit_depth_diff(prev_bids, book.snapshot_bids(), instrument_id, 0, out_queue_);
+            emit_depth_diff(prev_asks, book.snapshot_asks(), instrument_id, 1, out_queue_);
         }
 
         // Backoff briefly if no work was processed to avoid busy spinning.
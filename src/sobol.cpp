@@ -0,0 +1,144 @@
+#include "quant/sobol.hpp"
+#include "quant/bs.hpp"
+#include <algorithm>
+
+namespace quant {
+    // Joe & Kuo primitive polynomials and initial direction numbers for Sobol
+    // dimensions 2..SOBOL_MAX_DIM: degree s, coefficients a, m_1..m_s.
+    struct SobolInit {
+        uint32_t s;
+        uint32_t a;
+        uint32_t m[8];
+    };
+
+    static const SobolInit SOBOL_INIT[SobolSequence::SOBOL_MAX_DIM - 1] = {
+        {1, 0, {1}},
+        {2, 1, {1, 3}},
+        {3, 1, {1, 3, 1}},
+        {3, 2, {1, 1, 1}},
+        {4, 1, {1, 1, 3, 3}},
+        {4, 4, {1, 3, 5, 13}},
+        {5, 2, {1, 1, 5, 5, 17}},
+        {5, 4, {1, 1, 5, 5, 5}},
+        {5, 7, {1, 1, 7, 11, 19}},
+        {5, 11, {1, 1, 5, 1, 1}},
+        {5, 13, {1, 1, 1, 3, 11}},
+        {5, 14, {1, 3, 5, 5, 31}},
+        {6, 1, {1, 3, 3, 9, 7, 49}},
+        {6, 13, {1, 1, 1, 15, 21, 21}},
+        {6, 16, {1, 3, 1, 13, 27, 49}},
+        {6, 19, {1, 1, 1, 15, 7, 5}},
+        {6, 22, {1, 3, 1, 15, 13, 25}},
+        {6, 25, {1, 1, 5, 5, 19, 61}},
+        {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+        {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+        {7, 7, {1, 1, 3, 13, 7, 35, 63}},
+        {7, 8, {1, 3, 5, 9, 1, 25, 53}},
+        {7, 14, {1, 3, 1, 13, 9, 35, 107}},
+        {7, 19, {1, 3, 1, 5, 27, 61, 31}},
+        {7, 21, {1, 1, 5, 11, 19, 41, 61}},
+        {7, 28, {1, 3, 5, 3, 3, 13, 69}},
+        {7, 31, {1, 1, 7, 13, 1, 19, 1}},
+        {7, 32, {1, 3, 7, 5, 13, 19, 59}},
+        {7, 37, {1, 1, 3, 9, 25, 29, 41}},
+        {7, 41, {1, 3, 5, 13, 23, 1, 55}},
+        {7, 42, {1, 3, 7, 3, 13, 59, 17}},
+    };
+
+    static constexpr uint32_t BITS = 32;
+
+    // Parity of the set bits of x.
+    static inline uint32_t parity(uint32_t x) {
+        return static_cast<uint32_t>(__builtin_parity(x));
+    }
+
+    SobolSequence::SobolSequence(uint32_t dims, uint64_t scramble_seed)
+        : dims_(dims), pad_(scramble_seed ^ 0x9E3779B97F4A7C15ull) {
+        const uint32_t n_sobol = std::min(dims, SOBOL_MAX_DIM);
+        v_.assign(static_cast<std::size_t>(n_sobol) * BITS, 0);
+        shift_.assign(n_sobol, 0);
+
+        for (uint32_t d = 0; d < n_sobol; ++d) {
+            uint32_t* v = &v_[static_cast<std::size_t>(d) * BITS];
+            if (d == 0) {
+                // first dimension: van der Corput in base 2
+                for (uint32_t k = 0; k < BITS; ++k) v[k] = 1u << (BITS - 1 - k);
+            } else {
+                const SobolInit& init = SOBOL_INIT[d - 1];
+                for (uint32_t k = 0; k < init.s; ++k) v[k] = init.m[k] << (BITS - 1 - k);
+                for (uint32_t k = init.s; k < BITS; ++k) {
+                    uint32_t x = v[k - init.s] ^ (v[k - init.s] >> init.s);
+                    for (uint32_t j = 1; j < init.s; ++j) {
+                        if ((init.a >> (init.s - 1 - j)) & 1u) x ^= v[k - j];
+                    }
+                    v[k] = x;
+                }
+            }
+            if (scramble_seed == 0) continue;
+
+            // Random lower-triangular matrix (unit diagonal) applied to every direction
+            // number, then a random digital shift. Row r (bit BITS-1-r) may only mix in
+            // more significant bits. Bits come from Philox keyed by the seed.
+            uint32_t rows[BITS];
+            for (uint32_t r = 0; r < BITS; ++r) {
+                Philox4x32 ctr{{d, r, 0x50B01u, 0}};
+                const uint32_t bits = philox4x32_10(ctr, static_cast<uint32_t>(scramble_seed),
+                                                    static_cast<uint32_t>(scramble_seed >> 32)).c[0];
+                const uint32_t diag = 1u << (BITS - 1 - r);
+                const uint32_t higher = r == 0 ? 0u : ~((diag << 1) - 1u);
+                rows[r] = diag | (bits & higher);
+            }
+            for (uint32_t k = 0; k < BITS; ++k) {
+                uint32_t y = 0;
+                for (uint32_t r = 0; r < BITS; ++r) y |= parity(rows[r] & v[k]) << (BITS - 1 - r);
+                v[k] = y;
+            }
+            Philox4x32 ctr{{d, BITS, 0x50B01u, 0}};
+            shift_[d] = philox4x32_10(ctr, static_cast<uint32_t>(scramble_seed),
+                                      static_cast<uint32_t>(scramble_seed >> 32)).c[0];
+        }
+    }
+
+    uint64_t SobolSequence::replicate_seed(uint64_t seed, uint64_t replicate) {
+        Philox4x32 ctr{{static_cast<uint32_t>(replicate), static_cast<uint32_t>(replicate >> 32),
+                        0x5EEDu, 0}};
+        Philox4x32 out = philox4x32_10(ctr, static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32));
+        return ((static_cast<uint64_t>(out.c[1]) << 32) | out.c[0]) | 1u;
+    }
+
+    uint32_t SobolSequence::coordinate(uint64_t index, uint32_t dim) const {
+        const uint32_t* v = &v_[static_cast<std::size_t>(dim) * BITS];
+        uint64_t gray = index ^ (index >> 1);
+        uint32_t x = shift_[dim];
+        for (uint32_t k = 0; gray != 0 && k < BITS; ++k, gray >>= 1) {
+            if (gray & 1u) x ^= v[k];
+        }
+        return x;
+    }
+
+    void SobolSequence::uniforms(uint64_t first, std::size_t n, uint32_t dim, double* out) const {
+        if (n == 0) return;
+        if (dim >= SOBOL_MAX_DIM) {
+            pad_.uniforms(first, n, dim, out);
+            return;
+        }
+        const uint32_t* v = &v_[static_cast<std::size_t>(dim) * BITS];
+        const double scale = 1.0 / 4294967296.0;
+        // Gray-code order: consecutive points differ by one direction number.
+        uint32_t x = coordinate(first, dim);
+        out[0] = (static_cast<double>(x) + 0.5) * scale;
+        for (std::size_t i = 1; i < n; ++i) {
+            x ^= v[__builtin_ctzll(first + i)];
+            out[i] = (static_cast<double>(x) + 0.5) * scale;
+        }
+    }
+
+    void SobolSequence::normals(uint64_t first, std::size_t n, uint32_t dim, double* out) const {
+        if (dim >= SOBOL_MAX_DIM) {
+            pad_.normals(first, n, dim, out);
+            return;
+        }
+        uniforms(first, n, dim, out);
+        for (std::size_t i = 0; i < n; ++i) out[i] = norm_inv_cdf(out[i]);
+    }
+}
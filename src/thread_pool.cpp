@@ -0,0 +1,231 @@
+#include "quant/thread_pool.hpp"
+#include <chrono>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace quant {
+
+namespace {
+    // Identifies pool workers so submissions from inside a task go to the local deque.
+    thread_local ThreadPool* tl_pool = nullptr;
+    thread_local std::size_t tl_index = 0;
+
+    std::mutex g_config_m;
+    std::size_t g_workers = 0;
+    bool g_pin = false;
+
+    std::size_t global_workers() {
+        std::lock_guard<std::mutex> lk(g_config_m);
+        return g_workers;
+    }
+
+    bool global_pin() {
+        std::lock_guard<std::mutex> lk(g_config_m);
+        return g_pin;
+    }
+
+    void pin_to_cpu(std::size_t cpu) {
+#if defined(__linux__)
+        const unsigned ncpu = std::thread::hardware_concurrency();
+        if (ncpu == 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % ncpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)cpu;
+#endif
+    }
+}
+
+// -----------------------------------------
+// ThreadPool
+// -----------------------------------------
+
+ThreadPool::ThreadPool(std::size_t n_workers, bool pin_cores) {
+    if (n_workers == 0) {
+        const unsigned hc = std::thread::hardware_concurrency();
+        n_workers = hc > 1 ? hc - 1 : 1;
+    }
+    queues_.reserve(n_workers);
+    for (std::size_t i = 0; i < n_workers; ++i) queues_.emplace_back(new WorkQueue());
+    workers_.reserve(n_workers);
+    for (std::size_t i = 0; i < n_workers; ++i) {
+        workers_.emplace_back([this, i, pin_cores]() {
+            if (pin_cores) pin_to_cpu(i + 1);
+            worker_loop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop_ = true;
+    {
+        std::lock_guard<std::mutex> lk(sleep_m_);
+    }
+    sleep_cv_.notify_all();
+    for (auto& th : workers_) {
+        if (th.joinable()) th.join();
+    }
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(global_workers(), global_pin());
+    return pool;
+}
+
+void ThreadPool::configure_global(std::size_t n_workers, bool pin_cores) {
+    std::lock_guard<std::mutex> lk(g_config_m);
+    g_workers = n_workers;
+    g_pin = pin_cores;
+}
+
+void ThreadPool::submit(std::function<void()> fn, TaskGroup* group) {
+    if (group) group->pending_.fetch_add(1, std::memory_order_relaxed);
+
+    const std::size_t q = (tl_pool == this)
+        ? tl_index
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lk(queues_[q]->m);
+        queues_[q]->tasks.push_back(Task{std::move(fn), group});
+    }
+    queued_.fetch_add(1, std::memory_order_release);
+
+    // Taking sleep_m_ orders the increment against a worker's predicate check,
+    // so a worker about to sleep cannot miss this task.
+    {
+        std::lock_guard<std::mutex> lk(sleep_m_);
+    }
+    sleep_cv_.notify_one();
+}
+
+bool ThreadPool::pop_local(std::size_t index, Task& out) {
+    WorkQueue& wq = *queues_[index];
+    std::lock_guard<std::mutex> lk(wq.m);
+    if (wq.tasks.empty()) return false;
+    out = std::move(wq.tasks.back());
+    wq.tasks.pop_back();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::steal(std::size_t thief, Task& out) {
+    const std::size_t n = queues_.size();
+    for (std::size_t k = 1; k <= n; ++k) {
+        WorkQueue& wq = *queues_[(thief + k) % n];
+        std::lock_guard<std::mutex> lk(wq.m);
+        if (wq.tasks.empty()) continue;
+        out = std::move(wq.tasks.front());
+        wq.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(Task& task) {
+    std::exception_ptr err;
+    try {
+        task.fn();
+    } catch (...) {
+        err = std::current_exception();
+    }
+    // fire-and-forget tasks have nowhere to report errors; they are dropped
+    if (task.group) task.group->finish(err);
+}
+
+bool ThreadPool::try_run_one() {
+    Task task;
+    bool got = false;
+    if (tl_pool == this) {
+        got = pop_local(tl_index, task) || steal(tl_index, task);
+    } else {
+        got = steal(next_queue_.load(std::memory_order_relaxed), task);
+    }
+    if (got) run(task);
+    return got;
+}
+
+void ThreadPool::worker_loop(std::size_t index) {
+    tl_pool = this;
+    tl_index = index;
+    while (!stop_.load(std::memory_order_acquire)) {
+        Task task;
+        if (pop_local(index, task) || steal(index, task)) {
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(sleep_m_);
+        sleep_cv_.wait(lk, [this]() {
+            return stop_.load(std::memory_order_acquire) ||
+                   queued_.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+// -----------------------------------------
+// TaskGroup
+// -----------------------------------------
+
+TaskGroup::TaskGroup(ThreadPool& pool) : pool_(pool) {}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // errors are reported by an explicit wait(); destruction only joins
+    }
+}
+
+void TaskGroup::run(std::function<void()> fn) {
+    pool_.submit(std::move(fn), this);
+}
+
+void TaskGroup::finish(std::exception_ptr err) {
+    // The decrement happens under m_ so wait() cannot return (and the group be
+    // destroyed) until this call has released the lock.
+    std::lock_guard<std::mutex> lk(m_);
+    if (err && !error_) error_ = err;
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) done_cv_.notify_all();
+}
+
+void TaskGroup::wait() {
+    while (pending_.load(std::memory_order_acquire) > 0) {
+        // help: run any queued task (ours or not) rather than block
+        if (pool_.try_run_one()) continue;
+        std::unique_lock<std::mutex> lk(m_);
+        done_cv_.wait_for(lk, std::chrono::microseconds(50), [this]() {
+            return pending_.load(std::memory_order_acquire) == 0;
+        });
+    }
+    std::lock_guard<std::mutex> lk(m_);
+    if (error_) {
+        std::exception_ptr err = error_;
+        error_ = nullptr;
+        std::rethrow_exception(err);
+    }
+}
+
+// -----------------------------------------
+// parallel_for
+// -----------------------------------------
+
+void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn, ThreadPool& pool) {
+    if (n == 0) return;
+    if (n == 1 || pool.size() == 0) {
+        for (std::size_t i = 0; i < n; ++i) fn(i);
+        return;
+    }
+    TaskGroup group(pool);
+    for (std::size_t i = 1; i < n; ++i) {
+        group.run([&fn, i]() { fn(i); });
+    }
+    fn(0);
+    group.wait();
+}
+
+} // namespace quant
@@ -0,0 +1,213 @@
+#include "quant/wire_codec.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace quant {
+
+// Big-endian append helpers.
+static void append_u16(std::vector<uint8_t>& buf, uint16_t v) {
+    buf.push_back((v >> 8) & 0xFF);
+    buf.push_back(v & 0xFF);
+}
+
+static void append_u32(std::vector<uint8_t>& buf, uint32_t v) {
+    for (int i = 3; i >= 0; --i) buf.push_back((v >> (i*8)) & 0xFF);
+}
+
+static void append_u64(std::vector<uint8_t>& buf, uint64_t v) {
+    for (int i = 7; i >= 0; --i) buf.push_back((v >> (i*8)) & 0xFF);
+}
+
+// Unsigned LEB128: 7 bits per byte, high bit set on all but the last byte.
+static void append_varint(std::vector<uint8_t>& buf, uint64_t v) {
+    while (v >= 0x80) {
+        buf.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    buf.push_back(static_cast<uint8_t>(v));
+}
+
+static void append_double(std::vector<uint8_t>& buf, double x) {
+    uint64_t v;
+    std::memcpy(&v, &x, sizeof(v));
+    append_u64(buf, v);
+}
+
+void encode_server_message(const ServerMessage& m, std::vector<uint8_t>& out) {
+    out.clear();
+    // length placeholder, patched once the payload size is known
+    out.resize(4);
+    out.push_back(static_cast<uint8_t>(m.type));
+
+    if (m.type == TRADE) {
+        append_u64(out, m.trade.trade_id);
+        append_u64(out, m.trade.buy_order_id);
+        append_u64(out, m.trade.buy_user_id);
+        append_u64(out, m.trade.sell_order_id);
+        append_u64(out, m.trade.sell_user_id);
+        append_double(out, m.trade.price);
+        append_u64(out, m.trade.quantity);
+        append_u32(out, static_cast<uint32_t>(m.trade.instrument_id));
+    } else if (m.type == ACK) {
+        out.push_back(m.ack.status);
+        out.push_back(m.ack.type);
+        append_u64(out, m.ack.order_id);
+    } else if (m.type == TOB) {
+        append_double(out, m.tob.bid_price);
+        append_u64(out, m.tob.bid_quantity);
+        append_double(out, m.tob.ask_price);
+        append_u64(out, m.tob.ask_quantity);
+        append_u32(out, m.tob.instrument_id);
+    } else if (m.type == L2_UPDATE) {
+        out.push_back(m.l2.side);
+        append_double(out, m.l2.price);
+        append_u64(out, m.l2.quantity);
+    } else if (m.type == PNL_UPDATE) {
+        append_u32(out, m.pnl.user_id);
+        append_double(out, m.pnl.realized);
+        append_double(out, m.pnl.unrealized);
+        append_double(out, m.pnl.position);
+        append_double(out, m.pnl.avg_price);
+        append_double(out, m.pnl.equity);
+        append_u32(out, m.pnl.instrument_id);
+    } else if (m.type == DEPTH_UPDATE) {
+        // [instrument u32][side u8][flags u8][count u16][count x (price f64, qty u64)]
+        const DepthUpdate& d = m.depth;
+        append_u32(out, d.instrument_id);
+        out.push_back(d.side);
+        out.push_back(d.is_snapshot ? 1 : 0);
+        append_u16(out, d.count);
+        for (uint8_t i = 0; i < d.count; ++i) {
+            append_double(out, d.levels[i].price);
+            append_u64(out, d.levels[i].quantity);
+        }
+    } else if (m.type == L3_EVENT) {
+        // compact: [event u8][side u8][varint seq][varint instrument][varint order_id]
+        //          [price f64][varint qty] -- typically ~20 bytes
+        const L3Event& e = m.l3;
+        out.push_back(static_cast<uint8_t>(e.type));
+        out.push_back(e.side);
+        append_varint(out, e.seq);
+        append_varint(out, e.instrument_id);
+        append_varint(out, e.order_id);
+        append_double(out, e.price);
+        append_varint(out, e.quantity);
+    } else if (m.type == BAR) {
+        const BarUpdate& b = m.bar;
+        append_u32(out, b.instrument_id);
+        append_u32(out, b.interval_ms);
+        append_u64(out, b.start_ms);
+        append_double(out, b.open);
+        append_double(out, b.high);
+        append_double(out, b.low);
+        append_double(out, b.close);
+        append_u64(out, b.volume);
+        append_u32(out, b.trade_count);
+        append_double(out, b.vwap);
+        append_double(out, b.rolling_vwap);
+        append_double(out, b.realized_vol);
+    } else if (m.type == RISK_UPDATE) {
+        const RiskUpdate& r = m.risk;
+        append_u32(out, r.user_id);
+        append_u32(out, r.underlying_id);
+        append_double(out, r.underlying_mid);
+        append_double(out, r.delta);
+        append_double(out, r.gamma);
+        append_double(out, r.vega);
+        append_double(out, r.theta);
+    }
+
+    uint32_t len = static_cast<uint32_t>(out.size() - 4);
+    out[0] = (len >> 24) & 0xFF;
+    out[1] = (len >> 16) & 0xFF;
+    out[2] = (len >> 8) & 0xFF;
+    out[3] = len & 0xFF;
+}
+
+// Patch the 4-byte big-endian length prefix of a finished frame.
+static void patch_frame_length(std::vector<uint8_t>& out) {
+    uint32_t len = static_cast<uint32_t>(out.size() - 4);
+    out[0] = (len >> 24) & 0xFF;
+    out[1] = (len >> 16) & 0xFF;
+    out[2] = (len >> 8) & 0xFF;
+    out[3] = len & 0xFF;
+}
+
+void encode_pnl_history(uint32_t user_id, uint32_t instrument_id, uint8_t tier, uint32_t bucket_ms,
+                        const std::vector<PnLSample>& samples,
+                        std::vector<std::vector<uint8_t>>& frames) {
+    std::size_t first = 0;
+    do {
+        const std::size_t n = std::min(REPLY_CHUNK_ITEMS, samples.size() - first);
+        std::vector<uint8_t> out;
+        out.reserve(4 + 1 + 18 + n * 48);
+        out.resize(4);
+        out.push_back(static_cast<uint8_t>(PNL_HISTORY));
+        append_u32(out, user_id);
+        append_u32(out, instrument_id);
+        out.push_back(tier);
+        append_u32(out, bucket_ms);
+        out.push_back(first + n < samples.size() ? 1 : 0);
+        append_u32(out, static_cast<uint32_t>(n));
+        for (std::size_t i = first; i < first + n; ++i) {
+            const PnLSample& s = samples[i];
+            append_u64(out, s.ts_ms);
+            append_double(out, s.equity_min);
+            append_double(out, s.equity_max);
+            append_double(out, s.equity);
+            append_double(out, s.realized);
+            append_double(out, s.position);
+        }
+        patch_frame_length(out);
+        frames.push_back(std::move(out));
+        first += n;
+    } while (first < samples.size());
+}
+
+void encode_lots(uint32_t user_id, uint32_t instrument_id, const std::vector<LotInfo>& open,
+                 const std::vector<LotInfo>& closed, std::vector<std::vector<uint8_t>>& frames) {
+    // open lots fill the first frames, closed lots the rest
+    const std::size_t total = open.size() + closed.size();
+    std::size_t first = 0;
+    do {
+        const std::size_t n = std::min(REPLY_CHUNK_ITEMS, total - first);
+        const std::size_t n_open = first < open.size() ? std::min(n, open.size() - first) : 0;
+        const std::size_t n_closed = n - n_open;
+        const std::size_t closed_begin = first > open.size() ? first - open.size() : 0;
+        std::vector<uint8_t> out;
+        out.reserve(4 + 1 + 17 + n * 40);
+        out.resize(4);
+        out.push_back(static_cast<uint8_t>(LOTS));
+        append_u32(out, user_id);
+        append_u32(out, instrument_id);
+        out.push_back(first + n < total ? 1 : 0);
+        append_u32(out, static_cast<uint32_t>(n_open));
+        for (std::size_t i = first; i < first + n_open; ++i) {
+            const LotInfo& l = open[i];
+            append_double(out, l.quantity);
+            append_double(out, l.price);
+            append_double(out, l.realized);
+            append_u64(out, l.trade_seq);
+        }
+        append_u32(out, static_cast<uint32_t>(n_closed));
+        for (std::size_t i = closed_begin; i < closed_begin + n_closed; ++i) {
+            const LotInfo& l = closed[i];
+            append_double(out, l.quantity);
+            append_double(out, l.price);
+            append_double(out, l.realized);
+            append_u64(out, l.trade_seq);
+            append_u64(out, l.close_seq);
+        }
+        patch_frame_length(out);
+        frames.push_back(std::move(out));
+        first += n;
+    } while (first < total);
+}
+
+std::vector<uint8_t> pack_server_message(const ServerMessage& m) {
+    std::vector<uint8_t> framed;
+    encode_server_message(m, framed);
+    return framed;
+}
+
+} // namespace quant
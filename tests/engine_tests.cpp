@@ -0,0 +1,299 @@
+// Engine checks: FIFO lot accounting, PnL history tiers, order-book amends and the L3
+// event journal, and the engine's DEPTH_UPDATE diffs. Exits non-zero if any check fails.
+#include "quant/order_book.hpp"
+#include "quant/pnl.hpp"
+#include "quant/pnl_history.hpp"
+#include "quant/server.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace quant;
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                                   \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            ++g_failures;                                                  \
+            std::printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+            std::printf(__VA_ARGS__);                                      \
+            std::printf("\n");                                             \
+        }                                                                  \
+    } while (0)
+
+static bool near(double a, double b) { return std::fabs(a - b) < 1e-9; }
+
+static bool same_lot(const LotInfo& l, double qty, double price, double realized, uint64_t open_seq,
+                     uint64_t close_seq) {
+    return near(l.quantity, qty) && near(l.price, price) && near(l.realized, realized) &&
+           l.trade_seq == open_seq && l.close_seq == close_seq;
+}
+
+// Partial closes across lots, per-lot realized PnL, a long -> short flip and a flat close.
+static void test_fifo_lots() {
+    PnLEngine pnl(CostBasis::FIFO);
+    const uint64_t u = 7;
+    const uint32_t inst = 1;
+    pnl.on_trade(u, inst, true, 100.0, 10);    // fill 1: lot A 10 @ 100
+    pnl.on_trade(u, inst, true, 102.0, 5);     // fill 2: lot B 5 @ 102
+    pnl.on_mark(inst, 104.0);
+    PnLUpdate p = pnl.get(u, inst);
+    CHECK(near(p.position, 15) && near(p.unrealized, 50) && near(p.avg_price, 1510.0 / 15),
+          "two lots: pos %g unreal %g avg %g", p.position, p.unrealized, p.avg_price);
+
+    pnl.on_trade(u, inst, false, 105.0, 12);   // fill 3: closes A (+50), 2 of B (+6)
+    p = pnl.get(u, inst);
+    CHECK(near(p.position, 3) && near(p.realized, 56) && near(p.avg_price, 102),
+          "partial close: pos %g real %g avg %g", p.position, p.realized, p.avg_price);
+    std::vector<LotInfo> open, closed;
+    pnl.open_lots(u, inst, open);
+    pnl.closed_lots(u, inst, closed);
+    CHECK(open.size() == 1 && same_lot(open[0], 3, 102, 6, 2, 0), "open after partial close: %zu lots",
+          open.size());
+    CHECK(closed.size() == 1 && same_lot(closed[0], 10, 100, 50, 1, 3), "closed after partial close: %zu lots",
+          closed.size());
+
+    pnl.on_trade(u, inst, false, 101.0, 8);    // fill 4: closes B (-3), opens short C 5 @ 101
+    p = pnl.get(u, inst);
+    CHECK(near(p.position, -5) && near(p.realized, 53) && near(p.avg_price, 101),
+          "flip: pos %g real %g avg %g", p.position, p.realized, p.avg_price);
+    open.clear();
+    closed.clear();
+    pnl.open_lots(u, inst, open);
+    pnl.closed_lots(u, inst, closed);
+    CHECK(open.size() == 1 && same_lot(open[0], 5, 101, 0, 4, 0), "open after flip: %zu lots", open.size());
+    CHECK(closed.size() == 2 && same_lot(closed[1], 5, 102, 3, 2, 4), "closed after flip: %zu lots",
+          closed.size());
+
+    pnl.on_trade(u, inst, true, 99.0, 5);      // fill 5: covers C (+10)
+    p = pnl.get(u, inst);
+    CHECK(near(p.position, 0) && near(p.realized, 63) && near(p.avg_price, 0) && near(p.unrealized, 0),
+          "flat: pos %g real %g avg %g unreal %g", p.position, p.realized, p.avg_price, p.unrealized);
+    CHECK(near(pnl.get_total(u).realized, 63), "total realized %g", pnl.get_total(u).realized);
+
+    // Average cost ignores lots.
+    PnLEngine avg(CostBasis::AverageCost);
+    avg.on_trade(u, inst, true, 100.0, 10);
+    open.clear();
+    avg.open_lots(u, inst, open);
+    CHECK(open.empty(), "average cost reports %zu lots", open.size());
+}
+
+// LotPool growth past its initial capacity and the closed-lot ring wrapping.
+static void test_lot_pool_and_ring() {
+    PnLEngine pnl(CostBasis::FIFO, /*lot_capacity*/ 2, /*closed_lot_capacity*/ 4);
+    for (int i = 0; i < 6; ++i) pnl.on_trade(1, 1, true, 100.0 + i, 1);
+    std::vector<LotInfo> open;
+    pnl.open_lots(1, 1, open);
+    bool in_order = open.size() == 6;
+    for (std::size_t i = 0; in_order && i < open.size(); ++i)
+        in_order = same_lot(open[i], 1, 100.0 + i, 0, i + 1, 0);
+    CHECK(in_order, "grown pool: %zu open lots", open.size());
+
+    pnl.on_trade(1, 1, false, 110.0, 6);       // closes all six; the ring keeps the last 4
+    std::vector<LotInfo> closed;
+    pnl.closed_lots(1, 1, closed);
+    bool last_four = closed.size() == 4;
+    for (std::size_t i = 0; last_four && i < closed.size(); ++i)
+        last_four = same_lot(closed[i], 1, 102.0 + i, 8.0 - i, i + 3, 7);
+    CHECK(last_four, "ring after wrap: %zu closed lots", closed.size());
+
+    // Another user's close evicts the oldest entry from the shared ring.
+    pnl.on_trade(2, 1, true, 50.0, 1);
+    pnl.on_trade(2, 1, false, 51.0, 1);
+    closed.clear();
+    pnl.closed_lots(1, 1, closed);
+    CHECK(closed.size() == 3 && near(closed[0].price, 103.0), "ring shared across users: %zu lots",
+          closed.size());
+    closed.clear();
+    pnl.closed_lots(2, 1, closed);
+    CHECK(closed.size() == 1 && near(closed[0].realized, 1.0), "second user: %zu lots", closed.size());
+}
+
+static PnLUpdate equity_update(double equity) {
+    PnLUpdate u{};
+    u.user_id = 1;
+    u.instrument_id = ALL_INSTRUMENTS;
+    u.equity = equity;
+    u.realized = equity / 2;
+    return u;
+}
+
+// Raw window trimming, since_ms, min/max/last buckets and skipping of stale laps.
+static void test_pnl_history() {
+    // raw: 5 s at 2 Hz => 11 slots; 1 s buckets x 3; 1 min buckets x 2
+    PnLHistory h({{0, 0}, {1000, 3}, {60000, 2}}, 5000, 2.0);
+    for (uint64_t t = 10000; t < 20000; t += 500) h.record(equity_update(double(t) / 100.0), t);
+
+    std::vector<PnLSample> out;
+    CHECK(h.query(1, ALL_INSTRUMENTS, 0, 0, out), "raw tier exists");
+    CHECK(out.size() == 11 && out.front().ts_ms == 14500 && out.back().ts_ms == 19500 &&
+              near(out.back().equity, 195.0) && near(out.back().realized, 97.5),
+          "raw window: %zu samples", out.size());
+    out.clear();
+    h.query(1, ALL_INSTRUMENTS, 0, 18000, out);
+    CHECK(out.size() == 4 && out.front().ts_ms == 18000, "raw since: %zu samples", out.size());
+
+    out.clear();
+    h.query(1, ALL_INSTRUMENTS, 1, 0, out);
+    bool buckets = out.size() == 3;
+    for (std::size_t i = 0; buckets && i < out.size(); ++i) {
+        const uint64_t start = 17000 + 1000 * i;
+        buckets = out[i].ts_ms == start && near(out[i].equity_min, start / 100.0) &&
+                  near(out[i].equity_max, (start + 500) / 100.0) && near(out[i].equity, (start + 500) / 100.0);
+    }
+    CHECK(buckets, "1 s buckets: %zu", out.size());
+
+    out.clear();
+    h.query(1, ALL_INSTRUMENTS, 2, 0, out);
+    CHECK(out.size() == 1 && out[0].ts_ms == 0 && near(out[0].equity_min, 100.0) &&
+              near(out[0].equity_max, 195.0),
+          "1 min bucket: %zu", out.size());
+
+    // After a gap the ring's older slots hold buckets from a previous lap: not reported.
+    h.record(equity_update(50.0), 25200);
+    out.clear();
+    h.query(1, ALL_INSTRUMENTS, 1, 0, out);
+    CHECK(out.size() == 1 && out[0].ts_ms == 25000 && near(out[0].equity_min, 50.0),
+          "bucket after gap: %zu", out.size());
+
+    out.clear();
+    CHECK(!h.query(1, ALL_INSTRUMENTS, 3, 0, out), "unknown tier accepted");
+    CHECK(h.query(2, ALL_INSTRUMENTS, 0, 0, out) && out.empty(), "unknown series: %zu", out.size());
+}
+
+static Order limit(uint64_t id, Side side, double price, uint64_t qty) {
+    Order o{};
+    o.order_id = id;
+    o.user_id = 1;
+    o.side = side;
+    o.price = price;
+    o.quantity = qty;
+    o.remaining = qty;
+    o.instrument_id = 1;
+    return o;
+}
+
+// Amend priority rules and the L3 journal: contiguous seq, one event per mutation.
+static void test_amend_and_events() {
+    OrderBook book("T", 64);
+    std::vector<L3Event> ev;
+    book.set_event_sink(&ev);
+    std::vector<Trade> trades;
+    book.submit_limit_order(limit(1, Side::Buy, 100.0, 10), trades);
+    book.submit_limit_order(limit(2, Side::Buy, 100.0, 5), trades);
+    book.submit_limit_order(limit(3, Side::Buy, 100.0, 5), trades);
+
+    CHECK(book.amend_order(1, 4), "amend down");       // keeps its place at the front
+    CHECK(book.amend_order(2, 8), "amend up");         // goes behind order 3
+    CHECK(!book.amend_order(99, 1), "amend of unknown order");
+
+    book.submit_limit_order(limit(4, Side::Sell, 100.0, 6), trades);
+    CHECK(trades.size() == 2 && trades[0].buy_order_id == 1 && trades[0].quantity == 4 &&
+              trades[1].buy_order_id == 3 && trades[1].quantity == 2,
+          "fills after amends: %zu trades", trades.size());
+
+    const L3EventType expect[] = {L3EventType::Add, L3EventType::Add, L3EventType::Add,
+                                  L3EventType::Amend, L3EventType::Amend, L3EventType::Execute,
+                                  L3EventType::Execute};
+    const uint64_t expect_id[] = {1, 2, 3, 1, 2, 1, 3};
+    const uint64_t expect_qty[] = {10, 5, 5, 4, 8, 4, 2};
+    bool journal = ev.size() == 7;
+    for (std::size_t i = 0; journal && i < ev.size(); ++i) {
+        journal = ev[i].seq == i + 1 && ev[i].type == expect[i] && ev[i].order_id == expect_id[i] &&
+                  ev[i].quantity == expect_qty[i] && ev[i].side == 0 && ev[i].price == 100.0;
+    }
+    CHECK(journal, "event journal: %zu events", ev.size());
+
+    ev.clear();
+    CHECK(book.amend_order(3, 0) && !book.contains(3), "amend to 0 cancels");
+    CHECK(ev.size() == 1 && ev[0].type == L3EventType::Cancel && ev[0].seq == 8, "cancel event seq %llu",
+          ev.empty() ? 0ULL : static_cast<unsigned long long>(ev[0].seq));
+
+    std::vector<L3Event> snap;
+    book.snapshot_orders(snap);
+    CHECK(snap.size() == 2 && snap[0].type == L3EventType::Reset && snap[1].order_id == 2 &&
+              snap[1].quantity == 8,
+          "snapshot: %zu events", snap.size());
+    CHECK(ev.size() == 1, "snapshot leaked into the sink");
+}
+
+// Pop DEPTH_UPDATE messages until `want` arrive or ~1 s passes.
+static std::vector<DepthUpdate> drain_depth(MatchingServer& engine, std::size_t want) {
+    std::vector<DepthUpdate> out;
+    for (int spins = 0; spins < 1000 && out.size() < want; ++spins) {
+        ServerMessage sm;
+        while (engine.get_next_server_message(sm)) {
+            if (sm.type == DEPTH_UPDATE) out.push_back(sm.depth);
+        }
+        if (out.size() < want) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return out;
+}
+
+static MsgNewOrder new_order(uint8_t side, double price, uint64_t qty) {
+    MsgNewOrder m{};
+    m.user_id = 1;
+    m.side = side;
+    m.price = price;
+    m.quantity = qty;
+    m.instrument_id = DEFAULT_INSTRUMENT_ID;
+    return m;
+}
+
+// The engine publishes only changed levels per side, with 0 for removed levels.
+static void test_depth_diff() {
+    MatchingServer engine;
+    engine.start();
+
+    engine.submit_new_order(new_order(0, 99.0, 10));
+    engine.submit_new_order(new_order(0, 98.0, 5));
+    std::vector<DepthUpdate> d = drain_depth(engine, 2);
+    CHECK(d.size() == 2 && d[0].side == 0 && d[0].count == 1 && d[0].levels[0].price == 99.0 &&
+              d[0].levels[0].quantity == 10 && d[1].levels[0].price == 98.0 && !d[0].is_snapshot,
+          "adds: %zu updates", d.size());
+
+    // partial fill of the best bid: one level changes, nothing on the ask side
+    engine.submit_new_order(new_order(1, 99.0, 4));
+    d = drain_depth(engine, 1);
+    CHECK(d.size() == 1 && d[0].side == 0 && d[0].count == 1 && d[0].levels[0].price == 99.0 &&
+              d[0].levels[0].quantity == 6,
+          "partial fill: %zu updates", d.size());
+
+    // sweep both bids and rest the remainder as an ask
+    engine.submit_new_order(new_order(1, 98.0, 13));
+    d = drain_depth(engine, 2);
+    bool sweep = d.size() == 2 && d[0].side == 0 && d[0].count == 2 && d[0].levels[0].price == 99.0 &&
+                 d[0].levels[0].quantity == 0 && d[0].levels[1].price == 98.0 &&
+                 d[0].levels[1].quantity == 0 && d[1].side == 1 && d[1].count == 1 &&
+                 d[1].levels[0].price == 98.0 && d[1].levels[0].quantity == 2;
+    CHECK(sweep, "sweep: %zu updates", d.size());
+
+    // an order for an unregistered instrument changes nothing
+    MsgNewOrder other = new_order(0, 97.0, 1);
+    other.instrument_id = 4242;
+    engine.submit_new_order(other);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    d = drain_depth(engine, 0);
+    CHECK(d.empty(), "unregistered instrument published %zu updates", d.size());
+
+    engine.stop();
+}
+
+int main() {
+    test_fifo_lots();
+    test_lot_pool_and_ring();
+    test_pnl_history();
+    test_amend_and_events();
+    test_depth_diff();
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all engine checks passed\n");
+    return 0;
+}
@@ -0,0 +1,301 @@
+// Multicast feed checks: a loopback subscriber that detects a dropped datagram and
+// rebuilds the book through MulticastPublisher::recover(), both from the MD_PACKET
+// replay and from the snapshot + SNAPSHOT_END path. Exits non-zero if any check fails.
+#include "quant/multicast_feed.hpp"
+#include "quant/wire_codec.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace quant;
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                                   \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            ++g_failures;                                                  \
+            std::printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+            std::printf(__VA_ARGS__);                                      \
+            std::printf("\n");                                             \
+        }                                                                  \
+    } while (0)
+
+static uint64_t get_be(const uint8_t* p, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+static double get_double(const uint8_t* p) {
+    uint64_t bits = get_be(p, 8);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+using Levels = std::map<double, uint64_t>;
+
+/**
+ * FeedSubscriber:
+ *  - Sample multicast receiver: applies DEPTH_UPDATE/TOB messages in sequence order
+ *  - On a gap it parks later datagrams and reports [gap_from, gap_to] for a
+ *    RETRANSMIT_REQUEST; recovery frames (MD_PACKET or snapshot + SNAPSHOT_END) are fed
+ *    to on_frame(), after which the parked datagrams are replayed
+ */
+struct FeedSubscriber {
+    uint64_t next_seq = 1;
+    bool gap = false;
+    uint64_t gap_from = 0, gap_to = 0;
+    std::vector<std::vector<uint8_t>> parked;
+
+    Levels levels[2];       // [0]=bids [1]=asks
+    TopOfBook tob;
+    bool have_tob = false;
+
+    // One datagram: [8-byte seq][2-byte count][framed msg]...
+    void on_datagram(const uint8_t* p, std::size_t n) {
+        if (n < 10) return;
+        const uint64_t first = get_be(p, 8);
+        const uint16_t count = static_cast<uint16_t>(get_be(p + 8, 2));
+        if (first > next_seq) {
+            if (!gap) {
+                gap = true;
+                gap_from = next_seq;
+                gap_to = first - 1;
+            }
+            parked.emplace_back(p, p + n);
+            return;
+        }
+        std::size_t off = 10;
+        for (uint16_t i = 0; i < count && off + 4 <= n; ++i) {
+            const std::size_t len = get_be(p + off, 4);
+            if (off + 4 + len > n) break;
+            // skip messages already applied (overlapping replay)
+            if (first + i >= next_seq) {
+                apply(p + off + 4, len);
+                next_seq = first + i + 1;
+            }
+            off += 4 + len;
+        }
+    }
+
+    // One TCP frame of a recovery reply (without the 4-byte length).
+    void on_frame(const uint8_t* p, std::size_t n) {
+        if (n == 0) return;
+        if (p[0] == MD_PACKET) {
+            on_datagram(p + 1, n - 1);
+        } else if (p[0] == SNAPSHOT_END && n >= 9) {
+            next_seq = get_be(p + 1, 8) + 1;
+        } else {
+            apply(p, n);
+        }
+    }
+
+    // Gap filled: replay parked datagrams (older ones are skipped by seq).
+    void resume() {
+        gap = false;
+        std::vector<std::vector<uint8_t>> later;
+        later.swap(parked);
+        for (const auto& d : later) on_datagram(d.data(), d.size());
+    }
+
+    void apply(const uint8_t* p, std::size_t n) {
+        if (p[0] == DEPTH_UPDATE && n >= 9) {
+            Levels& side = levels[p[5] & 1];
+            if (p[6]) side.clear();
+            const std::size_t count = get_be(p + 7, 2);
+            for (std::size_t i = 0; i < count && 9 + 16 * (i + 1) <= n; ++i) {
+                const double price = get_double(p + 9 + 16 * i);
+                const uint64_t qty = get_be(p + 17 + 16 * i, 8);
+                if (qty == 0) side.erase(price);
+                else side[price] = qty;
+            }
+        } else if (p[0] == TOB && n >= 37) {
+            tob.bid_price = get_double(p + 1);
+            tob.bid_quantity = get_be(p + 9, 8);
+            tob.ask_price = get_double(p + 17);
+            tob.ask_quantity = get_be(p + 25, 8);
+            tob.instrument_id = static_cast<uint32_t>(get_be(p + 33, 4));
+            have_tob = true;
+        }
+    }
+};
+
+static void feed_recovery(FeedSubscriber& sub, const MulticastPublisher& pub) {
+    std::vector<std::vector<uint8_t>> frames;
+    pub.recover(sub.gap_from, sub.gap_to, frames);
+    for (const auto& f : frames) sub.on_frame(f.data() + 4, f.size() - 4);
+    sub.resume();
+}
+
+// Reference book the publisher is driven from; publish() mirrors each change.
+struct Driver {
+    MulticastPublisher& pub;
+    Levels levels[2];
+    TopOfBook tob;
+
+    void level(uint8_t side, double price, uint64_t qty) {
+        if (qty == 0) levels[side].erase(price);
+        else levels[side][price] = qty;
+
+        ServerMessage sm{};
+        sm.type = DEPTH_UPDATE;
+        sm.depth = DepthUpdate{};
+        sm.depth.instrument_id = DEFAULT_INSTRUMENT_ID;
+        sm.depth.side = side;
+        sm.depth.count = 1;
+        sm.depth.levels[0] = DepthLevel{price, qty};
+        pub.publish(sm, pack_server_message(sm));
+
+        sm = ServerMessage{};
+        sm.type = TOB;
+        sm.tob = TopOfBook{};
+        sm.tob.instrument_id = DEFAULT_INSTRUMENT_ID;
+        if (!levels[0].empty()) {
+            sm.tob.bid_price = levels[0].rbegin()->first;
+            sm.tob.bid_quantity = levels[0].rbegin()->second;
+        }
+        if (!levels[1].empty()) {
+            sm.tob.ask_price = levels[1].begin()->first;
+            sm.tob.ask_quantity = levels[1].begin()->second;
+        }
+        tob = sm.tob;
+        pub.publish(sm, pack_server_message(sm));
+        pub.flush();
+    }
+};
+
+static bool same_book(const FeedSubscriber& sub, const Driver& drv) {
+    return sub.levels[0] == drv.levels[0] && sub.levels[1] == drv.levels[1] && sub.have_tob &&
+           sub.tob.bid_price == drv.tob.bid_price && sub.tob.bid_quantity == drv.tob.bid_quantity &&
+           sub.tob.ask_price == drv.tob.ask_price && sub.tob.ask_quantity == drv.tob.ask_quantity;
+}
+
+// Loopback receiver joined to `group`; QINVALID_SOCKET if multicast is unavailable here.
+static qsocket_t open_receiver(const char* group, int& port) {
+    qsocket_t fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd == QINVALID_SOCKET) return fd;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    ip_mreq mreq{};
+    inet_pton(AF_INET, group, &mreq.imr_multiaddr);
+    inet_pton(AF_INET, "127.0.0.1", &mreq.imr_interface);
+    if (bind(fd, (const sockaddr*)&addr, sizeof(addr)) != 0 ||
+        getsockname(fd, (sockaddr*)&addr, &len) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char*)&mreq, sizeof(mreq)) != 0) {
+        q_close(fd);
+        return QINVALID_SOCKET;
+    }
+    q_set_nonblocking(fd);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// Datagrams that arrive within `wait_ms`.
+static std::vector<std::vector<uint8_t>> receive_all(qsocket_t fd, int wait_ms) {
+    std::vector<std::vector<uint8_t>> out;
+    uint8_t buf[2048];
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        int n = static_cast<int>(recv(fd, (char*)buf, sizeof(buf), 0));
+        if (n > 0) out.emplace_back(buf, buf + n);
+        else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return out;
+}
+
+// Every datagram still in the ring, as an MD_PACKET replay of [from, to]; used as the
+// transport when the host has no multicast loopback.
+static std::vector<std::vector<uint8_t>> replay_all(const MulticastPublisher& pub, uint64_t from) {
+    std::vector<std::vector<uint8_t>> frames, out;
+    pub.recover(from, pub.last_seq(), frames);
+    for (const auto& f : frames)
+        if (f.size() > 5 && f[4] == MD_PACKET) out.emplace_back(f.begin() + 5, f.end());
+    return out;
+}
+
+// Publish, drop one datagram, then rebuild the book from the MD_PACKET replay; then
+// let the gap fall out of the ring and rebuild a late subscriber from the snapshot.
+static void test_gap_recovery() {
+    const char* group = "239.255.42.99";
+    int port = 0;
+    qsocket_t rx = open_receiver(group, port);
+    MulticastPublisher pub(group, port ? port : 30999, "127.0.0.1", 0, /*ring_packets*/ 8);
+    bool loopback = rx != QINVALID_SOCKET && pub.open();
+    Driver drv{pub, {}, {}};
+
+    for (int i = 0; i < 5; ++i) drv.level(0, 100.0 - i, 10 + i);   // 5 datagrams, seq 1..10
+    drv.level(1, 101.0, 7);
+    drv.level(0, 100.0, 0);                                         // seq 13..14
+
+    std::vector<std::vector<uint8_t>> datagrams;
+    if (loopback) datagrams = receive_all(rx, 200);
+    if (datagrams.size() != 7) {
+        std::printf("multicast loopback unavailable (%zu datagrams); replaying from the ring\n",
+                    datagrams.size());
+        loopback = false;
+        datagrams = replay_all(pub, 1);
+    }
+    CHECK(datagrams.size() == 7, "published %zu datagrams", datagrams.size());
+
+    FeedSubscriber sub;
+    for (std::size_t i = 0; i < datagrams.size(); ++i)
+        if (i != 2) sub.on_datagram(datagrams[i].data(), datagrams[i].size());   // drop seq 5..6
+    CHECK(sub.gap && sub.gap_from == 5 && sub.gap_to == 6 && sub.parked.size() == 4,
+          "gap [%llu, %llu], %zu parked", (unsigned long long)sub.gap_from,
+          (unsigned long long)sub.gap_to, sub.parked.size());
+
+    std::vector<std::vector<uint8_t>> frames;
+    pub.recover(sub.gap_from, sub.gap_to, frames);
+    CHECK(frames.size() == 1 && frames[0][4] == MD_PACKET, "replay: %zu frames", frames.size());
+    feed_recovery(sub, pub);
+    CHECK(!sub.gap && sub.next_seq == pub.last_seq() + 1 && same_book(sub, drv),
+          "book after replay: next_seq %llu, %zu bids %zu asks", (unsigned long long)sub.next_seq,
+          sub.levels[0].size(), sub.levels[1].size());
+
+    // 8 more datagrams push seq 1 out of the 7-packet ring.
+    for (int i = 0; i < 8; ++i) drv.level(1, 101.0 + i, 3 + i);
+    FeedSubscriber late;
+    std::vector<std::vector<uint8_t>> tail = loopback ? receive_all(rx, 200) : replay_all(pub, pub.last_seq());
+    CHECK(!tail.empty(), "no live datagram");
+    if (!tail.empty()) late.on_datagram(tail.back().data(), tail.back().size());
+    CHECK(late.gap && late.gap_from == 1, "late gap from %llu", (unsigned long long)late.gap_from);
+
+    frames.clear();
+    pub.recover(late.gap_from, late.gap_to, frames);
+    CHECK(!frames.empty() && frames.back()[4] == SNAPSHOT_END, "snapshot: %zu frames", frames.size());
+    feed_recovery(late, pub);
+    CHECK(!late.gap && late.next_seq == pub.last_seq() + 1 && same_book(late, drv),
+          "book after snapshot: next_seq %llu, %zu bids %zu asks", (unsigned long long)late.next_seq,
+          late.levels[0].size(), late.levels[1].size());
+
+    // Live updates continue from the snapshot's sequence number.
+    drv.level(0, 99.0, 0);
+    std::vector<std::vector<uint8_t>> live = loopback ? receive_all(rx, 200) : replay_all(pub, pub.last_seq());
+    for (const auto& d : live) late.on_datagram(d.data(), d.size());
+    CHECK(!late.gap && same_book(late, drv), "book after live update: %zu bids", late.levels[0].size());
+
+    if (rx != QINVALID_SOCKET) q_close(rx);
+}
+
+int main() {
+#if QPLAT_WINDOWS
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+    test_gap_recovery();
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all feed checks passed\n");
+    return 0;
+}
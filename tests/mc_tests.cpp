@@ -0,0 +1,372 @@
+// Monte Carlo engine checks: prices against Black-Scholes and results that do not
+// depend on the thread count. Exits non-zero if any check fails.
+#include "quant/bs.hpp"
+#include "quant/mc.hpp"
+#include "quant/mc_cache.hpp"
+#include "quant/mc_heston.hpp"
+#include "quant/mc_kernel.hpp"
+#include "quant/mc_lsm.hpp"
+#include "quant/mc_multi.hpp"
+#include "quant/mc_path.hpp"
+#include "quant/rng.hpp"
+#include "quant/thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace quant;
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...)                                                   \
+    do {                                                                   \
+        if (!(cond)) {                                                     \
+            ++g_failures;                                                  \
+            std::printf("FAIL %s:%d: %s: ", __FILE__, __LINE__, #cond);    \
+            std::printf(__VA_ARGS__);                                      \
+            std::printf("\n");                                             \
+        }                                                                  \
+    } while (0)
+
+static const double S0 = 100.0, SIGMA = 0.2, T = 1.0, R = 0.03;
+
+static double bs_price(double K, bool is_call, double sigma = SIGMA) {
+    const BSInputs in{S0, K, R, sigma, T};
+    return is_call ? bs_call(in) : bs_put(in);
+}
+
+static MCOptions base_options() {
+    MCOptions o;
+    o.n_paths = 200000;
+    o.seed = 12345;
+    o.r = R;
+    return o;
+}
+
+// |mc - bs| within 4 standard errors (plus a little slack for the path engines'
+// discretisation and near-zero stderr with the control variate).
+static void check_against_bs(const char* what, const MCResult& res, double bs, double slack) {
+    const double err = std::fabs(res.price - bs);
+    CHECK(res.n_samples > 0, "%s: no samples", what);
+    CHECK(err <= 4.0 * res.stderr_ + slack, "%s: mc %.5f bs %.5f se %.5f", what, res.price, bs,
+          res.stderr_);
+}
+
+static bool same_result(const MCResult& a, const MCResult& b) {
+    return std::memcmp(&a.price, &b.price, sizeof(double)) == 0 &&
+           std::memcmp(&a.stderr_, &b.stderr_, sizeof(double)) == 0 && a.n_samples == b.n_samples;
+}
+
+static void test_terminal_vs_bs() {
+    const double strikes[] = {80.0, 100.0, 120.0};
+    for (double K : strikes) {
+        for (int call = 0; call < 2; ++call) {
+            for (int anti = 0; anti < 2; ++anti) {
+                MCOptions o = base_options();
+                o.use_antithetic = anti != 0;
+                char what[64];
+                std::snprintf(what, sizeof(what), "terminal K=%g call=%d anti=%d", K, call, anti);
+                check_against_bs(what, monte_carlo_terminal(S0, K, SIGMA, T, o, call != 0),
+                                 bs_price(K, call != 0), 1e-3);
+            }
+            MCOptions q = base_options();
+            q.use_qmc = true;
+            q.n_paths = 1 << 16;
+            char what[64];
+            std::snprintf(what, sizeof(what), "terminal qmc K=%g call=%d", K, call);
+            check_against_bs(what, monte_carlo_terminal(S0, K, SIGMA, T, q, call != 0),
+                             bs_price(K, call != 0), 1e-3);
+        }
+    }
+}
+
+// MCPrecision::Single prices the same draws in float: the difference to the double
+// kernel must stay far below the Monte Carlo error.
+static void test_single_precision() {
+    for (double K : {70.0, 90.0, 100.0, 110.0, 140.0}) {
+        for (int call = 0; call < 2; ++call) {
+            for (int anti = 0; anti < 2; ++anti) {
+                MCOptions o = base_options();
+                o.use_antithetic = anti != 0;
+                const MCResult d = monte_carlo_terminal(S0, K, SIGMA, T, o, call != 0);
+                o.precision = MCPrecision::Single;
+                const MCResult f = monte_carlo_terminal(S0, K, SIGMA, T, o, call != 0);
+                CHECK(std::fabs(f.price - d.price) <= 0.05 * d.stderr_,
+                      "f32 K=%g call=%d anti=%d: f32 %.7f f64 %.7f se %.5f", K, call, anti, f.price,
+                      d.price, d.stderr_);
+            }
+        }
+    }
+
+    // float draws are the double draws rounded, odd start and tail included
+    const CounterRNG rng(7);
+    std::vector<double> zd(1001);
+    std::vector<float> zs(1001);
+    rng.normals(3, zd.size(), 1, zd.data());
+    rng.normals(3, zs.size(), 1, zs.data());
+    bool rounded = true;
+    for (std::size_t i = 0; i < zd.size(); ++i) rounded = rounded && zs[i] == static_cast<float>(zd[i]);
+    CHECK(rounded, "float normals differ from rounded double normals");
+}
+
+// sigma = 0 or T = 0: deterministic S_T, intrinsic delta, zero gamma and vega.
+static void test_degenerate_greeks() {
+    MCOptions o = base_options();
+    o.n_paths = 10000;
+    o.compute_greeks = true;
+    const double cases[][2] = {{0.0, T}, {SIGMA, 0.0}};
+    for (const auto& c : cases) {
+        for (int call = 0; call < 2; ++call) {
+            const MCResult res = monte_carlo_terminal(S0, 90.0, c[0], c[1], o, call != 0);
+            const double fwd = S0 * std::exp(R * c[1]);
+            const double intrinsic = std::exp(-R * c[1]) * std::fmax(0.0, call ? fwd - 90.0 : 90.0 - fwd);
+            CHECK(res.has_greeks && std::fabs(res.price - intrinsic) < 1e-9 &&
+                      std::fabs(res.greeks.delta - (call ? 1.0 : 0.0)) < 1e-12 && res.greeks.gamma == 0.0 &&
+                      res.greeks.vega == 0.0,
+                  "sigma=%g T=%g call=%d: price %g delta %g gamma %g vega %g", c[0], c[1], call,
+                  res.price, res.greeks.delta, res.greeks.gamma, res.greeks.vega);
+        }
+    }
+}
+
+// Repeat quotes hit the cache; clock-seeded (seed == 0) quotes always simulate.
+static void test_price_cache() {
+    MCPriceCache cache;
+    MCOptions o = base_options();
+    o.n_paths = 20000;
+    const MCResult a = cache.price(S0, 100.0, SIGMA, T, o, true);
+    const MCResult b = cache.price(S0, 100.0, SIGMA, T, o, true);
+    CHECK(same_result(a, b) && cache.stats().hits == 1, "seeded repeat: hits %llu",
+          static_cast<unsigned long long>(cache.stats().hits));
+
+    o.seed = 0;
+    cache.price(S0, 100.0, SIGMA, T, o, true);
+    cache.price(S0, 100.0, SIGMA, T, o, true);
+    const MCCacheStats st = cache.stats();
+    CHECK(st.hits == 1 && st.path_hits == 0 && st.misses == 3, "seed 0: hits %llu path_hits %llu misses %llu",
+          static_cast<unsigned long long>(st.hits), static_cast<unsigned long long>(st.path_hits),
+          static_cast<unsigned long long>(st.misses));
+}
+
+static void test_strip_vs_bs() {
+    std::vector<MCStripOption> strip;
+    for (double K : {90.0, 100.0, 110.0}) {
+        strip.push_back({K, T, true});
+        strip.push_back({K, T, false});
+    }
+    const std::vector<MCResult> res = monte_carlo_strip(S0, SIGMA, strip, base_options());
+    CHECK(res.size() == strip.size(), "strip size %zu", res.size());
+    for (std::size_t i = 0; i < res.size() && i < strip.size(); ++i) {
+        check_against_bs("strip", res[i], bs_price(strip[i].K, strip[i].is_call), 1e-3);
+    }
+}
+
+static void test_path_vs_bs() {
+    MCOptions o = base_options();
+    o.n_paths = 50000;
+    PathMCOptions po;
+    po.n_steps = 16;
+    for (int call = 0; call < 2; ++call) {
+        check_against_bs("path european", monte_carlo_path(S0, SIGMA, T, european_option(100.0, call != 0), o, po),
+                         bs_price(100.0, call != 0), 1e-2);
+    }
+}
+
+static void test_heston_vs_bs() {
+    // xi = 0 and theta = v0: deterministic variance, i.e. Black-Scholes at sqrt(v0).
+    HestonParams hp;
+    hp.v0 = SIGMA * SIGMA;
+    hp.theta = hp.v0;
+    hp.xi = 0.0;
+    MCOptions o = base_options();
+    o.n_paths = 50000;
+    PathMCOptions po;
+    po.n_steps = 50;
+    for (int call = 0; call < 2; ++call) {
+        check_against_bs("heston xi=0", monte_carlo_heston(S0, T, hp, european_option(100.0, call != 0), o, po),
+                         bs_price(100.0, call != 0), 1e-2);
+    }
+}
+
+// heston_qe_block (SIMD) against HestonQEStep::step over a few steps, down to xi ~ 0
+// where psi falls below the vector clamp.
+static void test_heston_block_vs_scalar() {
+    const double xis[] = {0.5, 0.05, 1e-4, 1e-6, 1e-8, 0.0};
+    const std::size_t n = 203;   // not a multiple of the lane count
+    const CounterRNG rng(7);
+    for (double xi : xis) {
+        HestonParams hp;
+        hp.xi = xi;
+        const HestonQEStep qe(hp, R, 1.0 / 252.0);
+        std::vector<double> x(n, 0.0), v(n, hp.v0), xs(n, 0.0), vs(n, hp.v0);
+        std::vector<double> zv(n), z(n), scratch(n);
+        for (uint32_t k = 0; k < 20; ++k) {
+            const double sign = (k & 1) ? -1.0 : 1.0;
+            rng.normals(0, n, 2 * k, zv.data());
+            rng.normals(0, n, 2 * k + 1, z.data());
+            heston_qe_block(qe, x.data(), v.data(), zv.data(), z.data(), n, sign, scratch.data());
+            for (std::size_t i = 0; i < n; ++i) qe.step(xs[i], vs[i], sign * zv[i], sign * z[i]);
+        }
+        double dx = 0.0, dv = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            dx = std::fmax(dx, std::fabs(x[i] - xs[i]));
+            dv = std::fmax(dv, std::fabs(v[i] - vs[i]));
+        }
+        // rounding in v reaches ln S through k1, k2 ~ rho / xi
+        const double dx_tol = 1e-9 + 1e-14 * (xi > 0.0 ? std::fabs(hp.rho) / xi : 0.0);
+        CHECK(dx <= dx_tol && dv <= 1e-12, "heston block xi=%g: |dx| %g |dv| %g", xi, dx, dv);
+    }
+
+    // Near-zero vol of variance with theta = v0 is Black-Scholes at sqrt(v0).
+    for (double xi : {1e-6, 1e-8}) {
+        HestonParams hp;
+        hp.v0 = SIGMA * SIGMA;
+        hp.theta = hp.v0;
+        hp.xi = xi;
+        MCOptions o = base_options();
+        o.n_paths = 50000;
+        for (std::size_t steps : {50, 252}) {
+            PathMCOptions po;
+            po.n_steps = steps;
+            char what[64];
+            std::snprintf(what, sizeof(what), "heston xi=%g steps=%zu", xi, steps);
+            check_against_bs(what, monte_carlo_heston(S0, T, hp, european_option(100.0, true), o, po),
+                             bs_price(100.0, true), 1e-2);
+        }
+    }
+}
+
+static void test_american_put_bounds() {
+    // American put is worth at least the European and at most the strike.
+    MCOptions o = base_options();
+    o.n_paths = 50000;
+    const MCResult am = monte_carlo_american(S0, 100.0, SIGMA, T, o, false);
+    const double eu = bs_price(100.0, false);
+    CHECK(am.price >= eu - 4.0 * am.stderr_, "american put %.5f < european %.5f", am.price, eu);
+    CHECK(am.price < 100.0, "american put %.5f", am.price);
+}
+
+// n_threads == 1 against the global pool: bit-identical for a fixed seed (see MCOptions).
+static void test_thread_invariance() {
+    MCOptions pool = base_options();
+    pool.n_paths = 100000;
+    MCOptions single = pool;
+    single.n_threads = 1;
+
+    for (int qmc = 0; qmc < 2; ++qmc) {
+        pool.use_qmc = single.use_qmc = qmc != 0;
+        CHECK(same_result(monte_carlo_terminal(S0, 100.0, SIGMA, T, pool, true),
+                          monte_carlo_terminal(S0, 100.0, SIGMA, T, single, true)),
+              "terminal qmc=%d", qmc);
+    }
+    pool.use_qmc = single.use_qmc = false;
+
+    pool.compute_greeks = single.compute_greeks = true;
+    {
+        const MCResult a = monte_carlo_terminal(S0, 100.0, SIGMA, T, pool, true);
+        const MCResult b = monte_carlo_terminal(S0, 100.0, SIGMA, T, single, true);
+        CHECK(same_result(a, b) && a.greeks.delta == b.greeks.delta && a.greeks.gamma == b.greeks.gamma,
+              "terminal greeks");
+    }
+    pool.compute_greeks = single.compute_greeks = false;
+
+    pool.target_stderr = single.target_stderr = 0.02;
+    CHECK(same_result(monte_carlo_terminal(S0, 100.0, SIGMA, T, pool, false),
+                      monte_carlo_terminal(S0, 100.0, SIGMA, T, single, false)),
+          "terminal adaptive");
+    pool.target_stderr = single.target_stderr = 0.0;
+
+    pool.precision = single.precision = MCPrecision::Single;
+    CHECK(same_result(monte_carlo_terminal(S0, 100.0, SIGMA, T, pool, true),
+                      monte_carlo_terminal(S0, 100.0, SIGMA, T, single, true)),
+          "terminal f32");
+    pool.precision = single.precision = MCPrecision::Double;
+
+    PathMCOptions po;
+    po.n_steps = 20;
+    const PathPayoff barrier = barrier_option(100.0, 120.0, BarrierKind::UpAndOut, true);
+    CHECK(same_result(monte_carlo_path(S0, SIGMA, T, barrier, pool, po),
+                      monte_carlo_path(S0, SIGMA, T, barrier, single, po)),
+          "path barrier");
+
+    HestonParams hp;
+    CHECK(same_result(monte_carlo_heston(S0, T, hp, european_option(100.0, true), pool, po),
+                      monte_carlo_heston(S0, T, hp, european_option(100.0, true), single, po)),
+          "heston");
+
+    MultiAssetModel mm;
+    mm.S0 = {100.0, 90.0};
+    mm.sigma = {0.2, 0.3};
+    mm.correlation = {1.0, 0.5, 0.5, 1.0};
+    const MultiAssetPayoff basket = basket_option({0.5, 0.5}, 95.0, true);
+    CHECK(same_result(monte_carlo_multi(mm, T, basket, pool), monte_carlo_multi(mm, T, basket, single)),
+          "multi basket");
+
+    pool.n_paths = single.n_paths = 20000;
+    CHECK(same_result(monte_carlo_american(S0, 100.0, SIGMA, T, pool, false),
+                      monte_carlo_american(S0, 100.0, SIGMA, T, single, false)),
+          "american");
+}
+
+// n_threads = k caps the chunks in flight; any cap prices the same bits.
+static void test_thread_cap() {
+    for (std::size_t cap : {std::size_t(1), std::size_t(2), std::size_t(0)}) {
+        MCOptions o = base_options();
+        o.n_threads = cap;
+        std::atomic<int> in_flight{0}, peak{0};
+        std::vector<int> seen(64, 0);
+        mc_for_each_chunk(seen.size(), o, [&](std::size_t c) {
+            const int now = ++in_flight;
+            for (int p = peak; now > p && !peak.compare_exchange_weak(p, now);) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            ++seen[c];
+            --in_flight;
+        });
+        bool once = true;
+        for (int k : seen) once = once && k == 1;
+        CHECK(once, "cap %zu: chunk skipped or repeated", cap);
+        CHECK(cap == 0 ? peak <= 4 : peak <= static_cast<int>(cap), "cap %zu: %d chunks in flight", cap,
+              peak.load());
+    }
+
+    MCOptions two = base_options();
+    two.n_paths = 100000;
+    MCOptions one = two;
+    two.n_threads = 2;
+    one.n_threads = 1;
+    CHECK(same_result(monte_carlo_terminal(S0, 100.0, SIGMA, T, two, true),
+                      monte_carlo_terminal(S0, 100.0, SIGMA, T, one, true)),
+          "terminal n_threads=2");
+    two.n_paths = one.n_paths = 20000;
+    CHECK(same_result(monte_carlo_american(S0, 100.0, SIGMA, T, two, false),
+                      monte_carlo_american(S0, 100.0, SIGMA, T, one, false)),
+          "american n_threads=2");
+}
+
+int main() {
+    // A few workers even on small machines, so the pool path really runs in parallel.
+    ThreadPool::configure_global(3, false);
+
+    test_terminal_vs_bs();
+    test_single_precision();
+    test_degenerate_greeks();
+    test_price_cache();
+    test_strip_vs_bs();
+    test_path_vs_bs();
+    test_heston_vs_bs();
+    test_heston_block_vs_scalar();
+    test_american_put_bounds();
+    test_thread_invariance();
+    test_thread_cap();
+
+    if (g_failures) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all MC checks passed (kernel: %s)\n", terminal_kernel_isa());
+    return 0;
+}
@@ -9,6 +9,9 @@ import {
 } from "recharts";
 import "./App.css";
 
+// Instrument shown in the book, chart and trade tape (the simulated underlying).
+const BOOK_INSTRUMENT = 1;
+
 function App() {
   const [connected, setConnected] = useState(false);
   const [ws, setWs] = useState(null);
@@ -37,6 +40,7 @@ function App() {
     position: 0,
     avg_price: 0,
     equity: 0,
+    byInstrument: {},
   });
 
   // NEW: BS bot PnL
@@ -46,6 +50,7 @@ function App() {
     position: 0,
     avg_price: 0,
     equity: 0,
+    byInstrument: {},
   });
 
   // --- WebSocket setup ---
@@ -83,24 +88,45 @@ function App() {
     return { label: `USER-${id}`, kind: "user" };
   }
 
-  // helper to merge PnL updates safely
+  // helper to merge per-instrument PnL updates safely; realized/unrealized/equity are
+  // summed over instruments, position/avg price are those of the displayed book
   function applyPnlUpdate(prev, msg) {
+    const instr = msg.instrument_id ?? BOOK_INSTRUMENT;
+    const old = prev.byInstrument[instr] ?? {};
+    const pick = (k) => (typeof msg[k] === "number" ? msg[k] : old[k] ?? 0);
+    const byInstrument = {
+      ...prev.byInstrument,
+      [instr]: {
+        realized: pick("realized"),
+        unrealized: pick("unrealized"),
+        position: pick("position"),
+        avg_price: pick("avg_price"),
+        equity: pick("equity"),
+      },
+    };
+    const rows = Object.values(byInstrument);
+    const sum = (k) => rows.reduce((acc, r) => acc + r[k], 0);
+    const book = byInstrument[BOOK_INSTRUMENT] ?? {};
     return {
-      realized:
-        typeof msg.realized === "number" ? msg.realized : prev.realized,
-      unrealized:
-        typeof msg.unrealized === "number" ? msg.unrealized : prev.unrealized,
-      position:
-        typeof msg.position === "number" ? msg.position : prev.position,
-      avg_price:
-        typeof msg.avg_price === "number" ? msg.avg_price : prev.avg_price,
-      equity:
-        typeof msg.equity === "number" ? msg.equity : prev.equity,
+      realized: sum("realized"),
+      unrealized: sum("unrealized"),
+      position: book.position ?? 0,
+      avg_price: book.avg_price ?? 0,
+      equity: sum("equity"),
+      byInstrument,
     };
   }
 
   // --- Message handling from backend ---
   function handleServerMessage(msg) {
+    // Book, chart and tape show one instrument; PnL covers all of them.
+    if (
+      (msg.type === "tob" || msg.type === "depth" || msg.type === "trade") &&
+      (msg.instrument_id ?? BOOK_INSTRUMENT) !== BOOK_INSTRUMENT
+    ) {
+      return;
+    }
+
     if (msg.type === "tob") {
       setTob({
         bidPrice: msg.bidPrice,
@@ -118,6 +144,17 @@ function App() {
       }
     }
 
+    else if (msg.type === "depth") {
+      const isBid = msg.side === 0;
+      const apply = (prev) =>
+        msg.levels.reduce(
+          (acc, lvl) => updateBookSide(acc, lvl.price, lvl.quantity, isBid),
+          msg.snapshot ? [] : prev
+        );
+      if (isBid) setBids(apply);
+      else setAsks(apply);
+    }
+
     else if (msg.type === "trade") {
       const buyer = classify(msg.buy_user_id);
       const seller = classify(msg.sell_user_id);
@@ -199,6 +236,7 @@ function App() {
       JSON.stringify({
         type: "new_order",
         user_id: 1,
+        instrument_id: BOOK_INSTRUMENT,
         side: formSide,
         price: parseFloat(formPrice),
         quantity: parseInt(formQty, 10),